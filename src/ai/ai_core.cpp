@@ -21,6 +21,7 @@
 #include "ai_config.hpp"
 #include "ai_info.hpp"
 #include "ai.hpp"
+#include "../tick_profiler.h"
 
 /* static */ uint AI::frame_counter = 0;
 /* static */ AIScannerInfo *AI::scanner_info = NULL;
@@ -65,6 +66,8 @@
 
 /* static */ void AI::GameLoop()
 {
+	TickPhaseTimer timer(TPH_AI);
+
 	/* If we are in networking, only servers run this function, and that only if it is allowed */
 	if (_networking && (!_network_server || !_settings_game.ai.ai_in_multiplayer)) return;
 
@@ -77,6 +80,7 @@
 	const Company *c;
 	FOR_ALL_COMPANIES(c) {
 		if (c->is_ai) {
+			TickCompanyTimer company_timer(c->index);
 			cur_company.Change(c->index);
 			c->ai_instance->GameLoop();
 		}
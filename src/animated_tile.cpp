@@ -13,6 +13,7 @@
 #include "core/alloc_func.hpp"
 #include "tile_cmd.h"
 #include "viewport_func.h"
+#include "tick_profiler.h"
 
 /** The table/list with animated tiles. */
 TileIndex *_animated_tile_list = NULL;
@@ -69,6 +70,8 @@ void AddAnimatedTile(TileIndex tile)
  */
 void AnimateAnimatedTiles()
 {
+	TickPhaseTimer timer(TPH_ANIMATION);
+
 	const TileIndex *ti = _animated_tile_list;
 	while (ti < _animated_tile_list + _animated_tile_count) {
 		const TileIndex curr = *ti;
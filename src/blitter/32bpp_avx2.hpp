@@ -0,0 +1,58 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file 32bpp_avx2.hpp AVX2 32 bpp blitters. */
+
+#ifndef BLITTER_32BPP_AVX2_HPP
+#define BLITTER_32BPP_AVX2_HPP
+
+#include "32bpp_sse_type.h"
+
+#ifdef WITH_AVX2
+
+#include "32bpp_anim.hpp"
+#include "../cpu.h"
+
+/** The optimised 32 bpp blitter using AVX2 to draw several pixels at once (without palette animation). */
+class Blitter_32bppAVX2 : public Blitter_32bppOptimized {
+public:
+	/* virtual */ void Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom);
+
+	/* virtual */ const char *GetName() { return "32bpp-avx2"; }
+};
+
+/** Factory for the AVX2 32 bpp blitter (without palette animation). */
+class FBlitter_32bppAVX2: public BlitterFactory<FBlitter_32bppAVX2> {
+public:
+	/* virtual */ const char *GetName() { return "32bpp-avx2"; }
+	/* virtual */ const char *GetDescription() { return "32bpp AVX2 Blitter (no palette animation)"; }
+	/* virtual */ Blitter *CreateInstance() { return new Blitter_32bppAVX2(); }
+	/* virtual */ bool IsUsable() { return HasCPUIDFlag(7, 1, 5) && HasOSAVXSupport(); }
+};
+
+/** The optimised 32 bpp blitter with palette animation using AVX2 to draw several pixels at once. */
+class Blitter_32bppAVX2Anim FINAL : public Blitter_32bppAnim {
+public:
+	/* virtual */ void Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom);
+
+	/* virtual */ const char *GetName() { return "32bpp-avx2-anim"; }
+};
+
+/** Factory for the AVX2 32 bpp blitter with palette animation. */
+class FBlitter_32bppAVX2Anim: public BlitterFactory<FBlitter_32bppAVX2Anim> {
+public:
+	/* virtual */ const char *GetName() { return "32bpp-avx2-anim"; }
+	/* virtual */ const char *GetDescription() { return "32bpp AVX2 Animation Blitter (palette animation)"; }
+	/* virtual */ Blitter *CreateInstance() { return new Blitter_32bppAVX2Anim(); }
+	/* virtual */ bool IsUsable() { return HasCPUIDFlag(7, 1, 5) && HasOSAVXSupport(); }
+};
+
+#endif /* WITH_AVX2 */
+
+#endif /* BLITTER_32BPP_AVX2_HPP */
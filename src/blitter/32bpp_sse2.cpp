@@ -0,0 +1,30 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file 32bpp_sse2.cpp Implementation of the SSE2 32 bpp blitters. */
+
+#include "../stdafx.h"
+#include "32bpp_sse2.hpp"
+
+#ifdef WITH_SSE
+
+#include <emmintrin.h>
+
+/** Instantiation of the SSE2 32bpp blitter factory. */
+static FBlitter_32bppSSE2 iFBlitter_32bppSSE2;
+/** Instantiation of the SSE2 32bpp with animation blitter factory. */
+static FBlitter_32bppSSE2Anim iFBlitter_32bppSSE2Anim;
+
+#define SSE_VERSION 2
+#define SSE_TARGET SSE2_TARGET
+#define SSE_BLITTER Blitter_32bppSSE2
+#define SSE_ANIM_BLITTER Blitter_32bppSSE2Anim
+#include "32bpp_sse_func.hpp"
+
+#endif /* WITH_SSE */
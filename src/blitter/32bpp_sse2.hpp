@@ -0,0 +1,58 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file 32bpp_sse2.hpp SSE2 32 bpp blitters. */
+
+#ifndef BLITTER_32BPP_SSE2_HPP
+#define BLITTER_32BPP_SSE2_HPP
+
+#include "32bpp_sse_type.h"
+
+#ifdef WITH_SSE
+
+#include "32bpp_anim.hpp"
+#include "../cpu.h"
+
+/** The optimised 32 bpp blitter using SSE2 to draw several pixels at once (without palette animation). */
+class Blitter_32bppSSE2 : public Blitter_32bppOptimized {
+public:
+	/* virtual */ void Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom);
+
+	/* virtual */ const char *GetName() { return "32bpp-sse2"; }
+};
+
+/** Factory for the SSE2 32 bpp blitter (without palette animation). */
+class FBlitter_32bppSSE2: public BlitterFactory<FBlitter_32bppSSE2> {
+public:
+	/* virtual */ const char *GetName() { return "32bpp-sse2"; }
+	/* virtual */ const char *GetDescription() { return "32bpp SSE2 Blitter (no palette animation)"; }
+	/* virtual */ Blitter *CreateInstance() { return new Blitter_32bppSSE2(); }
+	/* virtual */ bool IsUsable() { return HasCPUIDFlag(1, 3, 26); }
+};
+
+/** The optimised 32 bpp blitter with palette animation using SSE2 to draw several pixels at once. */
+class Blitter_32bppSSE2Anim FINAL : public Blitter_32bppAnim {
+public:
+	/* virtual */ void Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom);
+
+	/* virtual */ const char *GetName() { return "32bpp-sse2-anim"; }
+};
+
+/** Factory for the SSE2 32 bpp blitter with palette animation. */
+class FBlitter_32bppSSE2Anim: public BlitterFactory<FBlitter_32bppSSE2Anim> {
+public:
+	/* virtual */ const char *GetName() { return "32bpp-sse2-anim"; }
+	/* virtual */ const char *GetDescription() { return "32bpp SSE2 Animation Blitter (palette animation)"; }
+	/* virtual */ Blitter *CreateInstance() { return new Blitter_32bppSSE2Anim(); }
+	/* virtual */ bool IsUsable() { return HasCPUIDFlag(1, 3, 26); }
+};
+
+#endif /* WITH_SSE */
+
+#endif /* BLITTER_32BPP_SSE2_HPP */
@@ -0,0 +1,725 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file 32bpp_sse_func.hpp Drawing functions of the SSE 32 bpp blitters.
+ *
+ * Every SSE blitter includes this file once, after including the intrinsics
+ * it needs and defining:
+ *  - SSE_VERSION: 2 for SSE2, 3 for SSSE3 and 4 for SSE4.1;
+ *  - SSE_AVX2: when runs are also drawn eight pixels at a time with AVX2;
+ *  - SSE_TARGET: the attribute that allows these instructions in a function;
+ *  - SSE_BLITTER and SSE_ANIM_BLITTER: the blitter classes to implement.
+ * All functions are static, so each blitter gets its own copy compiled for
+ * its instruction set. Hence this file has no include guard.
+ *
+ * Runs of pixels are drawn several at a time; the pixels that remain are
+ * drawn one by one. The results are exactly the same as those of the
+ * functions of Blitter_32bppBase used by the other 32 bpp blitters.
+ */
+
+#include "../core/mem_func.hpp"
+#include "../gfx_func.h"
+
+/**
+ * Get the alpha channel of four pixels.
+ * @return The mask.
+ */
+static inline SSE_TARGET __m128i AlphaMask()
+{
+	return _mm_set1_epi32((int)0xFF000000);
+}
+
+/**
+ * Extend the channels of the lower two of four pixels to 16 bits each.
+ * @param v The pixels.
+ * @return The unpacked pixels.
+ */
+static inline SSE_TARGET __m128i UnpackLow(__m128i v)
+{
+#if SSE_VERSION >= 4
+	return _mm_cvtepu8_epi16(v);
+#else
+	return _mm_unpacklo_epi8(v, _mm_setzero_si128());
+#endif
+}
+
+/**
+ * Extend the channels of the upper two of four pixels to 16 bits each.
+ * @param v The pixels.
+ * @return The unpacked pixels.
+ */
+static inline SSE_TARGET __m128i UnpackHigh(__m128i v)
+{
+	return _mm_unpackhi_epi8(v, _mm_setzero_si128());
+}
+
+/**
+ * Copy the alpha channel of two unpacked pixels to all their channels.
+ * @param v The pixels.
+ * @return The alpha values.
+ */
+static inline SSE_TARGET __m128i BroadcastAlpha(__m128i v)
+{
+#if SSE_VERSION >= 3
+	return _mm_shuffle_epi8(v, _mm_set_epi8(15, 14, 15, 14, 15, 14, 15, 14, 7, 6, 7, 6, 7, 6, 7, 6));
+#else
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+#endif
+}
+
+/**
+ * Blend two pixels onto two other pixels, like Blitter_32bppBase::ComposeColourRGBANoCheck.
+ * The channels are unpacked to 16 bits each.
+ * @param src The pixels to draw.
+ * @param dst The pixels to draw on.
+ * @return The blended pixels; the alpha channels have to be set afterwards.
+ */
+static inline SSE_TARGET __m128i BlendTwoPixels(__m128i src, __m128i dst)
+{
+	__m128i alpha = BroadcastAlpha(src);
+	/* (src - dst) * alpha / 256 + dst rounds down, so it equals
+	 * (src * alpha + dst * (256 - alpha)) / 256, which fits in 16 bits. */
+	__m128i src_part = _mm_mullo_epi16(src, alpha);
+	__m128i dst_part = _mm_mullo_epi16(dst, _mm_sub_epi16(_mm_set1_epi16(256), alpha));
+	return _mm_srli_epi16(_mm_add_epi16(src_part, dst_part), 8);
+}
+
+/**
+ * Blend four pixels onto four other pixels.
+ * @param src The pixels to draw.
+ * @param dst The pixels to draw on.
+ * @return The blended pixels.
+ */
+static inline SSE_TARGET __m128i BlendFourPixels(__m128i src, __m128i dst)
+{
+	__m128i lo = BlendTwoPixels(UnpackLow(src), UnpackLow(dst));
+	__m128i hi = BlendTwoPixels(UnpackHigh(src), UnpackHigh(dst));
+	return _mm_or_si128(_mm_packus_epi16(lo, hi), AlphaMask());
+}
+
+/**
+ * Darken four pixels by 3/4, like Blitter_32bppBase::MakeTransparent.
+ * @param dst The pixels to darken.
+ * @return The darkened pixels.
+ */
+static inline SSE_TARGET __m128i DarkenFourPixels(__m128i dst)
+{
+	__m128i lo = UnpackLow(dst);
+	__m128i hi = UnpackHigh(dst);
+	lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_add_epi16(lo, lo)), 2);
+	hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_add_epi16(hi, hi)), 2);
+	return _mm_or_si128(_mm_packus_epi16(lo, hi), AlphaMask());
+}
+
+/**
+ * Darken two pixels by the alpha channel of two pixels of a semi-transparent
+ * sprite, i.e. by (1024 - alpha) / 1024. The channels are unpacked to 16 bits each.
+ * @param src The pixels of the sprite.
+ * @param dst The pixels to darken.
+ * @return The darkened pixels; the alpha channels have to be set afterwards.
+ */
+static inline SSE_TARGET __m128i DarkenTwoPixelsByAlpha(__m128i src, __m128i dst)
+{
+	__m128i factor = _mm_sub_epi16(_mm_set1_epi16(1024), BroadcastAlpha(src));
+	/* (c * 64 * factor) >> 16 == (c * factor) >> 10, without overflowing 16 bits. */
+	return _mm_mulhi_epu16(_mm_slli_epi16(dst, 6), factor);
+}
+
+/**
+ * Darken four pixels by the alpha channel of four pixels of a semi-transparent sprite.
+ * @param src The pixels of the sprite.
+ * @param dst The pixels to darken.
+ * @return The darkened pixels.
+ */
+static inline SSE_TARGET __m128i DarkenFourPixelsByAlpha(__m128i src, __m128i dst)
+{
+	__m128i lo = DarkenTwoPixelsByAlpha(UnpackLow(src), UnpackLow(dst));
+	__m128i hi = DarkenTwoPixelsByAlpha(UnpackHigh(src), UnpackHigh(dst));
+	return _mm_or_si128(_mm_packus_epi16(lo, hi), AlphaMask());
+}
+
+/**
+ * Adjust the brightness of two pixels, like Blitter_32bppBase::AdjustBrightness.
+ * The channels are unpacked to 16 bits each.
+ * @param colour     The pixels.
+ * @param brightness The brightness of each pixel, in all its channels.
+ * @return The adjusted pixels; the alpha channels have to be set afterwards.
+ */
+static inline SSE_TARGET __m128i AdjustBrightnessTwo(__m128i colour, __m128i brightness)
+{
+	/* Both are at most 255, so the product fits in 16 bits. */
+	__m128i c = _mm_srli_epi16(_mm_mullo_epi16(colour, brightness), 7);
+
+	/* Sum the overbright of the colour channels into every channel, then halve it. */
+	__m128i ob = _mm_and_si128(_mm_subs_epu16(c, _mm_set1_epi16(255)), _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1));
+	ob = _mm_add_epi16(ob, _mm_shufflehi_epi16(_mm_shufflelo_epi16(ob, _MM_SHUFFLE(1, 0, 3, 2)), _MM_SHUFFLE(1, 0, 3, 2)));
+	ob = _mm_add_epi16(ob, _mm_shufflehi_epi16(_mm_shufflelo_epi16(ob, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1)));
+	ob = _mm_srli_epi16(ob, 1);
+
+	/* Spread it over the channels below 255; ob * (255 - c) needs 17 bits, hence the high half too.
+	 * Channels of 255 or more get nothing added, and end up at 255 as well. */
+	__m128i room = _mm_subs_epu16(_mm_set1_epi16(255), c);
+	__m128i extra = _mm_or_si128(_mm_srli_epi16(_mm_mullo_epi16(ob, room), 8), _mm_slli_epi16(_mm_mulhi_epu16(ob, room), 8));
+	return _mm_min_epi16(_mm_add_epi16(c, extra), _mm_set1_epi16(255));
+}
+
+/**
+ * Adjust the brightness of four pixels by the brightness in their 'm' channels.
+ * @param colour The pixels.
+ * @param m      The 'm' channels of the pixels.
+ * @return The adjusted pixels, with their alpha channels unchanged.
+ */
+static inline SSE_TARGET __m128i AdjustBrightnessFour(__m128i colour, __m128i m)
+{
+	__m128i b = _mm_srli_epi16(m, 8);
+	b = _mm_unpacklo_epi16(b, b);
+	__m128i lo = AdjustBrightnessTwo(UnpackLow(colour), _mm_unpacklo_epi32(b, b));
+	__m128i hi = AdjustBrightnessTwo(UnpackHigh(colour), _mm_unpackhi_epi32(b, b));
+	return _mm_or_si128(_mm_andnot_si128(AlphaMask(), _mm_packus_epi16(lo, hi)), _mm_and_si128(AlphaMask(), colour));
+}
+
+/**
+ * Choose between the pixels of two sets of four pixels.
+ * @param mask All bits set for the pixels to take from \a a, no bits for those from \a b.
+ * @param a The first pixels.
+ * @param b The second pixels.
+ * @return The chosen pixels.
+ */
+static inline SSE_TARGET __m128i SelectPixels(__m128i mask, __m128i a, __m128i b)
+{
+#if SSE_VERSION >= 4
+	return _mm_blendv_epi8(b, a, mask);
+#else
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+#endif
+}
+
+/**
+ * Check whether any of four pixels has a non-zero 'm' channel.
+ * @param src_n The 'm' channels of the pixels.
+ * @return True iff a pixel has to be remapped.
+ */
+static inline SSE_TARGET bool HasRemappedPixels(const uint16 *src_n)
+{
+	__m128i m = _mm_loadl_epi64((const __m128i *)src_n);
+#if SSE_VERSION >= 4
+	return !_mm_testz_si128(m, m);
+#else
+	return _mm_movemask_epi8(_mm_cmpeq_epi16(m, _mm_setzero_si128())) != 0xFFFF;
+#endif
+}
+
+/**
+ * Check whether any of four pixels uses an animated palette colour.
+ * @param src_n The 'm' channels of the pixels.
+ * @return True iff a pixel has to be drawn via the palette.
+ */
+static inline SSE_TARGET bool HasAnimatedColours(const uint16 *src_n)
+{
+	__m128i m = _mm_and_si128(_mm_loadl_epi64((const __m128i *)src_n), _mm_set1_epi16(0xFF));
+	return _mm_movemask_epi8(_mm_cmpgt_epi16(m, _mm_set1_epi16(PALETTE_ANIM_START - 1))) != 0;
+}
+
+#ifdef SSE_AVX2
+/**
+ * Blend eight pixels onto eight other pixels.
+ * @param src The pixels to draw.
+ * @param dst The pixels to draw on.
+ * @return The blended pixels.
+ */
+static inline SSE_TARGET __m256i BlendEightPixels(__m256i src, __m256i dst)
+{
+	/* Unpacking and packing work within each half, so the pixels stay in order. */
+	__m256i zero = _mm256_setzero_si256();
+	__m256i shuffle = _mm256_set_epi8(
+			15, 14, 15, 14, 15, 14, 15, 14, 7, 6, 7, 6, 7, 6, 7, 6,
+			15, 14, 15, 14, 15, 14, 15, 14, 7, 6, 7, 6, 7, 6, 7, 6);
+	__m256i s_lo = _mm256_unpacklo_epi8(src, zero);
+	__m256i s_hi = _mm256_unpackhi_epi8(src, zero);
+	__m256i a_lo = _mm256_shuffle_epi8(s_lo, shuffle);
+	__m256i a_hi = _mm256_shuffle_epi8(s_hi, shuffle);
+	__m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(s_lo, a_lo), _mm256_mullo_epi16(_mm256_unpacklo_epi8(dst, zero), _mm256_sub_epi16(_mm256_set1_epi16(256), a_lo)));
+	__m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(s_hi, a_hi), _mm256_mullo_epi16(_mm256_unpackhi_epi8(dst, zero), _mm256_sub_epi16(_mm256_set1_epi16(256), a_hi)));
+	__m256i res = _mm256_packus_epi16(_mm256_srli_epi16(lo, 8), _mm256_srli_epi16(hi, 8));
+	return _mm256_or_si256(res, _mm256_set1_epi32((int)0xFF000000));
+}
+
+/**
+ * Darken eight pixels by 3/4, like Blitter_32bppBase::MakeTransparent.
+ * @param dst The pixels to darken.
+ * @return The darkened pixels.
+ */
+static inline SSE_TARGET __m256i DarkenEightPixels(__m256i dst)
+{
+	__m256i zero = _mm256_setzero_si256();
+	__m256i lo = _mm256_unpacklo_epi8(dst, zero);
+	__m256i hi = _mm256_unpackhi_epi8(dst, zero);
+	lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_add_epi16(lo, lo)), 2);
+	hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_add_epi16(hi, hi)), 2);
+	return _mm256_or_si256(_mm256_packus_epi16(lo, hi), _mm256_set1_epi32((int)0xFF000000));
+}
+
+/**
+ * Check whether any of eight pixels uses an animated palette colour.
+ * @param src_n The 'm' channels of the pixels.
+ * @return True iff a pixel has to be drawn via the palette.
+ */
+static inline SSE_TARGET bool HasAnimatedColoursEight(const uint16 *src_n)
+{
+	__m128i m = _mm_and_si128(_mm_loadu_si128((const __m128i *)src_n), _mm_set1_epi16(0xFF));
+	return _mm_movemask_epi8(_mm_cmpgt_epi16(m, _mm_set1_epi16(PALETTE_ANIM_START - 1))) != 0;
+}
+#endif /* SSE_AVX2 */
+
+/**
+ * Copy a run of opaque pixels.
+ * @param dst Where to draw.
+ * @param src The pixels to draw.
+ * @param n   Number of pixels.
+ */
+static inline SSE_TARGET void CopyRun(Colour *dst, const Colour *src, uint n)
+{
+#ifdef SSE_AVX2
+	for (; n >= 8; n -= 8, dst += 8, src += 8) {
+		_mm256_storeu_si256((__m256i *)dst, _mm256_loadu_si256((const __m256i *)src));
+	}
+#endif
+	for (; n >= 4; n -= 4, dst += 4, src += 4) {
+		_mm_storeu_si128((__m128i *)dst, _mm_loadu_si128((const __m128i *)src));
+	}
+	for (; n != 0; n--) *dst++ = *src++;
+}
+
+/**
+ * Blend a run of semi-transparent pixels.
+ * @param dst Where to draw.
+ * @param src The pixels to draw.
+ * @param n   Number of pixels.
+ */
+static inline SSE_TARGET void BlendRun(Colour *dst, const Colour *src, uint n)
+{
+#ifdef SSE_AVX2
+	for (; n >= 8; n -= 8, dst += 8, src += 8) {
+		__m256i d = _mm256_loadu_si256((const __m256i *)dst);
+		_mm256_storeu_si256((__m256i *)dst, BlendEightPixels(_mm256_loadu_si256((const __m256i *)src), d));
+	}
+#endif
+	for (; n >= 4; n -= 4, dst += 4, src += 4) {
+		__m128i d = _mm_loadu_si128((const __m128i *)dst);
+		_mm_storeu_si128((__m128i *)dst, BlendFourPixels(_mm_loadu_si128((const __m128i *)src), d));
+	}
+	for (; n != 0; n--, dst++, src++) {
+		*dst = Blitter_32bppBase::ComposeColourRGBANoCheck(src->r, src->g, src->b, src->a, *dst);
+	}
+}
+
+/**
+ * Darken a run of pixels for an opaque transparent sprite, like
+ * Blitter_32bppBase::MakeTransparent with 3/4.
+ * @param dst The pixels to darken.
+ * @param n   Number of pixels.
+ */
+static inline SSE_TARGET void DarkenRun(Colour *dst, uint n)
+{
+#ifdef SSE_AVX2
+	for (; n >= 8; n -= 8, dst += 8) {
+		_mm256_storeu_si256((__m256i *)dst, DarkenEightPixels(_mm256_loadu_si256((const __m256i *)dst)));
+	}
+#endif
+	for (; n >= 4; n -= 4, dst += 4) {
+		_mm_storeu_si128((__m128i *)dst, DarkenFourPixels(_mm_loadu_si128((const __m128i *)dst)));
+	}
+	for (; n != 0; n--, dst++) *dst = Blitter_32bppBase::MakeTransparent(*dst, 3, 4);
+}
+
+/**
+ * Darken a run of pixels for a semi-transparent transparent sprite.
+ * @param dst The pixels to darken.
+ * @param src The pixels of the sprite.
+ * @param n   Number of pixels.
+ */
+static inline SSE_TARGET void DarkenRunByAlpha(Colour *dst, const Colour *src, uint n)
+{
+	for (; n >= 4; n -= 4, dst += 4, src += 4) {
+		__m128i d = _mm_loadu_si128((const __m128i *)dst);
+		_mm_storeu_si128((__m128i *)dst, DarkenFourPixelsByAlpha(_mm_loadu_si128((const __m128i *)src), d));
+	}
+	for (; n != 0; n--, dst++, src++) *dst = Blitter_32bppBase::MakeTransparent(*dst, (256 * 4 - src->a), 256 * 4);
+}
+
+/**
+ * Draw a run of pixels with colour remapping. The remapped palette colours
+ * are looked up one by one, then four pixels at a time get their brightness
+ * adjusted and are drawn. Pixels without 'm' channel keep their own colour,
+ * and pixels remapped to palette index 0 are not drawn.
+ * @tparam opaque   Whether the pixels are opaque rather than semi-transparent.
+ * @tparam animated Whether to fill the animation buffer for the pixels.
+ * @param dst     Where to draw.
+ * @param src     The pixels to draw.
+ * @param src_n   The 'm' channels of the pixels.
+ * @param n       Number of pixels.
+ * @param remap   The remap table.
+ * @param palette The palette to take the remapped colours from.
+ * @param anim    The animation buffer to fill for the pixels.
+ */
+template <bool opaque, bool animated>
+static inline SSE_TARGET void RemapRun(Colour *dst, const Colour *src, const uint16 *src_n, uint n, const byte *remap, const Colour *palette, uint16 *anim)
+{
+	for (; n >= 4; n -= 4, dst += 4, src += 4, src_n += 4) {
+		__m128i s = _mm_loadu_si128((const __m128i *)src);
+
+		if (!HasRemappedPixels(src_n)) {
+			if (animated) {
+				_mm_storel_epi64((__m128i *)anim, _mm_setzero_si128());
+				anim += 4;
+			}
+			_mm_storeu_si128((__m128i *)dst, opaque ? s : BlendFourPixels(s, _mm_loadu_si128((const __m128i *)dst)));
+			continue;
+		}
+
+		/* Keep the palette indices in registers; storing them in an array and
+		 * loading that as a whole stalls, as the load cannot be forwarded. */
+		uint r0 = remap[GB(src_n[0], 0, 8)];
+		uint r1 = remap[GB(src_n[1], 0, 8)];
+		uint r2 = remap[GB(src_n[2], 0, 8)];
+		uint r3 = remap[GB(src_n[3], 0, 8)];
+		if (animated) {
+			if (opaque) {
+				anim[0] = src_n[0] != 0 ? r0 | (src_n[0] & 0xFF00) : 0;
+				anim[1] = src_n[1] != 0 ? r1 | (src_n[1] & 0xFF00) : 0;
+				anim[2] = src_n[2] != 0 ? r2 | (src_n[2] & 0xFF00) : 0;
+				anim[3] = src_n[3] != 0 ? r3 | (src_n[3] & 0xFF00) : 0;
+			} else {
+				_mm_storel_epi64((__m128i *)anim, _mm_setzero_si128());
+			}
+			anim += 4;
+		}
+
+		__m128i m = _mm_loadl_epi64((const __m128i *)src_n);
+		__m128i unmapped = _mm_cmpeq_epi16(m, _mm_setzero_si128());
+		unmapped = _mm_unpacklo_epi16(unmapped, unmapped);
+		__m128i hidden = _mm_andnot_si128(unmapped, _mm_cmpeq_epi32(_mm_set_epi32(r3, r2, r1, r0), _mm_setzero_si128()));
+
+		__m128i c = AdjustBrightnessFour(_mm_set_epi32(palette[r3].data, palette[r2].data, palette[r1].data, palette[r0].data), m);
+		c = SelectPixels(unmapped, s, c);
+		__m128i d = _mm_loadu_si128((const __m128i *)dst);
+		if (!opaque) {
+			/* Semi-transparent pixels blend the remapped colour with their own alpha. */
+			c = BlendFourPixels(_mm_or_si128(_mm_andnot_si128(AlphaMask(), c), _mm_and_si128(AlphaMask(), s)), d);
+		}
+		_mm_storeu_si128((__m128i *)dst, SelectPixels(hidden, d, c));
+	}
+
+	for (; n != 0; n--, dst++, src++, src_n++) {
+		uint m = *src_n;
+		if (m == 0) {
+			*dst = opaque ? src->data : Blitter_32bppBase::ComposeColourRGBANoCheck(src->r, src->g, src->b, src->a, *dst);
+			if (animated) *anim++ = 0;
+			continue;
+		}
+
+		uint r = remap[GB(m, 0, 8)];
+		if (animated) *anim++ = opaque ? r | (m & 0xFF00) : 0;
+		if (r == 0) continue;
+		Colour c = Blitter_32bppBase::AdjustBrightness(palette[r], GB(m, 8, 8));
+		*dst = opaque ? c : Blitter_32bppBase::ComposeColourPANoCheck(c, src->a, *dst);
+	}
+}
+
+/**
+ * Draw a run of opaque pixels while keeping track of the palette indices
+ * for palette animation. Pixels with animated colours are drawn one by one
+ * via the palette.
+ * @param dst     Where to draw.
+ * @param src     The pixels to draw.
+ * @param src_n   The 'm' channels of the pixels.
+ * @param n       Number of pixels.
+ * @param anim    The animation buffer to fill for the pixels.
+ * @param palette The palette to take the animated colours from.
+ */
+static inline SSE_TARGET void CopyRunAnim(Colour *dst, const Colour *src, const uint16 *src_n, uint n, uint16 *anim, const Colour *palette)
+{
+	while (n != 0) {
+#ifdef SSE_AVX2
+		if (n >= 8 && !HasAnimatedColoursEight(src_n)) {
+			_mm_storeu_si128((__m128i *)anim, _mm_loadu_si128((const __m128i *)src_n));
+			_mm256_storeu_si256((__m256i *)dst, _mm256_loadu_si256((const __m256i *)src));
+			anim += 8;
+			dst += 8;
+			src += 8;
+			src_n += 8;
+			n -= 8;
+			continue;
+		}
+#endif
+		if (n >= 4 && !HasAnimatedColours(src_n)) {
+			_mm_storel_epi64((__m128i *)anim, _mm_loadl_epi64((const __m128i *)src_n));
+			_mm_storeu_si128((__m128i *)dst, _mm_loadu_si128((const __m128i *)src));
+			anim += 4;
+			dst += 4;
+			src += 4;
+			src_n += 4;
+			n -= 4;
+			continue;
+		}
+
+		uint m = GB(*src_n, 0, 8);
+		/* Above PALETTE_ANIM_START is palette animation */
+		*anim++ = *src_n;
+		*dst++ = (m >= PALETTE_ANIM_START) ? Blitter_32bppBase::AdjustBrightness(palette[m], GB(*src_n, 8, 8)) : src->data;
+		src++;
+		src_n++;
+		n--;
+	}
+}
+
+/**
+ * Blend a run of semi-transparent pixels while clearing the animation
+ * buffer. Pixels with animated colours are drawn one by one via the palette.
+ * @param dst     Where to draw.
+ * @param src     The pixels to draw.
+ * @param src_n   The 'm' channels of the pixels.
+ * @param n       Number of pixels.
+ * @param anim    The animation buffer to clear for the pixels.
+ * @param palette The palette to take the animated colours from.
+ */
+static inline SSE_TARGET void BlendRunAnim(Colour *dst, const Colour *src, const uint16 *src_n, uint n, uint16 *anim, const Colour *palette)
+{
+	while (n != 0) {
+#ifdef SSE_AVX2
+		if (n >= 8 && !HasAnimatedColoursEight(src_n)) {
+			_mm_storeu_si128((__m128i *)anim, _mm_setzero_si128());
+			__m256i d = _mm256_loadu_si256((const __m256i *)dst);
+			_mm256_storeu_si256((__m256i *)dst, BlendEightPixels(_mm256_loadu_si256((const __m256i *)src), d));
+			anim += 8;
+			dst += 8;
+			src += 8;
+			src_n += 8;
+			n -= 8;
+			continue;
+		}
+#endif
+		if (n >= 4 && !HasAnimatedColours(src_n)) {
+			_mm_storel_epi64((__m128i *)anim, _mm_setzero_si128());
+			__m128i d = _mm_loadu_si128((const __m128i *)dst);
+			_mm_storeu_si128((__m128i *)dst, BlendFourPixels(_mm_loadu_si128((const __m128i *)src), d));
+			anim += 4;
+			dst += 4;
+			src += 4;
+			src_n += 4;
+			n -= 4;
+			continue;
+		}
+
+		uint m = GB(*src_n, 0, 8);
+		*anim++ = 0;
+		if (m >= PALETTE_ANIM_START) {
+			*dst = Blitter_32bppBase::ComposeColourPANoCheck(Blitter_32bppBase::AdjustBrightness(palette[m], GB(*src_n, 8, 8)), src->a, *dst);
+		} else {
+			*dst = Blitter_32bppBase::ComposeColourRGBANoCheck(src->r, src->g, src->b, src->a, *dst);
+		}
+		dst++;
+		src++;
+		src_n++;
+		n--;
+	}
+}
+
+/**
+ * Draws a sprite to a (screen) buffer. It is the equivalent of
+ * Blitter_32bppOptimized::Draw, and of Blitter_32bppAnim::Draw when an
+ * animation buffer is given.
+ *
+ * @tparam mode blitter mode
+ * @tparam animated whether to keep track of the palette indices for palette animation
+ * @param bp further blitting parameters
+ * @param zoom zoom level at which we are drawing
+ * @param anim The animation buffer at the top left pixel to draw.
+ * @param anim_pitch The pitch of the animation buffer.
+ * @param palette The palette to look colours up in.
+ */
+template <BlitterMode mode, bool animated>
+static SSE_TARGET void DrawSSE(const Blitter::BlitterParams *bp, ZoomLevel zoom, uint16 *anim, int anim_pitch, const Colour *palette)
+{
+	const Blitter_32bppOptimized::SpriteData *src = (const Blitter_32bppOptimized::SpriteData *)bp->sprite;
+
+	const Colour *src_px = (const Colour *)(src->data + src->offset[zoom][0]);
+	const uint16 *src_n  = (const uint16 *)(src->data + src->offset[zoom][1]);
+
+	for (uint i = bp->skip_top; i != 0; i--) {
+		src_px = (const Colour *)((const byte *)src_px + *(const uint32 *)src_px);
+		src_n = (const uint16 *)((const byte *)src_n + *(const uint32 *)src_n);
+	}
+
+	Colour *dst = (Colour *)bp->dst + bp->top * bp->pitch + bp->left;
+
+	for (int y = 0; y < bp->height; y++) {
+		Colour *dst_ln = dst + bp->pitch;
+		uint16 *anim_ln = animated ? anim + anim_pitch : NULL;
+
+		const Colour *src_px_ln = (const Colour *)((const byte *)src_px + *(const uint32 *)src_px);
+		src_px++;
+
+		const uint16 *src_n_ln = (const uint16 *)((const byte *)src_n + *(const uint32 *)src_n);
+		src_n += 2;
+
+		Colour *dst_end = dst + bp->skip_left;
+
+		uint n;
+
+		while (dst < dst_end) {
+			n = *src_n++;
+
+			if (src_px->a == 0) {
+				dst += n;
+				src_px ++;
+				src_n++;
+
+				if (animated && dst > dst_end) anim += dst - dst_end;
+			} else {
+				if (dst + n > dst_end) {
+					uint d = dst_end - dst;
+					src_px += d;
+					src_n += d;
+
+					dst = dst_end - bp->skip_left;
+					dst_end = dst + bp->width;
+
+					n = min<uint>(n - d, (uint)bp->width);
+					goto draw;
+				}
+				dst += n;
+				src_px += n;
+				src_n += n;
+			}
+		}
+
+		dst -= bp->skip_left;
+		dst_end -= bp->skip_left;
+
+		dst_end += bp->width;
+
+		while (dst < dst_end) {
+			n = min<uint>(*src_n++, (uint)(dst_end - dst));
+
+			if (src_px->a == 0) {
+				if (animated) anim += n;
+				dst += n;
+				src_px++;
+				src_n++;
+				continue;
+			}
+
+			draw:;
+
+			switch (mode) {
+				case BM_COLOUR_REMAP:
+					if (src_px->a == 255) {
+						RemapRun<true, animated>(dst, src_px, src_n, n, bp->remap, palette, anim);
+					} else {
+						RemapRun<false, animated>(dst, src_px, src_n, n, bp->remap, palette, anim);
+					}
+					break;
+
+				case BM_TRANSPARENT:
+					/* Make the current colour a bit more black, so it looks like this image is transparent */
+					if (src_px->a == 255) {
+						DarkenRun(dst, n);
+					} else {
+						DarkenRunByAlpha(dst, src_px, n);
+					}
+					if (animated) MemSetT(anim, 0, n);
+					break;
+
+				default:
+					if (animated) {
+						if (src_px->a == 255) {
+							CopyRunAnim(dst, src_px, src_n, n, anim, palette);
+						} else {
+							BlendRunAnim(dst, src_px, src_n, n, anim, palette);
+						}
+					} else {
+						if (src_px->a == 255) {
+							CopyRun(dst, src_px, n);
+						} else {
+							BlendRun(dst, src_px, n);
+						}
+					}
+					break;
+			}
+
+			if (animated) anim += n;
+			dst += n;
+			src_px += n;
+			src_n += n;
+		}
+
+		anim = anim_ln;
+		dst = dst_ln;
+		src_px = src_px_ln;
+		src_n  = src_n_ln;
+	}
+}
+
+/**
+ * Draws a sprite to a (screen) buffer without palette animation.
+ *
+ * @param bp further blitting parameters
+ * @param mode blitter mode
+ * @param zoom zoom level at which we are drawing
+ */
+static void DrawSSEWithoutAnimation(const Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom)
+{
+	switch (mode) {
+		default: NOT_REACHED();
+		case BM_NORMAL:       DrawSSE<BM_NORMAL,       false>(bp, zoom, NULL, 0, _cur_palette.palette); return;
+		case BM_COLOUR_REMAP: DrawSSE<BM_COLOUR_REMAP, false>(bp, zoom, NULL, 0, _cur_palette.palette); return;
+		case BM_TRANSPARENT:  DrawSSE<BM_TRANSPARENT,  false>(bp, zoom, NULL, 0, _cur_palette.palette); return;
+	}
+}
+
+/**
+ * Draws a sprite to a (screen) buffer without palette animation.
+ *
+ * @param bp further blitting parameters
+ * @param mode blitter mode
+ * @param zoom zoom level at which we are drawing
+ */
+void SSE_BLITTER::Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom)
+{
+	DrawSSEWithoutAnimation(bp, mode, zoom);
+}
+
+/**
+ * Draws a sprite to the screen, keeping track of the palette indices for
+ * palette animation.
+ *
+ * @param bp further blitting parameters
+ * @param mode blitter mode
+ * @param zoom zoom level at which we are drawing
+ */
+void SSE_ANIM_BLITTER::Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom)
+{
+	if (_screen_disable_anim) {
+		/* This means our output is not to the screen, so we can't be doing any animation stuff, so draw like the blitter without animation */
+		DrawSSEWithoutAnimation(bp, mode, zoom);
+		return;
+	}
+
+	uint16 *anim = this->anim_buf + ((uint32 *)bp->dst - (uint32 *)_screen.dst_ptr) + bp->top * this->anim_buf_width + bp->left;
+	const Colour *palette = this->palette.palette;
+
+	switch (mode) {
+		default: NOT_REACHED();
+		case BM_NORMAL:       DrawSSE<BM_NORMAL,       true>(bp, zoom, anim, this->anim_buf_width, palette); return;
+		case BM_COLOUR_REMAP: DrawSSE<BM_COLOUR_REMAP, true>(bp, zoom, anim, this->anim_buf_width, palette); return;
+		case BM_TRANSPARENT:  DrawSSE<BM_TRANSPARENT,  true>(bp, zoom, anim, this->anim_buf_width, palette); return;
+	}
+}
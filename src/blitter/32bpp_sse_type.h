@@ -0,0 +1,46 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file 32bpp_sse_type.h Compiler support for the SSE 32 bpp blitters. */
+
+#ifndef BLITTER_32BPP_SSE_TYPE_H
+#define BLITTER_32BPP_SSE_TYPE_H
+
+/*
+ * The SSE blitters are compiled into every x86 build. Each of their
+ * functions is compiled for its own instruction set, and the blitter is only
+ * selectable when the CPU supports it. So the rest of the game does not need
+ * any special compiler flags.
+ */
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+	#define WITH_SSE
+	/* MSVC always allows the intrinsics of all SSE versions. */
+	#define SSE2_TARGET
+	#define SSSE3_TARGET
+	#define SSE4_TARGET
+	#if _MSC_VER >= 1700
+		/* MSVC 2012 is the first to know the AVX2 intrinsics. */
+		#define WITH_AVX2
+		#define AVX2_TARGET
+	#endif
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+	/* GCC 4.9 is the first that allows intrinsics in functions with a target attribute, without -msse4.1 and the like. */
+	#define WITH_SSE
+	#define WITH_AVX2
+	/** Allow SSE2 instructions in a function, even when they are not enabled for the whole build. */
+	#define SSE2_TARGET __attribute__((target("sse2")))
+	/** Allow SSSE3 instructions in a function. */
+	#define SSSE3_TARGET __attribute__((target("ssse3")))
+	/** Allow SSE4.1 instructions in a function. */
+	#define SSE4_TARGET __attribute__((target("sse4.1")))
+	/** Allow AVX2 instructions in a function. */
+	#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+#endif /* BLITTER_32BPP_SSE_TYPE_H */
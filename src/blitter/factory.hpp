@@ -110,6 +110,11 @@ public:
 		for (; it != GetBlitters().end(); it++) {
 			BlitterFactoryBase *b = (*it).second;
 			if (strcasecmp(bname, b->name) == 0) {
+				if (!b->IsUsable()) {
+					DEBUG(driver, 1, "Blitter '%s' is not supported by this CPU", bname);
+					return NULL;
+				}
+
 				Blitter *newb = b->CreateInstance();
 				delete *GetActiveBlitter();
 				*GetActiveBlitter() = newb;
@@ -121,6 +126,37 @@ public:
 		return NULL;
 	}
 
+	/**
+	 * Select the fastest 32 bpp blitter with palette animation the CPU supports.
+	 * @return The selected blitter, or \c NULL if none could be selected.
+	 * @post Sets the blitter so GetCurrentBlitter() returns it too.
+	 */
+	static Blitter *Select32bppAnimBlitter()
+	{
+		static const char * const blitters[] = { "32bpp-avx2-anim", "32bpp-sse4-anim", "32bpp-ssse3-anim", "32bpp-sse2-anim", "32bpp-anim" };
+		for (uint i = 0; i < lengthof(blitters); i++) {
+			Blitter *b = SelectBlitter(blitters[i]);
+			if (b != NULL) return b;
+		}
+		return NULL;
+	}
+
+	/**
+	 * Create an instance of a blitter without selecting it, e.g. to compare
+	 * its output with that of another blitter.
+	 * @param name The name of the blitter.
+	 * @return The new blitter, or \c NULL if it is unknown or the CPU does not support it.
+	 */
+	static Blitter *CreateBlitter(const char *name)
+	{
+		Blitters::iterator it = GetBlitters().begin();
+		for (; it != GetBlitters().end(); it++) {
+			BlitterFactoryBase *b = (*it).second;
+			if (strcasecmp(name, b->name) == 0) return b->IsUsable() ? b->CreateInstance() : NULL;
+		}
+		return NULL;
+	}
+
 	/**
 	 * Get the current active blitter (always set by calling SelectBlitter).
 	 */
@@ -141,6 +177,7 @@ public:
 		Blitters::iterator it = GetBlitters().begin();
 		for (; it != GetBlitters().end(); it++) {
 			BlitterFactoryBase *b = (*it).second;
+			if (!b->IsUsable()) continue;
 			p += seprintf(p, last, "%18s: %s\n", b->name, b->GetDescription());
 		}
 		p += seprintf(p, last, "\n");
@@ -157,6 +194,13 @@ public:
 	 * Create an instance of this Blitter-class.
 	 */
 	virtual Blitter *CreateInstance() = 0;
+
+	/**
+	 * Check whether the blitter can be used, e.g. whether the CPU supports
+	 * the instructions it needs.
+	 * @return True iff the blitter can be selected.
+	 */
+	virtual bool IsUsable() { return true; }
 };
 
 /**
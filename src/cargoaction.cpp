@@ -203,8 +203,9 @@ bool StationCargoReroute::operator()(CargoPacket *cp)
 		this->destination->AddToCache(cp_new);
 	}
 
-	/* Legal, as insert doesn't invalidate iterators in the MultiMap, however
-	 * this might insert the packet between range.first and range.second (which might be end())
+	/* Legal, as the packet is inserted in the range of another next hop, so the
+	 * iterators into the range being shifted stay valid. However this might insert
+	 * the packet between range.first and range.second (which might be end()).
 	 * This is why we check for GetKey above to avoid infinite loops. */
 	this->destination->packets.Insert(next, cp_new);
 	return cp_new == cp;
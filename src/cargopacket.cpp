@@ -391,6 +391,34 @@ void VehicleCargoList::AgeCargo()
 	}
 }
 
+/**
+ * Get everything aging the cargo changes, to compare or restore it later.
+ * @param state Where to store the state.
+ */
+void VehicleCargoList::GetAgeState(AgeState *state) const
+{
+	state->days_in_transit.clear();
+	for (ConstIterator it(this->packets.begin()); it != this->packets.end(); it++) {
+		state->days_in_transit.push_back((*it)->days_in_transit);
+	}
+	state->cargo_days_in_transit = this->cargo_days_in_transit;
+}
+
+/**
+ * Restore the state of the cargo from before aging it.
+ * @param state The state from #GetAgeState; the packets must not have changed since.
+ */
+void VehicleCargoList::SetAgeState(const AgeState &state)
+{
+	assert(state.days_in_transit.size() == this->packets.size());
+
+	std::vector<byte>::const_iterator days = state.days_in_transit.begin();
+	for (Iterator it(this->packets.begin()); it != this->packets.end(); ++it, ++days) {
+		(*it)->days_in_transit = *days;
+	}
+	this->cargo_days_in_transit = state.cargo_days_in_transit;
+}
+
 /**
  * Sets loaded_at_xy to the current station for all cargo to be transfered.
  * This is done when stopping or skipping while the vehicle is unloading. In
@@ -738,38 +766,55 @@ uint StationCargoList::Truncate(uint max_move, StationCargoAmountMap *cargo_per_
 	uint loop = 0;
 	bool do_count = cargo_per_source != NULL;
 	while (max_move > moved) {
-		for (Iterator it(this->packets.begin()); it != this->packets.end();) {
-			CargoPacket *cp = *it;
-			if (prev_count > max_move && RandomRange(prev_count) < prev_count - max_move) {
-				if (do_count && loop == 0) {
-					(*cargo_per_source)[cp->source] += cp->count;
+		/* Compact the packets of each next hop in place, instead of erasing
+		 * them one by one from the middle of their range. */
+		for (StationCargoPacketMap::MapIterator map_it(this->packets.begin()); map_it != this->packets.end();) {
+			StationCargoPacketMap::List &list = map_it->second;
+			StationCargoPacketMap::ListIterator keep = list.begin();
+			bool finished = false;
+			for (StationCargoPacketMap::ListIterator it(list.begin()); it != list.end(); ++it) {
+				CargoPacket *cp = *it;
+				if (finished) {
+					*keep++ = cp;
+					continue;
 				}
-				++it;
-				continue;
-			}
-			uint diff = max_move - moved;
-			if (cp->count > diff) {
-				if (diff > 0) {
-					this->RemoveFromCache(cp, diff);
-					cp->Reduce(diff);
-					moved += diff;
+				if (prev_count > max_move && RandomRange(prev_count) < prev_count - max_move) {
+					if (do_count && loop == 0) {
+						(*cargo_per_source)[cp->source] += cp->count;
+					}
+					*keep++ = cp;
+					continue;
 				}
-				if (loop > 0) {
-					if (do_count) (*cargo_per_source)[cp->source] -= diff;
-					return moved;
+				uint diff = max_move - moved;
+				if (cp->count > diff) {
+					if (diff > 0) {
+						this->RemoveFromCache(cp, diff);
+						cp->Reduce(diff);
+						moved += diff;
+					}
+					if (loop > 0) {
+						if (do_count) (*cargo_per_source)[cp->source] -= diff;
+						finished = true;
+					} else {
+						if (do_count) (*cargo_per_source)[cp->source] += cp->count;
+					}
+					*keep++ = cp;
 				} else {
-					if (do_count) (*cargo_per_source)[cp->source] += cp->count;
-					++it;
+					if (do_count && loop > 0) {
+						(*cargo_per_source)[cp->source] -= cp->count;
+					}
+					moved += cp->count;
+					this->RemoveFromCache(cp, cp->count);
+					delete cp;
 				}
+			}
+			list.erase(keep, list.end());
+			if (list.empty()) {
+				this->packets.StationCargoPacketMap::Map::erase(map_it++);
 			} else {
-				it = this->packets.erase(it);
-				if (do_count && loop > 0) {
-					(*cargo_per_source)[cp->source] -= cp->count;
-				}
-				moved += cp->count;
-				this->RemoveFromCache(cp, cp->count);
-				delete cp;
+				++map_it;
 			}
+			if (finished) return moved;
 		}
 		loop++;
 	}
@@ -20,6 +20,7 @@
 #include "vehicle_type.h"
 #include "core/multimap.hpp"
 #include <list>
+#include <vector>
 
 /** Unique identifier for a single cargo packet. */
 typedef uint32 CargoPacketID;
@@ -330,6 +331,17 @@ public:
 	friend class CargoReturn;
 	friend class VehicleCargoReroute;
 
+	/** Everything aging the cargo changes: the days in transit of each packet and their cached sum. */
+	struct AgeState {
+		std::vector<byte> days_in_transit; ///< Days in transit of each packet, in list order.
+		uint cargo_days_in_transit;        ///< Cached sum of the days in transit of all cargo.
+
+		inline bool operator ==(const AgeState &other) const
+		{
+			return this->cargo_days_in_transit == other.cargo_days_in_transit && this->days_in_transit == other.days_in_transit;
+		}
+	};
+
 	/**
 	 * Returns source of the first cargo packet in this list.
 	 * @return The before mentioned source.
@@ -407,6 +419,8 @@ public:
 	void Append(CargoPacket *cp, MoveToAction action = MTA_KEEP);
 
 	void AgeCargo();
+	void GetAgeState(AgeState *state) const;
+	void SetAgeState(const AgeState &state);
 
 	void InvalidateCache();
 
@@ -20,6 +20,7 @@
 #include "network/network_base.h"
 #include "network/network_admin.h"
 #include "network/network_client.h"
+#include "network/core/packet.h"
 #include "command_func.h"
 #include "settings_func.h"
 #include "fios.h"
@@ -38,6 +39,11 @@
 #include "console_func.h"
 #include "engine_base.h"
 #include "game/game.hpp"
+#include "tick_profiler.h"
+#include "blitter/factory.hpp"
+#include "core/random_func.hpp"
+#include "core/mem_func.hpp"
+#include "gfx_func.h"
 #include "table/strings.h"
 
 /* scriptfile handling */
@@ -668,6 +674,23 @@ DEF_CONSOLE_CMD(ConStatus)
 	return true;
 }
 
+DEF_CONSOLE_CMD(ConPacketPool)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show statistics of the pool of network packet buffers. Usage 'packet_pool'");
+		return true;
+	}
+
+	PacketPoolStats stats;
+	GetPacketPoolStats(&stats);
+	IConsolePrintF(CC_DEFAULT, "Buffers in use:    %u (peak %u)", stats.in_use, stats.peak);
+	IConsolePrintF(CC_DEFAULT, "Buffers in pool:   %u", stats.pooled);
+	IConsolePrintF(CC_DEFAULT, "Heap allocations:  %u", stats.allocated);
+	IConsolePrintF(CC_DEFAULT, "Reused buffers:    %u", stats.reused);
+	IConsolePrintF(CC_DEFAULT, "Shared packets:    %u", stats.shared);
+	return true;
+}
+
 DEF_CONSOLE_CMD(ConServerInfo)
 {
 	if (argc == 0) {
@@ -1325,6 +1348,60 @@ DEF_CONSOLE_CMD(ConGetDate)
 	return true;
 }
 
+DEF_CONSOLE_CMD(ConProfile)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show the time spent in the phases of the game loop. Usage: 'profile [reset]'");
+		IConsoleHelp("Write the timings of the next ticks to a trace file, for e.g. chrome://tracing. Usage: 'profile trace <file> [<ticks>]'");
+		IConsoleHelp("Times are in microseconds; 'reset' clears all measurements");
+		return true;
+	}
+
+	if (argc == 2 && strcmp(argv[1], "reset") == 0) {
+		ResetTickProfile();
+		IConsolePrint(CC_DEFAULT, "Profile reset.");
+		return true;
+	}
+
+	if ((argc == 3 || argc == 4) && strcmp(argv[1], "trace") == 0) {
+		uint32 ticks = DAY_TICKS;
+		if (argc == 4 && !GetArgumentInteger(&ticks, argv[3])) return false;
+		if (!StartTickTrace(argv[2], ticks)) {
+			IConsolePrintF(CC_ERROR, "Could not open '%s' for writing.", argv[2]);
+			return true;
+		}
+		IConsolePrintF(CC_DEFAULT, "Tracing the next %u ticks to '%s'.", ticks, argv[2]);
+		return true;
+	}
+
+	if (argc != 1) return false;
+
+	const TickProfile &profile = GetTickProfile();
+	if (profile.ticks == 0) {
+		IConsolePrint(CC_DEFAULT, "No ticks have been measured yet.");
+		return true;
+	}
+
+	IConsolePrintF(CC_DEFAULT, "Ticks measured: %u", profile.ticks);
+	IConsolePrint(CC_DEFAULT,  "Phase              Average       Max      Last");
+	for (TickPhase phase = TPH_GAMELOOP; phase < TPH_END; phase++) {
+		uint depth = 0;
+		for (TickPhase parent = GetTickPhaseParent(phase); parent != INVALID_TICK_PHASE; parent = GetTickPhaseParent(parent)) depth++;
+
+		const TickPhaseStats &stats = profile.phases[phase];
+		IConsolePrintF(CC_DEFAULT, "%*s%-*s %9u %9u %9u", depth * 2, "", 16 - depth * 2, GetTickPhaseName(phase),
+				(uint)(stats.total / profile.ticks), (uint)stats.max, (uint)stats.last);
+	}
+
+	const Company *c;
+	FOR_ALL_COMPANIES(c) {
+		if (!c->is_ai) continue;
+		const TickPhaseStats &stats = profile.ai_companies[c->index];
+		IConsolePrintF(CC_DEFAULT, "    company %2d     %9u %9u %9u", c->index + 1,
+				(uint)(stats.total / profile.ticks), (uint)stats.max, (uint)stats.last);
+	}
+	return true;
+}
 
 DEF_CONSOLE_CMD(ConAlias)
 {
@@ -1388,6 +1465,237 @@ DEF_CONSOLE_CMD(ConScreenShot)
 	return true;
 }
 
+/** Width of the buffer the blitters draw to when comparing them. */
+static const int COMPARE_BUFFER_WIDTH  = 128;
+/** Height of the buffer the blitters draw to when comparing them. */
+static const int COMPARE_BUFFER_HEIGHT = 96;
+
+/**
+ * Allocate memory for a sprite encoded by a blitter that is compared.
+ * @param size The size of the sprite.
+ * @return The memory.
+ */
+static void *AllocateComparedSprite(size_t size)
+{
+	return MallocT<byte>(size);
+}
+
+/**
+ * Fill a sprite with random runs of transparent, semi-transparent and
+ * opaque pixels, with and without remapped and animated colours.
+ * @param sprite The sprites of all zoom levels to fill.
+ * @param random The random generator to use.
+ */
+static void MakeRandomSprite(SpriteLoader::Sprite *sprite, Randomizer &random)
+{
+	for (ZoomLevel z = ZOOM_LVL_BEGIN; z < ZOOM_LVL_END; z++) {
+		SpriteLoader::Sprite *s = &sprite[z];
+		s->width = 1 + random.Next(COMPARE_BUFFER_WIDTH);
+		s->height = 1 + random.Next(COMPARE_BUFFER_HEIGHT);
+		s->x_offs = 0;
+		s->y_offs = 0;
+		s->type = ST_NORMAL;
+		s->data = CallocT<SpriteLoader::CommonPixel>(s->width * s->height);
+
+		SpriteLoader::CommonPixel *px = s->data;
+		for (uint y = 0; y < s->height; y++) {
+			uint run = 0;
+			uint alpha = 0;
+			for (uint x = 0; x < s->width; x++, px++) {
+				if (run == 0) {
+					run = 1 + random.Next(16);
+					switch (random.Next(3)) {
+						case 0: alpha = 0; break;
+						case 1: alpha = 255; break;
+						default: alpha = 1 + random.Next(254); break;
+					}
+				}
+				run--;
+
+				px->r = random.Next(256);
+				px->g = random.Next(256);
+				px->b = random.Next(256);
+				px->a = alpha == 0 || alpha == 255 ? alpha : 1 + random.Next(254);
+				px->m = random.Next(3) == 0 ? 0 : random.Next(256);
+			}
+		}
+	}
+}
+
+/**
+ * Compare the output of a blitter with that of a reference blitter, pixel by
+ * pixel, and measure how fast both draw.
+ * @param test      The blitter to test.
+ * @param reference The blitter it has to match.
+ * @param rounds    The number of random sprites to draw.
+ * @return The number of draws that did not match.
+ */
+static uint CompareBlitters(Blitter *test, Blitter *reference, uint rounds)
+{
+	static const BlitterMode modes[] = { BM_NORMAL, BM_COLOUR_REMAP, BM_TRANSPARENT };
+	static const char * const mode_names[] = { "normal", "colour remap", "transparent" };
+	/* Draw every sprite several times when timing, as a single draw is too short to measure. */
+	static const uint TIMED_DRAWS = 32;
+
+	const bool animated = reference->UsePaletteAnimation() == Blitter::PALETTE_ANIMATION_BLITTER;
+	const int size = reference->BufferSize(COMPARE_BUFFER_WIDTH, COMPARE_BUFFER_HEIGHT);
+
+	uint32 *buf[2] = { MallocT<uint32>(COMPARE_BUFFER_WIDTH * COMPARE_BUFFER_HEIGHT), MallocT<uint32>(COMPARE_BUFFER_WIDTH * COMPARE_BUFFER_HEIGHT) };
+	byte *copy[2] = { MallocT<byte>(size), MallocT<byte>(size) };
+	Blitter *blitters[2] = { reference, test };
+	uint64 time[2][lengthof(modes)];
+	uint64 pixels[lengthof(modes)];
+	MemSetT(&time[0][0], 0, lengthof(modes) * 2);
+	MemSetT(pixels, 0, lengthof(modes));
+
+	/* Animated blitters keep their animation buffer relative to the screen; make the buffer the screen. */
+	DrawPixelInfo old_screen = _screen;
+	bool old_disable_anim = _screen_disable_anim;
+	_screen.width = COMPARE_BUFFER_WIDTH;
+	_screen.height = COMPARE_BUFFER_HEIGHT;
+	_screen.pitch = COMPARE_BUFFER_WIDTH;
+	_screen_disable_anim = !animated;
+
+	Palette palette = _cur_palette;
+	palette.first_dirty = PALETTE_ANIM_START;
+	for (uint i = 0; i < 2; i++) {
+		_screen.dst_ptr = buf[i];
+		blitters[i]->PostResize();
+		if (animated) blitters[i]->PaletteAnimate(palette);
+	}
+
+	/* Use an own generator; the game state must not change. */
+	Randomizer random;
+	random.SetSeed(rounds);
+
+	byte remap[256];
+	uint mismatches = 0;
+	for (uint round = 0; round < rounds; round++) {
+		SpriteLoader::Sprite sprite[ZOOM_LVL_COUNT];
+		MakeRandomSprite(sprite, random);
+		Sprite *encoded[2] = { reference->Encode(sprite, AllocateComparedSprite), test->Encode(sprite, AllocateComparedSprite) };
+
+		for (uint i = 0; i < lengthof(remap); i++) remap[i] = random.Next(4) == 0 ? 0 : random.Next(256);
+
+		ZoomLevel zoom_min = _settings_client.gui.zoom_min;
+		ZoomLevel zoom_max = _settings_client.gui.zoom_max;
+		if (zoom_max == zoom_min) zoom_max = ZOOM_LVL_MAX;
+
+		for (ZoomLevel z = zoom_min; z <= zoom_max; z++) {
+			for (uint m = 0; m < lengthof(modes); m++) {
+				const SpriteLoader::Sprite *s = &sprite[z];
+				Blitter::BlitterParams bp;
+				bp.remap = remap;
+				bp.sprite_width = s->width;
+				bp.sprite_height = s->height;
+				bp.skip_left = random.Next(2) == 0 ? 0 : random.Next(s->width);
+				bp.skip_top = random.Next(2) == 0 ? 0 : random.Next(s->height);
+				bp.width = 1 + random.Next(s->width - bp.skip_left);
+				bp.height = 1 + random.Next(s->height - bp.skip_top);
+				bp.left = random.Next(COMPARE_BUFFER_WIDTH - bp.width + 1);
+				bp.top = random.Next(COMPARE_BUFFER_HEIGHT - bp.height + 1);
+				bp.pitch = COMPARE_BUFFER_WIDTH;
+
+				uint32 seed = random.Next();
+				for (uint i = 0; i < 2; i++) {
+					Randomizer background;
+					background.SetSeed(seed);
+					for (uint p = 0; p < COMPARE_BUFFER_WIDTH * COMPARE_BUFFER_HEIGHT; p++) buf[i][p] = background.Next() | 0xFF000000;
+
+					_screen.dst_ptr = buf[i];
+					bp.dst = buf[i];
+					bp.sprite = encoded[i]->data;
+					blitters[i]->Draw(&bp, modes[m], z);
+
+					if (animated) {
+						blitters[i]->CopyToBuffer(buf[i], copy[i], COMPARE_BUFFER_WIDTH, COMPARE_BUFFER_HEIGHT);
+					} else {
+						memcpy(copy[i], buf[i], size);
+					}
+				}
+
+				if (memcmp(copy[0], copy[1], size) != 0) {
+					if (mismatches < 10) {
+						IConsolePrintF(CC_ERROR, "Mismatch drawing sprite %u at zoom level %u in %s mode (%dx%d pixels, skipping %d, %d).",
+								round, z, mode_names[m], bp.width, bp.height, bp.skip_left, bp.skip_top);
+					}
+					mismatches++;
+				}
+
+				/* Time the blitters, on what they just drew. */
+				for (uint i = 0; i < 2; i++) {
+					_screen.dst_ptr = buf[i];
+					bp.dst = buf[i];
+					bp.sprite = encoded[i]->data;
+					uint64 start = GetProfilerTime();
+					for (uint d = 0; d < TIMED_DRAWS; d++) blitters[i]->Draw(&bp, modes[m], z);
+					time[i][m] += GetProfilerTime() - start;
+				}
+				pixels[m] += bp.width * bp.height * TIMED_DRAWS;
+			}
+		}
+
+		free(encoded[0]);
+		free(encoded[1]);
+		for (ZoomLevel z = ZOOM_LVL_BEGIN; z < ZOOM_LVL_END; z++) free(sprite[z].data);
+	}
+
+	_screen = old_screen;
+	_screen_disable_anim = old_disable_anim;
+
+	IConsolePrintF(CC_DEFAULT, "Mode              %16s %16s", reference->GetName(), test->GetName());
+	for (uint m = 0; m < lengthof(modes); m++) {
+		IConsolePrintF(CC_DEFAULT, "%-16s  %9u Mpx/s  %9u Mpx/s", mode_names[m],
+				(uint)(pixels[m] / max<uint64>(time[0][m], 1)), (uint)(pixels[m] / max<uint64>(time[1][m], 1)));
+	}
+
+	free(buf[0]);
+	free(buf[1]);
+	free(copy[0]);
+	free(copy[1]);
+	return mismatches;
+}
+
+DEF_CONSOLE_CMD(ConCompareBlitters)
+{
+	if (argc == 0) {
+		IConsoleHelp("Compare the output of a 32 bpp blitter with that of the blitter it optimises, and show how fast both draw. Usage: 'compare_blitters <blitter> [<sprites>]'");
+		IConsoleHelp("Random sprites are drawn in every blitter mode and zoom level; the output has to match 32bpp-optimized, or 32bpp-anim for blitters with palette animation");
+		return true;
+	}
+
+	if (argc != 2 && argc != 3) return false;
+
+	uint32 rounds = 100;
+	if (argc == 3 && !GetArgumentInteger(&rounds, argv[2])) return false;
+
+	Blitter *test = BlitterFactoryBase::CreateBlitter(argv[1]);
+	if (test == NULL || test->GetScreenDepth() != 32) {
+		IConsolePrintF(CC_ERROR, "'%s' is not a 32 bpp blitter this CPU supports.", argv[1]);
+		delete test;
+		return true;
+	}
+
+	bool animated = test->UsePaletteAnimation() == Blitter::PALETTE_ANIMATION_BLITTER;
+	Blitter *reference = BlitterFactoryBase::CreateBlitter(animated ? "32bpp-anim" : "32bpp-optimized");
+	if (reference == NULL) {
+		IConsolePrint(CC_ERROR, "The reference blitter is not available.");
+		delete test;
+		return true;
+	}
+
+	uint mismatches = CompareBlitters(test, reference, rounds);
+	if (mismatches == 0) {
+		IConsolePrintF(CC_DEFAULT, "'%s' draws exactly like '%s'.", test->GetName(), reference->GetName());
+	} else {
+		IConsolePrintF(CC_ERROR, "'%s' differs from '%s' in %u draws.", test->GetName(), reference->GetName(), mismatches);
+	}
+
+	delete test;
+	delete reference;
+	return true;
+}
+
 DEF_CONSOLE_CMD(ConInfoCmd)
 {
 	if (argc == 0) {
@@ -1913,11 +2221,13 @@ void IConsoleStdLibRegister()
 	IConsoleCmdRegister("restart",      ConRestart);
 	IConsoleCmdRegister("getseed",      ConGetSeed);
 	IConsoleCmdRegister("getdate",      ConGetDate);
+	IConsoleCmdRegister("profile",      ConProfile);
 	IConsoleCmdRegister("quit",         ConExit);
 	IConsoleCmdRegister("resetengines", ConResetEngines, ConHookNoNetwork);
 	IConsoleCmdRegister("reset_enginepool", ConResetEnginePool, ConHookNoNetwork);
 	IConsoleCmdRegister("return",       ConReturn);
 	IConsoleCmdRegister("screenshot",   ConScreenShot);
+	IConsoleCmdRegister("compare_blitters", ConCompareBlitters);
 	IConsoleCmdRegister("script",       ConScript);
 	IConsoleCmdRegister("scrollto",     ConScrollToTile);
 	IConsoleCmdRegister("alias",        ConAlias);
@@ -1975,6 +2285,7 @@ void IConsoleStdLibRegister()
 	IConsoleCmdRegister("clients",         ConNetworkClients, ConHookNeedNetwork);
 	IConsoleCmdRegister("status",          ConStatus, ConHookServerOnly);
 	IConsoleCmdRegister("server_info",     ConServerInfo, ConHookServerOnly);
+	IConsoleCmdRegister("packet_pool",     ConPacketPool);
 	IConsoleAliasRegister("info",          "server_info");
 	IConsoleCmdRegister("reconnect",       ConNetworkReconnect, ConHookClientOnly);
 	IConsoleCmdRegister("rcon",            ConRcon, ConHookNeedNetwork);
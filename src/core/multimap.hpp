@@ -13,7 +13,7 @@
 #define MULTIMAP_HPP
 
 #include <map>
-#include <list>
+#include <deque>
 
 template<typename Tkey, typename Tvalue, typename Tcompare>
 class MultiMap;
@@ -281,11 +281,14 @@ bool operator!=(const Tmap_iter2 &iter2, const MultiMapIterator<Tmap_iter1, Tlis
  * internally ordered in a deterministic way (contrary to STL multimap). All
  * STL-compatible members are named in STL style, all others are named in OpenTTD
  * style.
+ * The ranges are stored in deques, so their items are kept in contiguous blocks
+ * instead of a separately allocated node per item. Changing a range therefore
+ * invalidates the iterators pointing into that range, but no others.
  */
 template<typename Tkey, typename Tvalue, typename Tcompare = std::less<Tkey> >
-class MultiMap : public std::map<Tkey, std::list<Tvalue>, Tcompare > {
+class MultiMap : public std::map<Tkey, std::deque<Tvalue>, Tcompare > {
 public:
-	typedef typename std::list<Tvalue> List;
+	typedef typename std::deque<Tvalue> List;
 	typedef typename List::iterator ListIterator;
 	typedef typename List::const_iterator ConstListIterator;
 
@@ -297,7 +300,8 @@ public:
 	typedef MultiMapIterator<ConstMapIterator, ConstListIterator, Tkey, const Tvalue, Tcompare> const_iterator;
 
 	/**
-	 * Erase the value pointed to by an iterator. The iterator may be invalid afterwards.
+	 * Erase the value pointed to by an iterator. The iterator may be invalid afterwards,
+	 * as may be all other iterators pointing into the same range of equal keys.
 	 * @param it Iterator pointing at some value.
 	 * @return Iterator to the element after the deleted one (or invalid).
 	 */
@@ -314,7 +318,7 @@ public:
 				it.list_valid = false;
 			}
 		} else {
-			list.erase(list.begin());
+			list.pop_front();
 			if (list.empty()) this->Map::erase(it.map_iter++);
 		}
 		return it;
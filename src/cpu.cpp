@@ -0,0 +1,120 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file cpu.cpp OS/CPU/compiler dependent CPU specific calls. */
+
+#include "stdafx.h"
+#include "core/bitmath_func.hpp"
+#include "cpu.h"
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+
+/**
+ * Execute the CPUID instruction.
+ * @param info Receives EAX, EBX, ECX and EDX.
+ * @param type The information to request; of leaves with sub-leaves the first is requested.
+ */
+static void GetCPUID(uint info[4], uint type)
+{
+#if _MSC_VER >= 1500
+	__cpuidex((int *)info, type, 0);
+#else
+	/* Older versions can't request sub-leaves; they are only used for AVX2, which these versions do not compile anyway. */
+	__cpuid((int *)info, type);
+#endif
+}
+
+/**
+ * Get the extended control register telling which registers the OS saves.
+ * @return The contents of XCR0.
+ */
+static uint64 GetXCR0()
+{
+#if _MSC_FULL_VER >= 160040219
+	/* _xgetbv is available since MSVC 2010 SP1. */
+	return _xgetbv(0);
+#else
+	return 0;
+#endif
+}
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <cpuid.h>
+
+/**
+ * Execute the CPUID instruction.
+ * @param info Receives EAX, EBX, ECX and EDX.
+ * @param type The information to request; of leaves with sub-leaves the first is requested.
+ */
+static void GetCPUID(uint info[4], uint type)
+{
+	__cpuid_count(type, 0, info[0], info[1], info[2], info[3]);
+}
+
+/**
+ * Get the extended control register telling which registers the OS saves.
+ * @return The contents of XCR0.
+ */
+static uint64 GetXCR0()
+{
+	uint32 eax, edx;
+	__asm__ __volatile__("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+	return ((uint64)edx << 32) | eax;
+}
+#else
+/**
+ * Fallback for CPUs without the CPUID instruction; claims that no
+ * information is available.
+ * @param info Receives EAX, EBX, ECX and EDX.
+ * @param type The information to request.
+ */
+static void GetCPUID(uint info[4], uint type)
+{
+	info[0] = info[1] = info[2] = info[3] = 0;
+}
+
+/**
+ * Fallback for CPUs without extended control registers.
+ * @return No registers are saved.
+ */
+static uint64 GetXCR0()
+{
+	return 0;
+}
+#endif
+
+/**
+ * Check whether the CPU reports a feature via the CPUID instruction.
+ * @param type  The CPUID leaf to query, e.g. 1 for the basic feature flags.
+ * @param index The register holding the flag; 0 for EAX, 1 for EBX, 2 for ECX and 3 for EDX.
+ * @param bit   The bit of the flag in that register.
+ * @return True iff the CPU supports the leaf and the flag is set.
+ */
+bool HasCPUIDFlag(uint type, uint index, uint bit)
+{
+	uint info[4];
+
+	/* Leaf 0 tells the highest supported leaf. */
+	GetCPUID(info, 0);
+	if (info[0] < type) return false;
+
+	GetCPUID(info, type);
+	return HasBit(info[index], bit);
+}
+
+/**
+ * Check whether the OS saves the AVX registers on a task switch, so AVX
+ * instructions may be used when the CPU supports them.
+ * @return True iff the OS supports AVX.
+ */
+bool HasOSAVXSupport()
+{
+	/* OSXSAVE tells that XGETBV may be used; XCR0 then tells whether the SSE and AVX state is saved. */
+	return HasCPUIDFlag(1, 2, 27) && (GetXCR0() & 6) == 6;
+}
@@ -20,6 +20,7 @@
 #include "rail_gui.h"
 #include "linkgraph/linkgraph.h"
 #include "saveload/saveload.h"
+#include "tick_profiler.h"
 
 Year      _cur_year;   ///< Current year, starting at 0
 Month     _cur_month;  ///< Current month (0..11)
@@ -272,6 +273,8 @@ static void OnNewDay()
  */
 void IncreaseDate()
 {
+	TickPhaseTimer timer(TPH_DATE);
+
 	/* increase day, and check if a new day is there? */
 	_tick_counter++;
 
@@ -98,6 +98,18 @@ char *DumpDebugFacilityNames(char *buf, char *last)
 	return buf;
 }
 
+static bool _debug_silenced = false; ///< Whether all debug output is suppressed.
+
+/**
+ * Suppress all further debug output of this process. For processes that must
+ * not touch the console or the admin connections, nor the locks guarding
+ * them, such as the child process writing a snapshot savegame.
+ */
+void SilenceDebugOutput()
+{
+	_debug_silenced = true;
+}
+
 #if !defined(NO_DEBUG_MESSAGES)
 
 /**
@@ -107,6 +119,8 @@ char *DumpDebugFacilityNames(char *buf, char *last)
  */
 static void debug_print(const char *dbg, const char *buf)
 {
+	if (_debug_silenced) return;
+
 #if defined(ENABLE_NETWORK)
 	if (_debug_socket != INVALID_SOCKET) {
 		char buf2[1024 + 32];
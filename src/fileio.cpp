@@ -17,6 +17,7 @@
 #include "tar_type.h"
 #ifdef WIN32
 #include <windows.h>
+#include <io.h>
 # define access _taccess
 #elif defined(__HAIKU__)
 #include <Path.h>
@@ -28,6 +29,12 @@
 #include <sys/stat.h>
 #include <algorithm>
 
+#if !defined(WIN32) && defined(_POSIX_MAPPED_FILES) && _POSIX_MAPPED_FILES > 0
+#include <sys/mman.h>
+/** Files can be memory mapped via mmap. */
+#define FIO_MMAP
+#endif
+
 #ifdef WITH_XDG_BASEDIR
 #include "basedir.h"
 #endif
@@ -41,7 +48,11 @@ struct Fio {
 	size_t pos;                            ///< current (system) position in file
 	FILE *cur_fh;                          ///< current file handle
 	const char *filename;                  ///< current filename
+	const byte *cur_map;                   ///< contents of the current file when it is memory mapped, otherwise \c NULL
+	size_t cur_map_size;                   ///< size of #cur_map
 	FILE *handles[MAX_FILE_SLOTS];         ///< array of file handles we can have open
+	const byte *maps[MAX_FILE_SLOTS];      ///< contents of the files that are memory mapped
+	size_t map_sizes[MAX_FILE_SLOTS];      ///< sizes of #maps
 	byte buffer_start[FIO_BUFFER_SIZE];    ///< local buffer when read from file
 	const char *filenames[MAX_FILE_SLOTS]; ///< array of filenames we (should) have open
 	char *shortnames[MAX_FILE_SLOTS];      ///< array of short names for spriteloader's use
@@ -86,6 +97,19 @@ const char *FioGetFilename(uint8 slot)
 void FioSeekTo(size_t pos, int mode)
 {
 	if (mode == SEEK_CUR) pos += FioGetPos();
+
+	if (_fio.cur_map != NULL) {
+		/* The whole file acts as the buffer, so seeking is just moving within it. */
+		if (pos > _fio.cur_map_size) {
+			DEBUG(misc, 0, "Seeking in %s failed", _fio.filename);
+			pos = _fio.cur_map_size;
+		}
+		_fio.buffer = const_cast<byte *>(_fio.cur_map) + pos;
+		_fio.buffer_end = const_cast<byte *>(_fio.cur_map) + _fio.cur_map_size;
+		_fio.pos = _fio.cur_map_size;
+		return;
+	}
+
 	_fio.buffer = _fio.buffer_end = _fio.buffer_start + FIO_BUFFER_SIZE;
 	_fio.pos = pos;
 	if (fseek(_fio.cur_fh, _fio.pos, SEEK_SET) < 0) {
@@ -121,6 +145,8 @@ void FioSeekToFile(uint8 slot, size_t pos)
 	assert(f != NULL);
 	_fio.cur_fh = f;
 	_fio.filename = _fio.filenames[slot];
+	_fio.cur_map = _fio.maps[slot];
+	_fio.cur_map_size = _fio.map_sizes[slot];
 	FioSeekTo(pos, SEEK_SET);
 }
 
@@ -131,6 +157,9 @@ void FioSeekToFile(uint8 slot, size_t pos)
 byte FioReadByte()
 {
 	if (_fio.buffer == _fio.buffer_end) {
+		/* A memory mapped file is buffered completely; we are at its end. */
+		if (_fio.cur_map != NULL) return 0;
+
 		_fio.buffer = _fio.buffer_start;
 		size_t size = fread(_fio.buffer, 1, FIO_BUFFER_SIZE, _fio.cur_fh);
 		_fio.pos += size;
@@ -184,10 +213,34 @@ uint32 FioReadDword()
  */
 void FioReadBlock(void *ptr, size_t size)
 {
+	/* Copy from the buffer, which is the whole file if it is memory mapped. */
+	size_t buffered = _fio.buffer_end - _fio.buffer;
+	if (size <= buffered || _fio.cur_map != NULL) {
+		size = min(size, buffered);
+		memcpy(ptr, _fio.buffer, size);
+		_fio.buffer += size;
+		return;
+	}
+
 	FioSeekTo(FioGetPos(), SEEK_SET);
 	_fio.pos += fread(ptr, 1, size, _fio.cur_fh);
 }
 
+/**
+ * Get direct access to the rest of the current file, if it is memory mapped.
+ * The data can be read without going through the Fio buffer; the position in
+ * the file is not changed, so call #FioSkipBytes for the data that was read.
+ * @param[out] size Number of bytes from the current position to the end of the file.
+ * @return Pointer to the current position in the file, or \c NULL if the file is not memory mapped.
+ */
+const byte *FioGetMappedData(size_t *size)
+{
+	if (_fio.cur_map == NULL) return NULL;
+
+	*size = _fio.buffer_end - _fio.buffer;
+	return _fio.buffer;
+}
+
 /**
  * Close the file at the given slot number.
  * @param slot File index to close.
@@ -195,6 +248,17 @@ void FioReadBlock(void *ptr, size_t size)
 static inline void FioCloseFile(int slot)
 {
 	if (_fio.handles[slot] != NULL) {
+		if (_fio.maps[slot] != NULL) {
+#if defined(WIN32)
+			UnmapViewOfFile(_fio.maps[slot]);
+#elif defined(FIO_MMAP)
+			munmap(const_cast<byte *>(_fio.maps[slot]), _fio.map_sizes[slot]);
+#endif
+			if (_fio.cur_map == _fio.maps[slot]) _fio.cur_map = NULL;
+			_fio.maps[slot] = NULL;
+			_fio.map_sizes[slot] = 0;
+		}
+
 		fclose(_fio.handles[slot]);
 
 		free(_fio.shortnames[slot]);
@@ -239,6 +303,37 @@ static void FioFreeHandle()
 }
 #endif /* LIMITED_FDS */
 
+/**
+ * Map the contents of a slotted file into memory, so reading and seeking in
+ * it does not need any system calls. When mapping fails, the file is read
+ * via its file handle instead.
+ * @param slot The slot of the file.
+ */
+static void FioMapFile(int slot)
+{
+	FILE *f = _fio.handles[slot];
+	if (fseek(f, 0, SEEK_END) != 0) return;
+	long size = ftell(f);
+	if (size <= 0) return;
+
+	void *data = NULL;
+#if defined(WIN32)
+	HANDLE mapping = CreateFileMapping((HANDLE)_get_osfhandle(_fileno(f)), NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL) return;
+	/* The view keeps the mapping alive. */
+	data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+#elif defined(FIO_MMAP)
+	data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+	if (data == MAP_FAILED) data = NULL;
+#endif
+	if (data == NULL) return;
+
+	DEBUG(misc, 6, "Mapped file '%s' in slot '%d' into memory", _fio.filenames[slot], slot);
+	_fio.maps[slot] = (const byte *)data;
+	_fio.map_sizes[slot] = size;
+}
+
 /**
  * Open a slotted file.
  * @param slot Index to assign.
@@ -272,6 +367,7 @@ void FioOpenFile(int slot, const char *filename, Subdirectory subdir)
 	_fio.usage_count[slot] = 0;
 	_fio.open_handles++;
 #endif /* LIMITED_FDS */
+	FioMapFile(slot);
 	FioSeekToFile(slot, (uint32)pos);
 }
 
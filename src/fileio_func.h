@@ -25,6 +25,7 @@ uint32 FioReadDword();
 void FioCloseAll();
 void FioOpenFile(int slot, const char *filename, Subdirectory subdir);
 void FioReadBlock(void *ptr, size_t size);
+const byte *FioGetMappedData(size_t *size);
 void FioSkipBytes(int n);
 
 /**
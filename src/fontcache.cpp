@@ -483,14 +483,13 @@ const Sprite *FreeTypeFontCache::GetGlyph(GlyphID key)
 			};
 #undef CPSET
 #undef CP___
-			static const SpriteLoader::Sprite builtin_questionmark = {
-				10, // height
-				8,  // width
-				0,  // x_offs
-				0,  // y_offs
-				ST_FONT,
-				builtin_questionmark_data
-			};
+			SpriteLoader::Sprite builtin_questionmark;
+			builtin_questionmark.height = 10;
+			builtin_questionmark.width  = 8;
+			builtin_questionmark.x_offs = 0;
+			builtin_questionmark.y_offs = 0;
+			builtin_questionmark.type   = ST_FONT;
+			builtin_questionmark.data   = builtin_questionmark_data;
 
 			Sprite *spr = BlitterFactoryBase::GetCurrentBlitter()->Encode(&builtin_questionmark, AllocateFont);
 			assert(spr != NULL);
@@ -20,6 +20,7 @@
 #include "game_config.hpp"
 #include "game_instance.hpp"
 #include "game_info.hpp"
+#include "../tick_profiler.h"
 
 /* static */ uint Game::frame_counter = 0;
 /* static */ GameInfo *Game::info = NULL;
@@ -29,6 +30,8 @@
 
 /* static */ void Game::GameLoop()
 {
+	TickPhaseTimer timer(TPH_GAMESCRIPT);
+
 	if (_networking && !_network_server) return;
 	if (Game::instance == NULL) return;
 
@@ -48,7 +48,7 @@ static byte _stringwidth_table[FS_END][224]; ///< Cache containing width of ofte
 DrawPixelInfo *_cur_dpi;
 byte _colour_gradient[COLOUR_END][8];
 
-static void GfxMainBlitterViewport(const Sprite *sprite, int x, int y, BlitterMode mode, const SubSprite *sub = NULL, SpriteID sprite_id = SPR_CURSOR_MOUSE);
+static void GfxMainBlitterViewport(const DrawPixelInfo *dpi, const Sprite *sprite, int x, int y, BlitterMode mode, const byte *remap, const SubSprite *sub, SpriteID sprite_id);
 static void GfxMainBlitter(const Sprite *sprite, int x, int y, BlitterMode mode, const SubSprite *sub = NULL, SpriteID sprite_id = SPR_CURSOR_MOUSE, ZoomLevel zoom = ZOOM_LVL_NORMAL);
 
 static ReusableBuffer<uint8> _cursor_backup;
@@ -772,6 +772,47 @@ Dimension GetSpriteSize(SpriteID sprid, Point *offset, ZoomLevel zoom)
 	return d;
 }
 
+/**
+ * Look up what is needed to draw a sprite in a viewport.
+ * @param img        Image number to draw
+ * @param pal        Palette to use.
+ * @param[out] remap The colour remap to draw the sprite with, or NULL if it is not remapped.
+ * @return The sprite to draw; valid until the sprite cache evicts it.
+ */
+const Sprite *ResolveSpriteViewport(SpriteID img, PaletteID pal, const byte **remap)
+{
+	if (HasBit(img, PALETTE_MODIFIER_TRANSPARENT) || pal != PAL_NONE) {
+		*remap = GetNonSprite(GB(pal, 0, PALETTE_WIDTH), ST_RECOLOUR) + 1;
+	} else {
+		*remap = NULL;
+	}
+	return GetSprite(GB(img, 0, SPRITE_WIDTH), ST_NORMAL);
+}
+
+/**
+ * Draw a sprite in a viewport, which has been looked up by #ResolveSpriteViewport.
+ * This does not touch the sprite cache nor any other global drawing state, so
+ * different threads may draw into disjoint parts of the screen at once.
+ * @param dpi    Area to draw into.
+ * @param img    Image number to draw
+ * @param sprite The sprite of the image.
+ * @param remap  The colour remap of the image.
+ * @param x      Left coordinate of image in viewport, scaled by zoom
+ * @param y      Top coordinate of image in viewport, scaled by zoom
+ * @param sub    If available, draw only specified part of the sprite
+ */
+void DrawResolvedSpriteViewport(const DrawPixelInfo *dpi, SpriteID img, const Sprite *sprite, const byte *remap, int x, int y, const SubSprite *sub)
+{
+	SpriteID real_sprite = GB(img, 0, SPRITE_WIDTH);
+	if (HasBit(img, PALETTE_MODIFIER_TRANSPARENT)) {
+		GfxMainBlitterViewport(dpi, sprite, x, y, BM_TRANSPARENT, remap, sub, real_sprite);
+	} else if (remap != NULL) {
+		GfxMainBlitterViewport(dpi, sprite, x, y, BM_COLOUR_REMAP, remap, sub, real_sprite);
+	} else {
+		GfxMainBlitterViewport(dpi, sprite, x, y, BM_NORMAL, remap, sub, real_sprite);
+	}
+}
+
 /**
  * Draw a sprite in a viewport.
  * @param img  Image number to draw
@@ -782,16 +823,9 @@ Dimension GetSpriteSize(SpriteID sprid, Point *offset, ZoomLevel zoom)
  */
 void DrawSpriteViewport(SpriteID img, PaletteID pal, int x, int y, const SubSprite *sub)
 {
-	SpriteID real_sprite = GB(img, 0, SPRITE_WIDTH);
-	if (HasBit(img, PALETTE_MODIFIER_TRANSPARENT)) {
-		_colour_remap_ptr = GetNonSprite(GB(pal, 0, PALETTE_WIDTH), ST_RECOLOUR) + 1;
-		GfxMainBlitterViewport(GetSprite(real_sprite, ST_NORMAL), x, y, BM_TRANSPARENT, sub, real_sprite);
-	} else if (pal != PAL_NONE) {
-		_colour_remap_ptr = GetNonSprite(GB(pal, 0, PALETTE_WIDTH), ST_RECOLOUR) + 1;
-		GfxMainBlitterViewport(GetSprite(real_sprite, ST_NORMAL), x, y, BM_COLOUR_REMAP, sub, real_sprite);
-	} else {
-		GfxMainBlitterViewport(GetSprite(real_sprite, ST_NORMAL), x, y, BM_NORMAL, sub, real_sprite);
-	}
+	const byte *remap;
+	const Sprite *sprite = ResolveSpriteViewport(img, pal, &remap);
+	DrawResolvedSpriteViewport(_cur_dpi, img, sprite, remap, x, y, sub);
 }
 
 /**
@@ -817,9 +851,8 @@ void DrawSprite(SpriteID img, PaletteID pal, int x, int y, const SubSprite *sub,
 	}
 }
 
-static void GfxMainBlitterViewport(const Sprite *sprite, int x, int y, BlitterMode mode, const SubSprite *sub, SpriteID sprite_id)
+static void GfxMainBlitterViewport(const DrawPixelInfo *dpi, const Sprite *sprite, int x, int y, BlitterMode mode, const byte *remap, const SubSprite *sub, SpriteID sprite_id)
 {
-	const DrawPixelInfo *dpi = _cur_dpi;
 	Blitter::BlitterParams bp;
 
 	/* Amount of pixels to clip from the source sprite */
@@ -851,7 +884,7 @@ static void GfxMainBlitterViewport(const Sprite *sprite, int x, int y, BlitterMo
 
 	bp.dst = dpi->dst_ptr;
 	bp.pitch = dpi->pitch;
-	bp.remap = _colour_remap_ptr;
+	bp.remap = remap;
 
 	assert(sprite->width > 0);
 	assert(sprite->height > 0);
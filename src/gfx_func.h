@@ -46,6 +46,8 @@
 #include "strings_type.h"
 #include "string_type.h"
 
+struct Sprite;
+
 void GameLoop();
 
 void CreateConsole();
@@ -89,6 +91,8 @@ void RedrawScreenRect(int left, int top, int right, int bottom);
 void GfxScroll(int left, int top, int width, int height, int xo, int yo);
 
 Dimension GetSpriteSize(SpriteID sprid, Point *offset = NULL, ZoomLevel zoom = ZOOM_LVL_GUI);
+const Sprite *ResolveSpriteViewport(SpriteID img, PaletteID pal, const byte **remap);
+void DrawResolvedSpriteViewport(const DrawPixelInfo *dpi, SpriteID img, const Sprite *sprite, const byte *remap, int x, int y, const SubSprite *sub = NULL);
 void DrawSpriteViewport(SpriteID img, PaletteID pal, int x, int y, const SubSprite *sub = NULL);
 void DrawSprite(SpriteID img, PaletteID pal, int x, int y, const SubSprite *sub = NULL, ZoomLevel zoom = ZOOM_LVL_GUI);
 
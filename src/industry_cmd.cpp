@@ -40,6 +40,8 @@
 #include "core/backup_type.hpp"
 #include "object_base.h"
 #include "game/game.hpp"
+#include "spatial_index.h"
+#include "tick_profiler.h"
 
 #include "table/strings.h"
 #include "table/industry_land.h"
@@ -179,6 +181,7 @@ Industry::~Industry()
 
 	DeleteSubsidyWith(ST_INDUSTRY, this->index);
 	CargoPacket::InvalidateAllFrom(ST_INDUSTRY, this->index);
+	UpdateSpatialIndex(this, true);
 }
 
 /**
@@ -1150,6 +1153,8 @@ static void ProduceIndustryGoods(Industry *i)
 
 void OnTick_Industry()
 {
+	TickPhaseTimer timer(TPH_INDUSTRIES);
+
 	if (_industry_sound_ctr != 0) {
 		_industry_sound_ctr++;
 
@@ -1563,10 +1568,11 @@ static bool CheckIfCanLevelIndustryPlatform(TileIndex tile, DoCommandFlag flags,
 static CommandCost CheckIfFarEnoughFromConflictingIndustry(TileIndex tile, int type)
 {
 	const IndustrySpec *indspec = GetIndustrySpec(type);
-	const Industry *i;
-	FOR_ALL_INDUSTRIES(i) {
-		/* Within 14 tiles from another industry is considered close */
-		if (DistanceMax(tile, i->location.tile) > 14) continue;
+	/* Within 14 tiles from another industry is considered close */
+	std::vector<IndustryID> industries;
+	GetIndustrySpatialIndex().FindInSquare(tile, 14, &industries);
+	for (std::vector<IndustryID>::const_iterator it = industries.begin(); it != industries.end(); ++it) {
+		const Industry *i = Industry::Get(*it);
 
 		/* check if there are any conflicting industry types around */
 		if (i->type == indspec->conflicting[0] ||
@@ -1749,6 +1755,7 @@ static void DoCreateNewIndustry(Industry *i, TileIndex tile, IndustryType type,
 	if (GetIndustrySpec(i->type)->behaviour & INDUSTRYBEH_PLANT_ON_BUILT) {
 		for (uint j = 0; j != 50; j++) PlantRandomFarmField(i);
 	}
+	UpdateSpatialIndex(i);
 	InvalidateWindowData(WC_INDUSTRY_DIRECTORY, 0, 0);
 
 	Station::RecomputeIndustriesNearForAll();
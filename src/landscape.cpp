@@ -31,6 +31,7 @@
 #include "object_base.h"
 #include "company_func.h"
 #include "pathfinder/npf/aystar.h"
+#include "tick_profiler.h"
 #include <list>
 
 #include "table/strings.h"
@@ -713,20 +714,44 @@ CommandCost CmdClearArea(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 
 TileIndex _cur_tileloop_tile;
 
+/**
+ * Number of tiles the tile loop looks ahead to prefetch their data. The order
+ * of the tiles is pseudorandom, so without prefetching practically every tile
+ * costs a cache miss per plane of the map.
+ */
+static const uint TILE_LOOP_PREFETCH_DISTANCE = 16;
+
+/**
+ * Get the tile the tile loop visits after another tile.
+ * @param tile     The current tile.
+ * @param feedback The feedback term of the LFSR for the map size.
+ * @return The next tile.
+ */
+static inline TileIndex GetNextTileLoopTile(TileIndex tile, uint32 feedback)
+{
+	/* Get the next tile in sequence using a Galois LFSR. */
+	return (tile >> 1) ^ (-(int32)(tile & 1) & feedback);
+}
+
 /**
  * Gradually iterate over all tiles on the map, calling their TileLoopProcs once every 256 ticks.
  */
 void RunTileLoop()
 {
+	TickPhaseTimer timer(TPH_TILELOOP);
+
 	/* The pseudorandom sequence of tiles is generated using a Galois linear feedback
 	 * shift register (LFSR). This allows a deterministic pseudorandom ordering, but
 	 * still with minimal state and fast iteration. */
 
-	/* Maximal length LFSR feedback terms, from 12-bit (for 64x64 maps) to 22-bit (for 2048x2048 maps).
-	 * Extracted from http://www.ece.cmu.edu/~koopman/lfsr/ */
+	/* Maximal length LFSR feedback terms, from 12-bit (for 64x64 maps) to 26-bit (for 8192x8192 maps).
+	 * Up to 22-bit extracted from http://www.ece.cmu.edu/~koopman/lfsr/, the longer
+	 * ones have been checked to iterate over all non-zero states. */
 	static const uint32 feedbacks[] = {
-		0xD8F, 0x1296, 0x2496, 0x4357, 0x8679, 0x1030E, 0x206CD, 0x403FE, 0x807B8, 0x1004B2, 0x2006A8
+		0xD8F, 0x1296, 0x2496, 0x4357, 0x8679, 0x1030E, 0x206CD, 0x403FE, 0x807B8, 0x1004B2, 0x2006A8,
+		0x667C85, 0xA04A19, 0x14F2651, 0x2EECFBF
 	};
+	assert_compile(lengthof(feedbacks) == 2 * MAX_MAP_SIZE_BITS - 2 * MIN_MAP_SIZE_BITS + 1);
 	const uint32 feedback = feedbacks[MapLogX() + MapLogY() - 12];
 
 	/* We update every tile every 256 ticks, so divide the map size by 2^8 = 256 */
@@ -742,11 +767,26 @@ void RunTileLoop()
 		count--;
 	}
 
+	/* The tiles are processed strictly in sequence, as their tile loops have
+	 * side effects (random numbers, changes to neighbouring tiles) whose order
+	 * has to stay the same. Only the loading of the tiles is done ahead. */
+	TileIndex ahead = tile;
+	for (uint i = 0; i < TILE_LOOP_PREFETCH_DISTANCE; i++) {
+		_m.Prefetch(ahead);
+		_me.Prefetch(ahead);
+		ahead = GetNextTileLoopTile(ahead, feedback);
+	}
+
 	while (count--) {
-		_tile_type_procs[GetTileType(tile)]->tile_loop_proc(tile);
+		_m.Prefetch(ahead);
+		_me.Prefetch(ahead);
+		ahead = GetNextTileLoopTile(ahead, feedback);
+
+		/* The tile loop of void tiles does nothing, so do not bother calling it. */
+		TileType type = GetTileType(tile);
+		if (type != MP_VOID) _tile_type_procs[type]->tile_loop_proc(tile);
 
-		/* Get the next tile in sequence using a Galois LFSR. */
-		tile = (tile >> 1) ^ (-(int32)(tile & 1) & feedback);
+		tile = GetNextTileLoopTile(tile, feedback);
 	}
 
 	_cur_tileloop_tile = tile;
@@ -1298,6 +1338,8 @@ void OnTick_LinkGraph();
 
 void CallLandscapeTick()
 {
+	TickPhaseTimer timer(TPH_LANDSCAPE);
+
 	OnTick_Town();
 	OnTick_Trees();
 	OnTick_Station();
@@ -11,6 +11,26 @@
 
 #include "../stdafx.h"
 #include "flowmapper.h"
+#include "linkgraphschedule.h"
+
+/**
+ * Remove the local consumption shares marked as invalid from a node's flows
+ * and delete its paths. This only touches the given node, so it can be done
+ * for all nodes in parallel.
+ * @param job Pointer to the link graph job.
+ * @param node_id Node to finalize.
+ */
+static void FinalizeNodeProc(void *job, uint node_id)
+{
+	Node node = (*(LinkGraphJob *)job)[node_id];
+	node.Flows().FinalizeLocalConsumption(node.Station());
+	/* Clear paths. */
+	PathList &paths = node.Paths();
+	for (PathList::iterator i = paths.begin(); i != paths.end(); ++i) {
+		delete *i;
+	}
+	paths.clear();
+}
 
 /**
  * Map the paths generated by the MCF solver into flows associated with nodes.
@@ -48,15 +68,5 @@ void FlowMapper::Run(LinkGraphJob &job) const
 		}
 	}
 
-	for (NodeID node_id = 0; node_id < job.Size(); ++node_id) {
-		/* Remove local consumption shares marked as invalid. */
-		Node node = job[node_id];
-		node.Flows().FinalizeLocalConsumption(node.Station());
-		/* Clear paths. */
-		PathList &paths = node.Paths();
-		for (PathList::iterator i = paths.begin(); i != paths.end(); ++i) {
-			delete *i;
-		}
-		paths.clear();
-	}
+	LinkGraphSchedule::Instance()->GetWorkers()->ParallelFor(&FinalizeNodeProc, &job, job.Size());
 }
@@ -29,7 +29,6 @@ LinkGraphJob::LinkGraphJob(const LinkGraph &orig) :
 		 * This is on purpose. */
 		link_graph(orig),
 		settings(_settings_game.linkgraph),
-		thread(NULL),
 		join_date(_date + _settings_game.linkgraph.recalc_time)
 {
 }
@@ -39,7 +38,7 @@ LinkGraphJob::LinkGraphJob(const LinkGraph &orig) :
  */
 LinkGraphJob::~LinkGraphJob()
 {
-	assert(this->thread == NULL);
+	assert(!this->batch.IsActive());
 
 	/* Don't update stuff from other pools, when everything is being removed.
 	 * Accessing other pools may be invalid. */
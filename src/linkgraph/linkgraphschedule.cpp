@@ -15,84 +15,77 @@
 #include "demands.h"
 #include "mcf.h"
 #include "flowmapper.h"
+#include "../tick_profiler.h"
 
 /**
- * Spawn a thread if possible and run the link graph job in the thread. If
- * that's not possible run the job right now in the current thread.
+ * Hand the link graph job to the worker pool. If no threads are available
+ * the job will be run in the main thread once it is joined.
  * @param job Job to be executed.
  */
 void LinkGraphSchedule::SpawnThread(LinkGraphJob *job)
 {
-	if (!ThreadObject::New(&(LinkGraphSchedule::Run), job, &job->thread)) {
-		job->thread = NULL;
-		/* Of course this will hang a bit.
-		 * On the other hand, if you want to play games which make this hang noticably
-		 * on a platform without threads then you'll probably get other problems first.
-		 * OK:
-		 * If someone comes and tells me that this hangs for him/her, I'll implement a
-		 * smaller grained "Step" method for all handlers and add some more ticks where
-		 * "Step" is called. No problem in principle.
-		 */
-		LinkGraphSchedule::Run(job);
-	}
+	this->workers.Start(&job->batch, &LinkGraphSchedule::Run, job, 1);
 }
 
 /**
- * Join the calling thread with the given job's thread if threading is enabled.
- * @param job Job whose execution thread is to be joined.
+ * Wait for the given job to be finished by the worker pool.
+ * @param job Job whose execution is to be waited for.
  */
 void LinkGraphSchedule::JoinThread(LinkGraphJob *job)
 {
-	if (job->thread != NULL) {
-		job->thread->Join();
-		delete job->thread;
-		job->thread = NULL;
-	}
+	if (job->batch.IsActive()) this->workers.Wait(&job->batch);
 }
 
 /**
- * Start the next job in the schedule.
+ * Start the next jobs in the schedule; as many as the recalc_jobs setting allows.
  */
 void LinkGraphSchedule::SpawnNext()
 {
-	if (this->schedule.empty()) return;
-	LinkGraph *next = this->schedule.front();
-	assert(next == LinkGraph::Get(next->index));
-	this->schedule.pop_front();
-	if (LinkGraphJob::CanAllocateItem()) {
-		LinkGraphJob *job = new LinkGraphJob(*next);
-		this->SpawnThread(job);
-		this->running.push_back(job);
-	} else {
-		NOT_REACHED();
+	for (uint i = 0; i < _settings_game.linkgraph.recalc_jobs; i++) {
+		if (this->schedule.empty()) return;
+		LinkGraph *next = this->schedule.front();
+		assert(next == LinkGraph::Get(next->index));
+		this->schedule.pop_front();
+		if (LinkGraphJob::CanAllocateItem()) {
+			LinkGraphJob *job = new LinkGraphJob(*next);
+			this->SpawnThread(job);
+			this->running.push_back(job);
+		} else {
+			NOT_REACHED();
+		}
 	}
 }
 
 /**
- * Join the next finished job, if available.
+ * Join all jobs that are due. The recalc_jobs setting only limits how many
+ * jobs are spawned, so jobs never pile up if it is lowered.
+ * Which jobs are joined only depends on their join dates, never on whether
+ * their calculation has actually finished, so all clients join the same jobs.
  */
 void LinkGraphSchedule::JoinNext()
 {
-	if (this->running.empty()) return;
-	LinkGraphJob *next = this->running.front();
-	if (!next->IsFinished()) return;
-	this->running.pop_front();
-	LinkGraphID id = next->LinkGraphIndex();
-	this->JoinThread(next);
-	delete next;
-	if (LinkGraph::IsValidID(id)) {
-		LinkGraph *lg = LinkGraph::Get(id);
-		this->Unqueue(lg); // Unqueue to avoid double-queueing recycled IDs.
-		this->Queue(lg);
+	while (!this->running.empty()) {
+		LinkGraphJob *next = this->running.front();
+		if (!next->IsFinished()) return;
+		this->running.pop_front();
+		LinkGraphID id = next->LinkGraphIndex();
+		this->JoinThread(next);
+		delete next;
+		if (LinkGraph::IsValidID(id)) {
+			LinkGraph *lg = LinkGraph::Get(id);
+			this->Unqueue(lg); // Unqueue to avoid double-queueing recycled IDs.
+			this->Queue(lg);
+		}
 	}
 }
 
 /**
  * Run all handlers for the given Job. This method is tailored to
- * ThreadObject::New.
+ * WorkerPool::Start.
  * @param j Pointer to a link graph job.
+ * @param index Unused.
  */
-/* static */ void LinkGraphSchedule::Run(void *j)
+/* static */ void LinkGraphSchedule::Run(void *j, uint index)
 {
 	LinkGraphJob *job = (LinkGraphJob *)j;
 	LinkGraphSchedule *schedule = LinkGraphSchedule::Instance();
@@ -102,8 +95,8 @@ void LinkGraphSchedule::JoinNext()
 }
 
 /**
- * Start all threads in the running list. This is only useful for save/load.
- * Usually threads are started when the job is created.
+ * Hand all jobs in the running list to the worker pool. This is only useful
+ * for save/load. Usually jobs are started when they are created.
  */
 void LinkGraphSchedule::SpawnAll()
 {
@@ -149,6 +142,7 @@ LinkGraphSchedule::LinkGraphSchedule()
 	this->handlers[3] = new FlowMapper;
 	this->handlers[4] = new MCFHandler<MCF2ndPass>;
 	this->handlers[5] = new FlowMapper;
+	this->workers.SetWorkerCount(max(GetCPUCoreCount(), 1U));
 }
 
 /**
@@ -177,6 +171,8 @@ LinkGraphSchedule::~LinkGraphSchedule()
  */
 void OnTick_LinkGraph()
 {
+	TickPhaseTimer timer(TPH_LINKGRAPH);
+
 	if (_date_fract != LinkGraphSchedule::SPAWN_JOIN_TICK) return;
 	Date offset = _date % _settings_game.linkgraph.recalc_interval;
 	if (offset == 0) {
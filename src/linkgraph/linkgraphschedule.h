@@ -13,6 +13,7 @@
 #define LINKGRAPHSCHEDULE_H
 
 #include "linkgraph.h"
+#include "../thread/worker_pool.h"
 
 class LinkGraphJob;
 
@@ -47,6 +48,7 @@ protected:
 	ComponentHandler *handlers[6]; ///< Handlers to be run for each job.
 	GraphList schedule;            ///< Queue for new jobs.
 	JobList running;               ///< Currently running jobs.
+	WorkerPool workers;            ///< Threads the jobs are run in.
 
 	void SpawnThread(LinkGraphJob *job);
 	void JoinThread(LinkGraphJob *job);
@@ -56,9 +58,16 @@ public:
 	static const uint SPAWN_JOIN_TICK = 21; ///< Tick when jobs are spawned or joined every day.
 
 	static LinkGraphSchedule *Instance();
-	static void Run(void *j);
+	static void Run(void *j, uint index);
 	static void Clear();
 
+	/**
+	 * Get the pool of threads the jobs are run in. Handlers may use it to
+	 * split the work on a single job.
+	 * @return The worker pool.
+	 */
+	WorkerPool *GetWorkers() { return &this->workers; }
+
 	void SpawnNext();
 	void JoinNext();
 	void SpawnAll();
@@ -3,10 +3,12 @@
 #include "../stdafx.h"
 #include "../core/math_func.hpp"
 #include "mcf.h"
-#include <set>
 
 typedef std::map<NodeID, Path *> PathViaMap;
 
+static const uint FRONTIER_ARITY = 4;         ///< Number of children of each node in the frontier heap.
+static const uint NOT_IN_FRONTIER = UINT_MAX; ///< Frontier position of nodes that aren't in the frontier.
+
 /**
  * Distance-based annotation for use in the Dijkstra algorithm. This is close
  * to the original meaning of "annotation" in this context. Paths are rated
@@ -31,7 +33,7 @@ public:
 	inline uint GetAnnotation() const { return this->distance; }
 
 	/**
-	 * Comparator for std containers.
+	 * Comparator ordering annotations by how good they are; used for the Dijkstra frontier.
 	 */
 	struct Comparator {
 		bool operator()(const DistanceAnnotation *x, const DistanceAnnotation *y) const;
@@ -63,7 +65,7 @@ public:
 	inline int GetAnnotation() const { return this->GetCapacityRatio(); }
 
 	/**
-	 * Comparator for std containers.
+	 * Comparator ordering annotations by how good they are; used for the Dijkstra frontier.
 	 */
 	struct Comparator {
 		bool operator()(const CapacityAnnotation *x, const CapacityAnnotation *y) const;
@@ -226,10 +228,103 @@ bool CapacityAnnotation::IsBetter(const CapacityAnnotation *base, uint cap,
 	}
 }
 
+/**
+ * Move the path at the given position of the frontier towards the top until
+ * its parent is better than it.
+ * @tparam Tannotation Annotation the frontier is ordered by.
+ * @param pos Position of the path to be moved.
+ */
+template<class Tannotation>
+void MultiCommodityFlow::FrontierSiftUp(uint pos)
+{
+	typename Tannotation::Comparator better;
+	Tannotation *anno = static_cast<Tannotation *>(this->frontier[pos]);
+	while (pos > 0) {
+		uint parent = (pos - 1) / FRONTIER_ARITY;
+		if (!better(anno, static_cast<Tannotation *>(this->frontier[parent]))) break;
+		this->FrontierPlace(pos, this->frontier[parent]);
+		pos = parent;
+	}
+	this->FrontierPlace(pos, anno);
+}
+
+/**
+ * Move the path at the given position of the frontier towards the bottom
+ * until it's better than all of its children.
+ * @tparam Tannotation Annotation the frontier is ordered by.
+ * @param pos Position of the path to be moved.
+ */
+template<class Tannotation>
+void MultiCommodityFlow::FrontierSiftDown(uint pos)
+{
+	typename Tannotation::Comparator better;
+	uint size = (uint)this->frontier.size();
+	Tannotation *anno = static_cast<Tannotation *>(this->frontier[pos]);
+	for (;;) {
+		uint first = pos * FRONTIER_ARITY + 1;
+		if (first >= size) break;
+		uint last = min(first + FRONTIER_ARITY, size);
+		uint best = first;
+		for (uint child = first + 1; child < last; ++child) {
+			if (better(static_cast<Tannotation *>(this->frontier[child]),
+					static_cast<Tannotation *>(this->frontier[best]))) {
+				best = child;
+			}
+		}
+		if (!better(static_cast<Tannotation *>(this->frontier[best]), anno)) break;
+		this->FrontierPlace(pos, this->frontier[best]);
+		pos = best;
+	}
+	this->FrontierPlace(pos, anno);
+}
+
+/**
+ * Restore the frontier's order after an annotation has changed, or add it to
+ * the frontier again if it has already been visited.
+ * @tparam Tannotation Annotation the frontier is ordered by.
+ * @param anno Annotation that has changed.
+ */
+template<class Tannotation>
+void MultiCommodityFlow::FrontierUpdate(Tannotation *anno)
+{
+	NodeID node = anno->GetNode();
+	if (this->frontier_pos[node] == NOT_IN_FRONTIER) {
+		this->frontier.push_back(anno);
+		this->FrontierSiftUp<Tannotation>((uint)this->frontier.size() - 1);
+	} else {
+		/* The annotation may have become better or worse. */
+		this->FrontierSiftUp<Tannotation>(this->frontier_pos[node]);
+		this->FrontierSiftDown<Tannotation>(this->frontier_pos[node]);
+	}
+}
+
+/**
+ * Remove the best annotation from the frontier.
+ * @pre The frontier isn't empty.
+ * @tparam Tannotation Annotation the frontier is ordered by.
+ * @return The best annotation.
+ */
+template<class Tannotation>
+Tannotation *MultiCommodityFlow::FrontierPop()
+{
+	Tannotation *best = static_cast<Tannotation *>(this->frontier.front());
+	this->frontier_pos[best->GetNode()] = NOT_IN_FRONTIER;
+	Path *last = this->frontier.back();
+	this->frontier.pop_back();
+	if (!this->frontier.empty()) {
+		this->FrontierPlace(0, last);
+		this->FrontierSiftDown<Tannotation>(0);
+	}
+	return best;
+}
+
 /**
  * A slightly modified Dijkstra algorithm. Grades the paths not necessarily by
  * distance, but by the value Tannotation computes. It uses the max_saturation
- * setting to artificially decrease capacities.
+ * setting to artificially decrease capacities. The nodes still to be visited
+ * are kept in an indexed heap, ordered by Tannotation::Comparator. As that is a
+ * strict total order the nodes are visited in exactly the same order as they
+ * would be with any other ordered container.
  * @tparam Tannotation Annotation to be used.
  * @tparam Tedge_iterator Iterator to be used for getting outgoing edges.
  * @param source_node Node where the algorithm starts.
@@ -238,20 +333,24 @@ bool CapacityAnnotation::IsBetter(const CapacityAnnotation *base, uint cap,
 template<class Tannotation, class Tedge_iterator>
 void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths)
 {
-	typedef std::set<Tannotation *, typename Tannotation::Comparator> AnnoSet;
 	Tedge_iterator iter(this->job);
 	uint size = this->job.Size();
-	AnnoSet annos;
 	paths.resize(size, NULL);
+	this->frontier.resize(size);
+	this->frontier_pos.resize(size);
 	for (NodeID node = 0; node < size; ++node) {
 		Tannotation *anno = new Tannotation(node, node == source_node);
-		annos.insert(anno);
+		this->FrontierPlace(node, anno);
 		paths[node] = anno;
 	}
-	while (!annos.empty()) {
-		typename AnnoSet::iterator i = annos.begin();
-		Tannotation *source = *i;
-		annos.erase(i);
+	/* Build the heap bottom-up, starting at the last node with children. */
+	if (size > 1) {
+		for (uint pos = (size - 2) / FRONTIER_ARITY + 1; pos-- > 0;) {
+			this->FrontierSiftDown<Tannotation>(pos);
+		}
+	}
+	while (!this->frontier.empty()) {
+		Tannotation *source = this->FrontierPop<Tannotation>();
 		NodeID from = source->GetNode();
 		iter.SetNode(source_node, from);
 		for (NodeID to = iter.Next(); to != INVALID_NODE; to = iter.Next()) {
@@ -268,9 +367,8 @@ void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths)
 			uint distance = edge.Distance() + 1;
 			Tannotation *dest = static_cast<Tannotation *>(paths[to]);
 			if (dest->IsBetter(source, capacity, capacity - edge.Flow(), distance)) {
-				annos.erase(dest);
 				dest->Fork(source, capacity, capacity - edge.Flow(), distance);
-				annos.insert(dest);
+				this->FrontierUpdate(dest);
 			}
 		}
 	}
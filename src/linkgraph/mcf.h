@@ -24,12 +24,31 @@ protected:
 	template<class Tannotation, class Tedge_iterator>
 	void Dijkstra(NodeID from, PathVector &paths);
 
+	template<class Tannotation> void FrontierSiftUp(uint pos);
+	template<class Tannotation> void FrontierSiftDown(uint pos);
+	template<class Tannotation> void FrontierUpdate(Tannotation *anno);
+	template<class Tannotation> Tannotation *FrontierPop();
+
+	/**
+	 * Put a path at the given position in the frontier and remember that position.
+	 * @param pos Position in the frontier.
+	 * @param path Path to put there.
+	 */
+	inline void FrontierPlace(uint pos, Path *path)
+	{
+		this->frontier[pos] = path;
+		this->frontier_pos[path->GetNode()] = pos;
+	}
+
 	uint PushFlow(Edge &edge, Path *path, uint accuracy, uint max_saturation);
 
 	void CleanupPaths(NodeID source, PathVector &paths);
 
 	LinkGraphJob &job;   ///< Job we're working with.
 	uint max_saturation; ///< Maximum saturation for edges.
+
+	PathVector frontier;            ///< Heap of annotations Dijkstra still has to visit; reused between runs.
+	std::vector<uint> frontier_pos; ///< Position of each node in the frontier, or NOT_IN_FRONTIER.
 };
 
 /**
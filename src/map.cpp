@@ -12,6 +12,7 @@
 #include "stdafx.h"
 #include "debug.h"
 #include "core/alloc_func.hpp"
+#include "core/mem_func.hpp"
 #include "water_map.h"
 
 #if defined(_MSC_VER)
@@ -26,8 +27,8 @@ uint _map_size_y;    ///< Size of the map along the Y
 uint _map_size;      ///< The number of tiles on the map
 uint _map_tile_mask; ///< _map_size - 1 (to mask the mapsize)
 
-Tile *_m = NULL;          ///< Tiles of the map
-TileExtended *_me = NULL; ///< Extended Tiles of the map
+TileArray _m;          ///< Tiles of the map
+TileExtendedArray _me; ///< Extended Tiles of the map
 
 
 /**
@@ -55,11 +56,42 @@ void AllocateMap(uint size_x, uint size_y)
 	_map_size = size_x * size_y;
 	_map_tile_mask = _map_size - 1;
 
-	free(_m);
-	free(_me);
+	free(_m.type_height);
+	free(_m.m1);
+	free(_m.m2);
+	free(_m.m3);
+	free(_m.m4);
+	free(_m.m5);
+	free(_m.m6);
+	free(_me.m7);
+
+	_m.type_height = CallocT<byte>(_map_size);
+	_m.m1 = CallocT<byte>(_map_size);
+	_m.m2 = CallocT<uint16>(_map_size);
+	_m.m3 = CallocT<byte>(_map_size);
+	_m.m4 = CallocT<byte>(_map_size);
+	_m.m5 = CallocT<byte>(_map_size);
+	_m.m6 = CallocT<byte>(_map_size);
+	_me.m7 = CallocT<byte>(_map_size);
+}
 
-	_m = CallocT<Tile>(_map_size);
-	_me = CallocT<TileExtended>(_map_size);
+/**
+ * Clear all data, including the extended data, of a range of tiles.
+ * @param first The first tile to clear.
+ * @param count The number of tiles to clear.
+ */
+void ClearTiles(uint first, uint count)
+{
+	assert(first + count <= _map_size);
+
+	MemSetT(_m.type_height + first, 0, count);
+	MemSetT(_m.m1 + first, 0, count);
+	MemSetT(_m.m2 + first, 0, count);
+	MemSetT(_m.m3 + first, 0, count);
+	MemSetT(_m.m4 + first, 0, count);
+	MemSetT(_m.m5 + first, 0, count);
+	MemSetT(_m.m6 + first, 0, count);
+	MemSetT(_me.m7 + first, 0, count);
 }
 
 
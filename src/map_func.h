@@ -28,22 +28,23 @@ extern uint _map_tile_mask;
 #define TILE_MASK(x) ((x) & _map_tile_mask)
 
 /**
- * Pointer to the tile-array.
+ * The tile-array.
  *
- * This variable points to the tile-array which contains the tiles of
- * the map.
+ * This variable holds the planes which contain the tiles of the map.
+ * _m[tile] yields the data of a single tile.
  */
-extern Tile *_m;
+extern TileArray _m;
 
 /**
- * Pointer to the extended tile-array.
+ * The extended tile-array.
  *
- * This variable points to the extended tile-array which contains the tiles
- * of the map.
+ * This variable holds the planes which contain the extended data of the
+ * tiles of the map. _me[tile] yields the data of a single tile.
  */
-extern TileExtended *_me;
+extern TileExtendedArray _me;
 
 void AllocateMap(uint size_x, uint size_y);
+void ClearTiles(uint first, uint count);
 
 /**
  * Logarithm of the map size along the X side.
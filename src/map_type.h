@@ -13,25 +13,116 @@
 #define MAP_TYPE_H
 
 /**
- * Data that is stored per tile. Also used TileExtended for this.
+ * References to the data that is stored for a single tile; what _m[] yields.
+ * Also used TileExtended for this.
  * Look at docs/landscape.html for the exact meaning of the members.
  */
 struct Tile {
-	byte   type_height; ///< The type (bits 4..7) and height of the northern corner
-	byte   m1;          ///< Primarily used for ownership information
-	uint16 m2;          ///< Primarily used for indices to towns, industries and stations
-	byte   m3;          ///< General purpose
-	byte   m4;          ///< General purpose
-	byte   m5;          ///< General purpose
-	byte   m6;          ///< Primarily used for bridges and rainforest/desert
+	byte   &type_height; ///< The type (bits 4..7) and height of the northern corner
+	byte   &m1;          ///< Primarily used for ownership information
+	uint16 &m2;          ///< Primarily used for indices to towns, industries and stations
+	byte   &m3;          ///< General purpose
+	byte   &m4;          ///< General purpose
+	byte   &m5;          ///< General purpose
+	byte   &m6;          ///< Primarily used for bridges and rainforest/desert
+
+	/**
+	 * Create the references to a tile's data.
+	 * @param type_height The tile's entry in the type_height plane.
+	 * @param m1 The tile's entry in the m1 plane.
+	 * @param m2 The tile's entry in the m2 plane.
+	 * @param m3 The tile's entry in the m3 plane.
+	 * @param m4 The tile's entry in the m4 plane.
+	 * @param m5 The tile's entry in the m5 plane.
+	 * @param m6 The tile's entry in the m6 plane.
+	 */
+	inline Tile(byte &type_height, byte &m1, uint16 &m2, byte &m3, byte &m4, byte &m5, byte &m6) :
+			type_height(type_height), m1(m1), m2(m2), m3(m3), m4(m4), m5(m5), m6(m6) {}
+};
+
+/**
+ * The data of all tiles, stored as a structure of arrays. Every member of a
+ * tile lives in its own contiguous plane, so a sweep over one member of all
+ * tiles doesn't pull the other members into the cache.
+ */
+struct TileArray {
+	byte   *type_height; ///< Plane with the type and height of all tiles.
+	byte   *m1;          ///< Plane with the m1 of all tiles.
+	uint16 *m2;          ///< Plane with the m2 of all tiles.
+	byte   *m3;          ///< Plane with the m3 of all tiles.
+	byte   *m4;          ///< Plane with the m4 of all tiles.
+	byte   *m5;          ///< Plane with the m5 of all tiles.
+	byte   *m6;          ///< Plane with the m6 of all tiles.
+
+	/**
+	 * Get the data of a single tile.
+	 * @param tile The index of the tile.
+	 * @return References to the tile's data.
+	 */
+	inline Tile operator[](uint tile) const
+	{
+		return Tile(this->type_height[tile], this->m1[tile], this->m2[tile], this->m3[tile], this->m4[tile], this->m5[tile], this->m6[tile]);
+	}
+
+	/**
+	 * Ask the processor to start loading the data of a tile into the cache,
+	 * so it is there once the tile is used. Only a hint; it changes nothing.
+	 * @param tile The index of the tile.
+	 */
+	inline void Prefetch(uint tile) const
+	{
+#if defined(__GNUC__)
+		__builtin_prefetch(this->type_height + tile);
+		__builtin_prefetch(this->m1 + tile);
+		__builtin_prefetch(this->m2 + tile);
+		__builtin_prefetch(this->m3 + tile);
+		__builtin_prefetch(this->m4 + tile);
+		__builtin_prefetch(this->m5 + tile);
+		__builtin_prefetch(this->m6 + tile);
+#endif
+	}
 };
 
 /**
- * Data that is stored per tile. Also used Tile for this.
+ * References to the data that is stored for a single tile; what _me[] yields.
+ * Also used Tile for this.
  * Look at docs/landscape.html for the exact meaning of the members.
  */
 struct TileExtended {
-	byte m7; ///< Primarily used for newgrf support
+	byte &m7; ///< Primarily used for newgrf support
+
+	/**
+	 * Create the references to a tile's extended data.
+	 * @param m7 The tile's entry in the m7 plane.
+	 */
+	inline TileExtended(byte &m7) : m7(m7) {}
+};
+
+/** The extended data of all tiles, stored as a structure of arrays like TileArray. */
+struct TileExtendedArray {
+	byte *m7; ///< Plane with the m7 of all tiles.
+
+	/**
+	 * Get the extended data of a single tile.
+	 * @param tile The index of the tile.
+	 * @return References to the tile's extended data.
+	 */
+	inline TileExtended operator[](uint tile) const
+	{
+		return TileExtended(this->m7[tile]);
+	}
+
+	/**
+	 * Ask the processor to start loading the extended data of a tile into the cache.
+	 * @param tile The index of the tile.
+	 * @see TileArray::Prefetch
+	 */
+	inline void Prefetch(uint tile) const
+	{
+#if defined(__GNUC__)
+		__builtin_prefetch(this->m7 + tile);
+#endif
+	}
 };
 
 /**
@@ -57,11 +148,18 @@ struct TileIndexDiffC {
 	int16 y;        ///< The y value of the coordinate
 };
 
-/** Minimal and maximal map width and height */
+/**
+ * Minimal and maximal map width and height.
+ * Every tile costs 11 bytes that are all allocated up front: 9 bytes for the
+ * planes of the map and 2 bytes for the station catchment index. A map of
+ * 8192x8192 tiles therefore needs 704 MiB, plus 2 bytes per tile for the
+ * height map while its terrain is generated. 16384x16384 tiles would need
+ * 2816 MiB, which does not fit in the address space of 32 bit builds.
+ */
 static const uint MIN_MAP_SIZE_BITS = 6;                      ///< Minimal size of map is equal to 2 ^ MIN_MAP_SIZE_BITS
-static const uint MAX_MAP_SIZE_BITS = 11;                     ///< Maximal size of map is equal to 2 ^ MAX_MAP_SIZE_BITS
+static const uint MAX_MAP_SIZE_BITS = 13;                     ///< Maximal size of map is equal to 2 ^ MAX_MAP_SIZE_BITS
 static const uint MIN_MAP_SIZE      = 1 << MIN_MAP_SIZE_BITS; ///< Minimal map size = 64
-static const uint MAX_MAP_SIZE      = 1 << MAX_MAP_SIZE_BITS; ///< Maximal map size = 2048
+static const uint MAX_MAP_SIZE      = 1 << MAX_MAP_SIZE_BITS; ///< Maximal map size = 8192
 
 /**
  * Approximation of the length of a straight track, relative to a diagonal
@@ -28,6 +28,7 @@
 #include "core/pool_type.hpp"
 #include "game/game.hpp"
 #include "linkgraph/linkgraphschedule.h"
+#include "spatial_index.h"
 
 
 extern TileIndex _cur_tileloop_tile;
@@ -71,6 +72,7 @@ void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settin
 
 	LinkGraphSchedule::Clear();
 	PoolBase::Clean(PT_NORMAL);
+	InvalidateSpatialIndices();
 
 	ResetPersistentNewGRFData();
 
@@ -89,6 +91,7 @@ void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settin
 	InitializeAIGui();
 	InitializeTrees();
 	InitializeIndustries();
+	InitializeStationCatchmentIndex();
 	InitializeObjects();
 	InitializeBuildingCounts();
 
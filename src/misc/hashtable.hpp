@@ -175,7 +175,7 @@ public:
 	inline int Count() const {return m_num_items;}
 
 	/** simple clear - forget all items - used by CSegmentCostCacheT.Flush() */
-	inline void Clear() {for (int i = 0; i < Tcapacity; i++) m_slots[i].Clear();}
+	inline void Clear() {for (int i = 0; i < Tcapacity; i++) m_slots[i].Clear(); m_num_items = 0;}
 
 	/** const item search */
 	const Titem_ *Find(const Tkey& key) const
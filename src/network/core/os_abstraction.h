@@ -184,6 +184,18 @@ static inline void OTTDfreeaddrinfo(struct addrinfo *ai)
 #	include <errno.h>
 #	include <sys/time.h>
 #	include <netdb.h>
+
+/* Sending multiple packets with one system call. */
+#	if !defined(__MORPHOS__) && !defined(__AMIGA__) && !defined(__BEOS__)
+#		include <sys/uio.h>
+#		define HAVE_WRITEV
+#	endif
+
+/* Waiting for events on many sockets without passing all of them every time. */
+#	if defined(__linux__)
+#		include <sys/epoll.h>
+#		define HAVE_EPOLL
+#	endif
 #endif /* UNIX */
 
 #ifdef __BEOS__
@@ -15,9 +15,87 @@
 
 #include "../../stdafx.h"
 #include "../../string_func.h"
+#include "../../core/alloc_func.hpp"
+#include "../../core/math_func.hpp"
+#include "../../thread/thread.h"
 
 #include "packet.h"
 
+/** Storage of the buffer of a packet. */
+struct PacketBuffer {
+	PacketBuffer *next_free; ///< Next buffer in the pool, when this one is unused.
+	uint refs;               ///< Number of packets using this buffer.
+	byte data[SEND_MTU];     ///< The actual buffer.
+};
+
+/** Maximum number of unused buffers kept for reuse; more are given back to the heap. */
+static const uint MAX_POOLED_PACKET_BUFFERS = 512;
+
+/** Mutex guarding the pool; packets are made by the saving and UDP threads too. */
+static ThreadMutex *_packet_pool_mutex = ThreadMutex::New();
+static PacketBuffer *_packet_pool = NULL;  ///< Unused buffers, waiting to be reused.
+static PacketPoolStats _packet_pool_stats; ///< Statistics of the pool.
+
+/**
+ * Get a buffer for a new packet, preferably one from the pool.
+ * @return The buffer, used by a single packet.
+ */
+static PacketBuffer *AllocatePacketBuffer()
+{
+	_packet_pool_mutex->BeginCritical();
+	PacketBuffer *storage = _packet_pool;
+	if (storage != NULL) {
+		_packet_pool = storage->next_free;
+		_packet_pool_stats.pooled--;
+		_packet_pool_stats.reused++;
+	} else {
+		_packet_pool_stats.allocated++;
+	}
+	_packet_pool_stats.in_use++;
+	_packet_pool_stats.peak = max(_packet_pool_stats.peak, _packet_pool_stats.in_use);
+	_packet_pool_mutex->EndCritical();
+
+	if (storage == NULL) storage = MallocT<PacketBuffer>(1);
+	storage->next_free = NULL;
+	storage->refs = 1;
+	return storage;
+}
+
+/**
+ * Stop using a buffer; it's returned to the pool once no packet uses it anymore.
+ * @param storage The buffer.
+ */
+static void ReleasePacketBuffer(PacketBuffer *storage)
+{
+	_packet_pool_mutex->BeginCritical();
+	if (--storage->refs != 0) {
+		_packet_pool_mutex->EndCritical();
+		return;
+	}
+
+	_packet_pool_stats.in_use--;
+	bool keep = _packet_pool_stats.pooled < MAX_POOLED_PACKET_BUFFERS;
+	if (keep) {
+		storage->next_free = _packet_pool;
+		_packet_pool = storage;
+		_packet_pool_stats.pooled++;
+	}
+	_packet_pool_mutex->EndCritical();
+
+	if (!keep) free(storage);
+}
+
+/**
+ * Get the statistics of the pool of packet buffers.
+ * @param[out] stats The statistics.
+ */
+void GetPacketPoolStats(PacketPoolStats *stats)
+{
+	_packet_pool_mutex->BeginCritical();
+	*stats = _packet_pool_stats;
+	_packet_pool_mutex->EndCritical();
+}
+
 /**
  * Create a packet that is used to read from a network socket
  * @param cs the socket handler associated with the socket we are reading from
@@ -26,11 +104,12 @@ Packet::Packet(NetworkSocketHandler *cs)
 {
 	assert(cs != NULL);
 
-	this->cs     = cs;
-	this->next   = NULL;
-	this->pos    = 0; // We start reading from here
-	this->size   = 0;
-	this->buffer = MallocT<byte>(SEND_MTU);
+	this->cs      = cs;
+	this->next    = NULL;
+	this->pos     = 0; // We start reading from here
+	this->size    = 0;
+	this->storage = AllocatePacketBuffer();
+	this->buffer  = this->storage->data;
 }
 
 /**
@@ -45,16 +124,50 @@ Packet::Packet(PacketType type)
 	/* Skip the size so we can write that in before sending the packet */
 	this->pos                  = 0;
 	this->size                 = sizeof(PacketSize);
-	this->buffer               = MallocT<byte>(SEND_MTU);
+	this->storage              = AllocatePacketBuffer();
+	this->buffer               = this->storage->data;
 	this->buffer[this->size++] = type;
 }
 
 /**
- * Free the buffer of this packet.
+ * Creates a packet to send that uses the buffer of another packet.
+ * @param storage The buffer, with its reference already counted.
+ * @param size The size of the data in the buffer.
+ */
+Packet::Packet(PacketBuffer *storage, PacketSize size)
+{
+	this->cs      = NULL;
+	this->next    = NULL;
+	this->pos     = 0;
+	this->size    = size;
+	this->storage = storage;
+	this->buffer  = storage->data;
+}
+
+/**
+ * Give the buffer of this packet back to the pool, unless other packets still use it.
  */
 Packet::~Packet()
 {
-	free(this->buffer);
+	ReleasePacketBuffer(this->storage);
+}
+
+/**
+ * Make another packet with the same contents to send, without copying
+ * them; both packets use the same buffer. This way a packet can be sent
+ * to many sockets at once. Neither packet may be changed afterwards.
+ * @return The new packet.
+ */
+Packet *Packet::Share()
+{
+	assert(this->cs == NULL);
+
+	_packet_pool_mutex->BeginCritical();
+	this->storage->refs++;
+	_packet_pool_stats.shared++;
+	_packet_pool_mutex->EndCritical();
+
+	return new Packet(this->storage, this->size);
 }
 
 /**
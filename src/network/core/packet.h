@@ -23,6 +23,18 @@
 typedef uint16 PacketSize; ///< Size of the whole packet.
 typedef uint8  PacketType; ///< Identifier for the packet
 
+struct PacketBuffer;
+
+/** Statistics of the pool the buffers of packets are taken from. */
+struct PacketPoolStats {
+	uint allocated; ///< Number of buffers that have been allocated from the heap.
+	uint reused;    ///< Number of times a buffer from the pool has been reused.
+	uint shared;    ///< Number of packets that have been made sharing the buffer of another packet.
+	uint in_use;    ///< Number of buffers currently used by packets.
+	uint peak;      ///< Highest number of buffers used at the same time.
+	uint pooled;    ///< Number of buffers in the pool, waiting to be reused.
+};
+
 /**
  * Internal entity of a packet. As everything is sent as a packet,
  * all network communication will need to call the functions that
@@ -40,6 +52,8 @@ typedef uint8  PacketType; ///< Identifier for the packet
  *      Thus, the length of the strings is not sent.
  *  - years that are leap years in the 'days since X' to 'date' calculations:
  *     (year % 4 == 0) and ((year % 100 != 0) or (year % 400 == 0))
+ *  - buffers are taken from a pool and may be shared by multiple packets,
+ *      see Packet::Share; a shared packet must not be changed anymore.
  */
 struct Packet {
 	/** The next packet. Used for queueing packets before sending. */
@@ -52,18 +66,24 @@ struct Packet {
 	PacketSize size;
 	/** The current read/write position in the packet */
 	PacketSize pos;
-	/** The buffer of this packet, of basically variable length up to SEND_MTU. */
+	/** The buffer of this packet, of SEND_MTU bytes. */
 	byte *buffer;
 
 private:
 	/** Socket we're associated with. */
 	NetworkSocketHandler *cs;
+	/** The pooled storage #buffer points into. */
+	PacketBuffer *storage;
+
+	Packet(PacketBuffer *storage, PacketSize size);
 
 public:
 	Packet(NetworkSocketHandler *cs);
 	Packet(PacketType type);
 	~Packet();
 
+	Packet *Share();
+
 	/* Sending/writing of packets */
 	void PrepareToSend();
 
@@ -87,6 +107,8 @@ public:
 	void   Recv_string(char *buffer, size_t size, StringValidationSettings settings = SVS_REPLACE_WITH_QUESTION_MARK);
 };
 
+void GetPacketPoolStats(PacketPoolStats *stats);
+
 #endif /* ENABLE_NETWORK */
 
 #endif /* NETWORK_CORE_PACKET_H */
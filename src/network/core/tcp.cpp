@@ -18,6 +18,10 @@
 
 #include "tcp.h"
 
+#ifdef HAVE_WRITEV
+static const int SEND_PACKETS_PER_CALL = 64; ///< Maximum number of packets to hand to the OS with one system call.
+#endif
+
 /**
  * Construct a socket handler for a TCP connection.
  * @param s The just opened TCP connection.
@@ -25,7 +29,7 @@
 NetworkTCPSocketHandler::NetworkTCPSocketHandler(SOCKET s) :
 		NetworkSocketHandler(),
 		packet_queue(NULL), packet_recv(NULL),
-		sock(s), writable(false)
+		sock(s), writable(false), readable(false)
 {
 }
 
@@ -65,13 +69,10 @@ void NetworkTCPSocketHandler::SendPacket(Packet *packet)
 	Packet *p;
 	assert(packet != NULL);
 
+	/* The buffer is not shrunk to the size of the packet; it goes back to
+	 * the pool once sent, and it might be shared with other packets. */
 	packet->PrepareToSend();
 
-	/* Reallocate the packet as in 99+% of the times we send at most 25 bytes and
-	 * keeping the other 1400+ bytes wastes memory, especially when someone tries
-	 * to do a denial of service attack! */
-	packet->buffer = ReallocT(packet->buffer, packet->size);
-
 	/* Locate last packet buffered for the client */
 	p = this->packet_queue;
 	if (p == NULL) {
@@ -105,7 +106,18 @@ SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 
 	p = this->packet_queue;
 	while (p != NULL) {
+#ifdef HAVE_WRITEV
+		/* Hand as many packets as possible to the OS at once. */
+		struct iovec iov[SEND_PACKETS_PER_CALL];
+		int count = 0;
+		for (Packet *q = p; q != NULL && count < SEND_PACKETS_PER_CALL; q = q->next, count++) {
+			iov[count].iov_base = q->buffer + q->pos;
+			iov[count].iov_len = q->size - q->pos;
+		}
+		res = writev(this->sock, iov, count);
+#else
 		res = send(this->sock, (const char*)p->buffer + p->pos, p->size - p->pos, 0);
+#endif
 		if (res == -1) {
 			int err = GET_LAST_ERROR();
 			if (err != EWOULDBLOCK) {
@@ -116,6 +128,7 @@ SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 				}
 				return SPS_CLOSED;
 			}
+			this->writable = false;
 			return SPS_PARTLY_SENT;
 		}
 		if (res == 0) {
@@ -124,15 +137,18 @@ SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 			return SPS_CLOSED;
 		}
 
-		p->pos += res;
-
-		/* Is this packet sent? */
-		if (p->pos == p->size) {
-			/* Go to the next packet */
+		/* Go to the next packet for every packet that has been sent completely. */
+		while (res >= p->size - p->pos) {
+			res -= p->size - p->pos;
 			this->packet_queue = p->next;
 			delete p;
 			p = this->packet_queue;
-		} else {
+			if (p == NULL) return SPS_ALL_SENT;
+		}
+
+		if (res != 0) {
+			/* The OS' buffer is full; send the rest later. */
+			p->pos += res;
 			return SPS_PARTLY_SENT;
 		}
 	}
@@ -170,6 +186,7 @@ Packet *NetworkTCPSocketHandler::ReceivePacket()
 					return NULL;
 				}
 				/* Connection would block, so stop for now */
+				this->readable = false;
 				return NULL;
 			}
 			if (res == 0) {
@@ -201,6 +218,7 @@ Packet *NetworkTCPSocketHandler::ReceivePacket()
 				return NULL;
 			}
 			/* Connection would block */
+			this->readable = false;
 			return NULL;
 		}
 		if (res == 0) {
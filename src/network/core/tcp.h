@@ -35,6 +35,7 @@ private:
 public:
 	SOCKET sock;              ///< The socket currently connected to
 	bool writable;            ///< Can we write to this socket?
+	bool readable;            ///< May there be data to read from this socket? Only maintained when waiting for events with epoll.
 
 	/**
 	 * Whether this socket is currently bound to a socket.
@@ -63,6 +63,7 @@ enum PacketAdminType {
 	ADMIN_PACKET_SERVER_GAMESCRIPT,      ///< The server gives the admin information from the GameScript in JSON.
 	ADMIN_PACKET_SERVER_RCON_END,        ///< The server indicates that the remote console command has completed.
 	ADMIN_PACKET_SERVER_PONG,            ///< The server replies to a ping request from the admin.
+	ADMIN_PACKET_SERVER_PROFILE,         ///< The server gives the admin the time spent in the phases of the game loop.
 
 	INVALID_ADMIN_PACKET = 0xFF,         ///< An invalid marker for admin packets.
 };
@@ -86,6 +87,7 @@ enum AdminUpdateType {
 	ADMIN_UPDATE_CMD_NAMES,       ///< The admin would like a list of all DoCommand names.
 	ADMIN_UPDATE_CMD_LOGGING,     ///< The admin would like to have DoCommand information.
 	ADMIN_UPDATE_GAMESCRIPT,      ///< The admin would like to have gamescript messages.
+	ADMIN_UPDATE_PROFILE,         ///< Updates about the time spent in the phases of the game loop.
 	ADMIN_UPDATE_END,             ///< Must ALWAYS be on the end of this list!! (period)
 };
 
@@ -481,6 +483,27 @@ protected:
 	 */
 	virtual NetworkRecvStatus Receive_SERVER_RCON_END(Packet *p);
 
+	/**
+	 * Send the time spent in the phases of the game loop. All times are in
+	 * microseconds; averages are over the ticks measured.
+	 * uint32  Number of ticks measured.
+	 * uint8   Number of phases; then for each phase:
+	 *  string  Name of the phase.
+	 *  uint8   Index of the phase this phase is part of, or 0xFF for the game loop itself.
+	 *  uint64  Average time spent per tick.
+	 *  uint64  Longest time spent in a single tick.
+	 *  uint64  Time spent in the last tick.
+	 * Then for each company run by an AI:
+	 *  bool    Whether another company follows; when false, the packet ends.
+	 *  uint8   ID of the company.
+	 *  uint64  Average time spent per tick.
+	 *  uint64  Longest time spent in a single tick.
+	 *  uint64  Time spent in the last tick.
+	 * @param p The packet that was just received.
+	 * @return The state the network should have.
+	 */
+	virtual NetworkRecvStatus Receive_SERVER_PROFILE(Packet *p);
+
 	NetworkRecvStatus HandlePacket(Packet *p);
 public:
 	NetworkRecvStatus CloseConnection(bool error = true);
@@ -19,6 +19,7 @@
 #include "../../core/pool_type.hpp"
 #include "../../debug.h"
 #include "table/strings.h"
+#include <vector>
 
 #ifdef ENABLE_NETWORK
 
@@ -33,6 +34,85 @@ class TCPListenHandler {
 	/** List of sockets we listen on. */
 	static SocketList sockets;
 
+#ifdef HAVE_EPOLL
+	static int epoll_fd; ///< The epoll instance watching our sockets, or -1 when select is used instead.
+
+	/** Events epoll reported for a socket that have not been handled yet. */
+	enum ReadyFlags {
+		READY_READ  = 1 << 0, ///< Data has arrived.
+		READY_WRITE = 1 << 1, ///< Data can be sent again.
+	};
+
+	/**
+	 * Start watching a socket for events.
+	 * @param s The socket.
+	 * @param events The events to watch for.
+	 */
+	static void WatchSocket(SOCKET s, uint32 events)
+	{
+		struct epoll_event ev;
+		memset(&ev, 0, sizeof(ev));
+		ev.events = events;
+		ev.data.fd = s;
+		if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, s, &ev) < 0) {
+			DEBUG(net, 0, "[%s] epoll_ctl failed with error %d", Tsocket::GetName(), GET_LAST_ERROR());
+		}
+	}
+
+	/**
+	 * Handle the receiving of packets, based on the events reported by
+	 * epoll. Client sockets are watched edge triggered, so #writable and
+	 * #readable remain set until sending or receiving would block; the
+	 * sockets do not have to be passed to the OS every time.
+	 * @return true if everything went okay.
+	 */
+	static bool ReceiveEvents()
+	{
+		static std::vector<byte> ready; // Unhandled ReadyFlags of each socket.
+		bool accept = false;
+
+		struct epoll_event events[64];
+		int n;
+		do {
+			n = epoll_wait(epoll_fd, events, lengthof(events), 0); // don't block at all.
+			if (n < 0) return GET_LAST_ERROR() == EINTR;
+
+			for (int i = 0; i < n; i++) {
+				SOCKET s = events[i].data.fd;
+				bool listener = false;
+				for (SocketList::iterator it = sockets.Begin(); it != sockets.End(); it++) {
+					if (it->second == s) listener = true;
+				}
+				if (listener) {
+					accept = true;
+					continue;
+				}
+
+				if ((size_t)s >= ready.size()) ready.resize(s + 1, 0);
+				if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) ready[s] |= READY_READ;
+				if (events[i].events & EPOLLOUT) ready[s] |= READY_WRITE;
+			}
+		} while (n == (int)lengthof(events));
+
+		/* accept clients.. */
+		if (accept) {
+			for (SocketList::iterator s = sockets.Begin(); s != sockets.End(); s++) AcceptClient(s->second);
+		}
+
+		/* read stuff from clients */
+		Tsocket *cs;
+		FOR_ALL_ITEMS_FROM(Tsocket, idx, cs, 0) {
+			if ((size_t)cs->sock < ready.size()) {
+				if (ready[cs->sock] & READY_READ) cs->readable = true;
+				if (ready[cs->sock] & READY_WRITE) cs->writable = true;
+				ready[cs->sock] = 0;
+			}
+			if (cs->readable) cs->ReceivePackets();
+		}
+		return _networking;
+	}
+#endif /* HAVE_EPOLL */
+
 public:
 	/**
 	 * Accepts clients from the sockets.
@@ -90,6 +170,9 @@ public:
 			}
 
 			Tsocket::AcceptConnection(s, address);
+#ifdef HAVE_EPOLL
+			if (epoll_fd != -1) WatchSocket(s, EPOLLIN | EPOLLOUT | EPOLLET);
+#endif
 		}
 	}
 
@@ -99,6 +182,10 @@ public:
 	 */
 	static bool Receive()
 	{
+#ifdef HAVE_EPOLL
+		if (epoll_fd != -1) return ReceiveEvents();
+#endif
+
 		fd_set read_fd, write_fd;
 		struct timeval tv;
 
@@ -161,6 +248,15 @@ public:
 			return false;
 		}
 
+#ifdef HAVE_EPOLL
+		epoll_fd = epoll_create(MAX_CLIENT_SLOTS);
+		if (epoll_fd == -1) {
+			DEBUG(net, 1, "[%s] epoll_create failed with error %d, using select instead", Tsocket::GetName(), GET_LAST_ERROR());
+		} else {
+			for (SocketList::iterator s = sockets.Begin(); s != sockets.End(); s++) WatchSocket(s->second, EPOLLIN);
+		}
+#endif
+
 		return true;
 	}
 
@@ -171,11 +267,18 @@ public:
 			closesocket(s->second);
 		}
 		sockets.Clear();
+#ifdef HAVE_EPOLL
+		if (epoll_fd != -1) close(epoll_fd);
+		epoll_fd = -1;
+#endif
 		DEBUG(net, 1, "[%s] closed listeners", Tsocket::GetName());
 	}
 };
 
 template <class Tsocket, PacketType Tfull_packet, PacketType Tban_packet> SocketList TCPListenHandler<Tsocket, Tfull_packet, Tban_packet>::sockets;
+#ifdef HAVE_EPOLL
+template <class Tsocket, PacketType Tfull_packet, PacketType Tban_packet> int TCPListenHandler<Tsocket, Tfull_packet, Tban_packet>::epoll_fd = -1;
+#endif
 
 #endif /* ENABLE_NETWORK */
 
@@ -24,6 +24,7 @@
 #include "../map_func.h"
 #include "../rev.h"
 #include "../game/game.hpp"
+#include "../tick_profiler.h"
 
 
 /* This file handles all the admin network commands. */
@@ -54,6 +55,7 @@ static const AdminUpdateFrequency _admin_update_type_frequencies[] = {
 	ADMIN_FREQUENCY_POLL,                                                                                                                                  ///< ADMIN_UPDATE_CMD_NAMES
 	                       ADMIN_FREQUENCY_AUTOMATIC,                                                                                                      ///< ADMIN_UPDATE_CMD_LOGGING
 	                       ADMIN_FREQUENCY_AUTOMATIC,                                                                                                      ///< ADMIN_UPDATE_GAMESCRIPT
+	ADMIN_FREQUENCY_POLL | ADMIN_FREQUENCY_DAILY | ADMIN_FREQUENCY_WEEKLY | ADMIN_FREQUENCY_MONTHLY | ADMIN_FREQUENCY_QUARTERLY | ADMIN_FREQUENCY_ANUALLY, ///< ADMIN_UPDATE_PROFILE
 };
 /** Sanity check. */
 assert_compile(lengthof(_admin_update_type_frequencies) == ADMIN_UPDATE_END);
@@ -608,6 +610,47 @@ NetworkRecvStatus ServerNetworkAdminSocketHandler::SendPong(uint32 d1)
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
+/**
+ * Send a single line of timings of the game loop.
+ * @param p     The packet to add the timings to.
+ * @param stats The timings.
+ * @param ticks Number of ticks measured.
+ */
+static void SendTickPhaseStats(Packet *p, const TickPhaseStats &stats, uint32 ticks)
+{
+	p->Send_uint64(ticks == 0 ? 0 : stats.total / ticks);
+	p->Send_uint64(stats.max);
+	p->Send_uint64(stats.last);
+}
+
+/** Send the time spent in the phases of the game loop. */
+NetworkRecvStatus ServerNetworkAdminSocketHandler::SendProfile()
+{
+	Packet *p = new Packet(ADMIN_PACKET_SERVER_PROFILE);
+
+	const TickProfile &profile = GetTickProfile();
+	p->Send_uint32(profile.ticks);
+	p->Send_uint8(TPH_END);
+	for (TickPhase phase = TPH_GAMELOOP; phase < TPH_END; phase++) {
+		p->Send_string(GetTickPhaseName(phase));
+		p->Send_uint8(GetTickPhaseParent(phase));
+		SendTickPhaseStats(p, profile.phases[phase], profile.ticks);
+	}
+
+	const Company *c;
+	FOR_ALL_COMPANIES(c) {
+		if (!c->is_ai) continue;
+		p->Send_bool(true);
+		p->Send_uint8(c->index);
+		SendTickPhaseStats(p, profile.ai_companies[c->index], profile.ticks);
+	}
+	p->Send_bool(false);
+
+	this->SendPacket(p);
+
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
 /** Send the names of the commands. */
 NetworkRecvStatus ServerNetworkAdminSocketHandler::SendCmdNames()
 {
@@ -776,6 +819,11 @@ NetworkRecvStatus ServerNetworkAdminSocketHandler::Receive_ADMIN_POLL(Packet *p)
 			this->SendCmdNames();
 			break;
 
+		case ADMIN_UPDATE_PROFILE:
+			/* The admin is requesting the timings of the game loop. */
+			this->SendProfile();
+			break;
+
 		default:
 			/* An unsupported "poll" update type. */
 			DEBUG(net, 3, "[admin] Not supported poll %d (%d) from '%s' (%s).", type, d1, this->admin_name, this->admin_version);
@@ -1037,6 +1085,10 @@ void NetworkAdminUpdate(AdminUpdateFrequency freq)
 						as->SendCompanyStats();
 						break;
 
+					case ADMIN_UPDATE_PROFILE:
+						as->SendProfile();
+						break;
+
 					default: NOT_REACHED();
 				}
 			}
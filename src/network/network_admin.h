@@ -72,6 +72,7 @@ public:
 	NetworkRecvStatus SendCmdNames();
 	NetworkRecvStatus SendCmdLogging(ClientID client_id, const CommandPacket *cp);
 	NetworkRecvStatus SendRconEnd(const char *command);
+	NetworkRecvStatus SendProfile();
 
 	static void Send();
 	static void AcceptConnection(SOCKET s, const NetworkAddress &address);
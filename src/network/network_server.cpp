@@ -52,164 +52,224 @@ INSTANTIATE_POOL_METHODS(NetworkClientSocket)
 /** Instantiate the listen sockets. */
 template SocketList TCPListenHandler<ServerNetworkGameSocketHandler, PACKET_SERVER_FULL, PACKET_SERVER_BANNED>::sockets;
 
-/** Writing a savegame directly to a number of packets. */
-struct PacketWriter : SaveFilter {
-	ServerNetworkGameSocketHandler *cs; ///< Socket we are associated with.
-	Packet *current;                    ///< The packet we're currently writing to.
-	size_t total_size;                  ///< Total size of the compressed savegame.
-	Packet *packets;                    ///< Packet queue of the savegame; send these "slowly" to the client.
-	ThreadMutex *mutex;                 ///< Mutex for making threaded saving safe.
+/**
+ * A compressed savegame split into packets. It is made once and shared by
+ * all clients that download the map at about the same time; every client
+ * keeps track of how far it got itself. The snapshot is freed once the
+ * last user, i.e. a client, the saving thread or the server, releases it.
+ */
+struct NetworkMapSnapshot {
+	uint32 frame;           ///< The frame the savegame was made at.
+	CommandQueue commands;  ///< Commands to execute after #frame: those that were pending and those distributed since. Main thread only.
+	uint clients;           ///< Number of clients downloading the snapshot. Main thread only.
+
+private:
+	ThreadMutex *mutex;                ///< Mutex guarding the state written by the saving thread.
+	SmallVector<Packet *, 64> packets; ///< The packets of the savegame, ending with a #PACKET_SERVER_MAP_DONE one once saving has finished.
+	size_t total_size;                 ///< Total size of the compressed savegame; only valid once finished.
+	uint refs;                         ///< Number of users of the snapshot.
+
+	/** Free the packets; only via #Release. */
+	~NetworkMapSnapshot()
+	{
+		for (Packet **p = this->packets.Begin(); p != this->packets.End(); p++) delete *p;
+		delete this->mutex;
+	}
 
+public:
 	/**
-	 * Create the packet writer.
-	 * @param cs The socket handler we're making the packets for.
+	 * Create a snapshot of the current frame, without any packets yet.
+	 * It starts with a single reference, for the server.
 	 */
-	PacketWriter(ServerNetworkGameSocketHandler *cs) : SaveFilter(NULL), cs(cs), current(NULL), total_size(0), packets(NULL)
+	NetworkMapSnapshot() : frame(_frame_counter), clients(0), mutex(ThreadMutex::New()), total_size(0), refs(1)
 	{
-		this->mutex = ThreadMutex::New();
+		NetworkSyncCommandQueue(&this->commands);
 	}
 
-	/** Make sure everything is cleaned up. */
-	~PacketWriter()
+	/** Add a user of the snapshot. */
+	void AddRef()
 	{
-		if (this->mutex != NULL) this->mutex->BeginCritical();
-
-		if (this->cs != NULL && this->mutex != NULL) {
-			this->mutex->WaitForSignal();
-		}
-
-		/* This must all wait until the Destroy function is called. */
-
-		while (this->packets != NULL) {
-			Packet *p = this->packets->next;
-			delete this->packets;
-			this->packets = p;
-		}
-
-		delete this->current;
+		this->mutex->BeginCritical();
+		this->refs++;
+		this->mutex->EndCritical();
+	}
 
-		if (this->mutex != NULL) this->mutex->EndCritical();
+	/** Remove a user of the snapshot, freeing it when it was the last one. */
+	void Release()
+	{
+		this->mutex->BeginCritical();
+		bool last = --this->refs == 0;
+		this->mutex->EndCritical();
 
-		delete this->mutex;
-		this->mutex = NULL;
+		if (last) delete this;
 	}
 
 	/**
-	 * Begin the destruction of this packet writer. It can happen in two ways:
-	 * in the first case the client disconnected while saving the map. In this
-	 * case the saving has not finished and killed this PacketWriter. In that
-	 * case we simply set cs to NULL, triggering the appending to fail due to
-	 * the connection problem and eventually triggering the destructor. In the
-	 * second case the destructor is already called, and it is waiting for our
-	 * signal which we will send. Only then the packets will be removed by the
-	 * destructor.
+	 * Check whether only the saving thread still uses the snapshot.
+	 * @return True if nobody is interested in the savegame anymore.
 	 */
-	void Destroy()
+	bool IsAbandoned()
 	{
-		if (this->mutex != NULL) this->mutex->BeginCritical();
-
-		this->cs = NULL;
-
-		if (this->mutex != NULL) this->mutex->SendSignal();
+		this->mutex->BeginCritical();
+		bool abandoned = this->refs == 1;
+		this->mutex->EndCritical();
+		return abandoned;
+	}
 
-		if (this->mutex != NULL) this->mutex->EndCritical();
+	/**
+	 * Add a packet with savegame data to the snapshot.
+	 * @param p The packet.
+	 */
+	void Append(Packet *p)
+	{
+		this->mutex->BeginCritical();
+		*this->packets.Append() = p;
+		this->mutex->EndCritical();
+	}
 
-		/* Make sure the saving is completely cancelled. Yes,
-		 * we need to handle the save finish as well as the
-		 * next connection might just be requesting a map. */
-		WaitTillSaved();
-		ProcessAsyncSaveFinish();
+	/**
+	 * Mark the savegame complete, i.e. add the packet stating this is the end.
+	 * @param total_size The size of the compressed savegame.
+	 */
+	void Finish(size_t total_size)
+	{
+		this->mutex->BeginCritical();
+		this->total_size = total_size;
+		*this->packets.Append() = new Packet(PACKET_SERVER_MAP_DONE);
+		this->mutex->EndCritical();
 	}
 
 	/**
-	 * Checks whether there are packets.
-	 * It's not 100% threading safe, but this is only asked for when checking
-	 * whether there still is something to send. Then another call will be made
-	 * to actually get the Packet, which will be the only one popping packets
-	 * and thus eventually setting this on false.
+	 * Get the size of the savegame, when saving has finished.
+	 * @param[out] total_size The size of the compressed savegame.
+	 * @return False if saving has not finished yet.
 	 */
-	bool HasPackets()
+	bool GetTotalSize(size_t *total_size)
 	{
-		return this->packets != NULL;
+		this->mutex->BeginCritical();
+		bool finished = this->packets.Length() != 0 && this->packets[this->packets.Length() - 1]->buffer[2] == PACKET_SERVER_MAP_DONE;
+		*total_size = this->total_size;
+		this->mutex->EndCritical();
+		return finished;
 	}
 
 	/**
-	 * Pop a single created packet from the queue with packets.
+	 * Get a packet of the snapshot to send to a client. It shares the buffer
+	 * of the packet in the snapshot, so nothing is copied.
+	 * @param index The index of the packet.
+	 * @return The packet, or \c NULL when the packet has not been made yet.
 	 */
-	Packet *PopPacket()
+	Packet *SharePacket(uint index)
 	{
-		if (this->mutex != NULL) this->mutex->BeginCritical();
+		this->mutex->BeginCritical();
+		Packet *src = index < this->packets.Length() ? this->packets[index] : NULL;
+		this->mutex->EndCritical();
 
-		Packet *p = this->packets;
-		this->packets = p->next;
-		p->next = NULL;
+		/* Packets are never changed once they are in the snapshot. */
+		return src == NULL ? NULL : src->Share();
+	}
+};
 
-		if (this->mutex != NULL) this->mutex->EndCritical();
+/** The snapshot clients that start downloading the map are given, or \c NULL when a new one has to be made. */
+static NetworkMapSnapshot *_network_map_snapshot = NULL;
 
-		return p;
-	}
+/**
+ * Stop handing out the current map snapshot to clients that start downloading.
+ */
+static void RetireMapSnapshot()
+{
+	if (_network_map_snapshot == NULL) return;
 
-	/** Append the current packet to the queue. */
-	void AppendQueue()
-	{
-		if (this->current == NULL) return;
+	_network_map_snapshot->Release();
+	_network_map_snapshot = NULL;
+}
 
-		Packet **p = &this->packets;
-		while (*p != NULL) {
-			p = &(*p)->next;
-		}
-		*p = this->current;
+/**
+ * Remember a command that is distributed to the clients, so clients that start
+ * downloading the current map snapshot later on execute it as well.
+ * @param cp The distributed command.
+ */
+void NetworkRecordMapSnapshotCommand(const CommandPacket &cp)
+{
+	if (_network_map_snapshot == NULL) return;
 
-		this->current = NULL;
-	}
+	CommandPacket c = cp;
+	c.callback = 0;
+	c.my_cmd = false;
+	_network_map_snapshot->commands.Append(&c);
+}
 
-	/* virtual */ void Write(byte *buf, size_t size)
+/**
+ * Stop sending the map snapshot to a client.
+ * @param cs The client that downloaded, or was downloading, the map.
+ */
+static void ReleaseMapSnapshot(ServerNetworkGameSocketHandler *cs)
+{
+	NetworkMapSnapshot *snapshot = cs->savegame;
+	cs->savegame = NULL;
+
+	/* Clients that start downloading later are better off with a fresh snapshot. */
+	if (--snapshot->clients == 0 && snapshot == _network_map_snapshot) RetireMapSnapshot();
+	snapshot->Release();
+}
+
+/** Writing a savegame directly to the packets of a map snapshot. */
+struct PacketWriter : SaveFilter {
+	NetworkMapSnapshot *snapshot; ///< The snapshot we're writing.
+	Packet *current;              ///< The packet we're currently writing to.
+	size_t total_size;            ///< Total size of the compressed savegame.
+
+	/**
+	 * Create the packet writer.
+	 * @param snapshot The snapshot to write to.
+	 */
+	PacketWriter(NetworkMapSnapshot *snapshot) : SaveFilter(NULL), snapshot(snapshot), current(NULL), total_size(0)
 	{
-		/* We want to abort the saving when the socket is closed. */
-		if (this->cs == NULL) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
+		this->snapshot->AddRef();
+	}
 
-		if (this->current == NULL) this->current = new Packet(PACKET_SERVER_MAP_DATA);
+	/** Make sure everything is cleaned up. */
+	~PacketWriter()
+	{
+		delete this->current;
+		this->snapshot->Release();
+	}
 
-		if (this->mutex != NULL) this->mutex->BeginCritical();
+	/* virtual */ void Write(byte *buf, size_t size)
+	{
+		/* We want to abort the saving when nobody wants the map anymore. */
+		if (this->snapshot->IsAbandoned()) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
 
 		byte *bufe = buf + size;
 		while (buf != bufe) {
+			if (this->current == NULL) this->current = new Packet(PACKET_SERVER_MAP_DATA);
+
 			size_t to_write = min(SEND_MTU - this->current->size, bufe - buf);
 			memcpy(this->current->buffer + this->current->size, buf, to_write);
 			this->current->size += (PacketSize)to_write;
 			buf += to_write;
 
 			if (this->current->size == SEND_MTU) {
-				this->AppendQueue();
-				if (buf != bufe) this->current = new Packet(PACKET_SERVER_MAP_DATA);
+				this->snapshot->Append(this->current);
+				this->current = NULL;
 			}
 		}
 
-		if (this->mutex != NULL) this->mutex->EndCritical();
-
 		this->total_size += size;
 	}
 
 	/* virtual */ void Finish()
 	{
-		/* We want to abort the saving when the socket is closed. */
-		if (this->cs == NULL) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
-
-		if (this->mutex != NULL) this->mutex->BeginCritical();
+		/* We want to abort the saving when nobody wants the map anymore. */
+		if (this->snapshot->IsAbandoned()) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
 
 		/* Make sure the last packet is flushed. */
-		this->AppendQueue();
-
-		/* Add a packet stating that this is the end to the queue. */
-		this->current = new Packet(PACKET_SERVER_MAP_DONE);
-		this->AppendQueue();
-
-		/* Fast-track the size to the client. */
-		Packet *p = new Packet(PACKET_SERVER_MAP_SIZE);
-		p->Send_uint32((uint32)this->total_size);
-		this->cs->NetworkTCPSocketHandler::SendPacket(p);
+		if (this->current != NULL) {
+			this->snapshot->Append(this->current);
+			this->current = NULL;
+		}
 
-		if (this->mutex != NULL) this->mutex->EndCritical();
+		this->snapshot->Finish(this->total_size);
 	}
 };
 
@@ -238,10 +298,7 @@ ServerNetworkGameSocketHandler::~ServerNetworkGameSocketHandler()
 	if (_redirect_console_to_client == this->client_id) _redirect_console_to_client = INVALID_CLIENT_ID;
 	OrderBackup::ResetUser(this->client_id);
 
-	if (this->savegame != NULL) {
-		this->savegame->Destroy();
-		this->savegame = NULL;
-	}
+	if (this->savegame != NULL) ReleaseMapSnapshot(this);
 }
 
 Packet *ServerNetworkGameSocketHandler::ReceivePacket()
@@ -551,63 +608,80 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendWelcome()
 	return this->SendClientInfo(NetworkClientInfo::GetByClientID(CLIENT_ID_SERVER));
 }
 
-/** Tell the client that its put in a waiting queue. */
-NetworkRecvStatus ServerNetworkGameSocketHandler::SendWait()
-{
-	int waiting = 0;
-	NetworkClientSocket *new_cs;
-	Packet *p;
-
-	/* Count how many clients are waiting in the queue, in front of you! */
-	FOR_ALL_CLIENT_SOCKETS(new_cs) {
-		if (new_cs->status != STATUS_MAP_WAIT) continue;
-		if (new_cs->GetInfo()->join_date < this->GetInfo()->join_date || (new_cs->GetInfo()->join_date == this->GetInfo()->join_date && new_cs->client_id < this->client_id)) waiting++;
-	}
-
-	p = new Packet(PACKET_SERVER_WAIT);
-	p->Send_uint8(waiting);
-	this->SendPacket(p);
-	return NETWORK_RECV_STATUS_OKAY;
-}
-
 /** This sends the map to the client */
 NetworkRecvStatus ServerNetworkGameSocketHandler::SendMap()
 {
-	static uint sent_packets; // How many packets we did send successfully last time
-
 	if (this->status < STATUS_AUTHORIZED) {
 		/* Illegal call, return error and ignore the packet */
 		return this->SendError(NETWORK_ERROR_NOT_AUTHORIZED);
 	}
 
-	if (this->status == STATUS_AUTHORIZED) {
-		this->savegame = new PacketWriter(this);
+	if (this->status == STATUS_AUTHORIZED || this->status == STATUS_MAP_WAIT) {
+		/* Every frame the snapshot is older has to be caught up with after loading it. */
+		if (_network_map_snapshot != NULL && _frame_counter - _network_map_snapshot->frame > _settings_client.network.max_join_time / 2U) {
+			RetireMapSnapshot();
+		}
+
+		bool make_snapshot = _network_map_snapshot == NULL;
+		if (make_snapshot && IsSaveInProgress()) {
+			/* Don't block the server until the other savegame is written;
+			 * the snapshot is made on one of the next ticks instead. */
+			this->status = STATUS_MAP_WAIT;
+			return NETWORK_RECV_STATUS_OKAY;
+		}
+
+		if (make_snapshot) _network_map_snapshot = new NetworkMapSnapshot();
 
-		/* Now send the _frame_counter and how many packets are coming */
+		this->savegame = _network_map_snapshot;
+		this->savegame->AddRef();
+		this->savegame->clients++;
+		this->savegame_packets = 0;
+		this->savegame_window = 4; // We start with trying 4 packets
+		this->savegame_size_sent = false;
+		this->map_bytes_sent = 0;
+		this->map_start_tick = _realtime_tick;
+
+		/* Now send the frame of the savegame and how many packets are coming */
 		Packet *p = new Packet(PACKET_SERVER_MAP_BEGIN);
-		p->Send_uint32(_frame_counter);
+		p->Send_uint32(this->savegame->frame);
 		this->SendPacket(p);
 
-		NetworkSyncCommandQueue(this);
+		/* The commands since that frame have to be executed by the client as well. */
+		for (CommandPacket *cp = this->savegame->commands.Peek(); cp != NULL; cp = cp->next) {
+			this->outgoing_queue.Append(cp);
+		}
 		this->status = STATUS_MAP;
 		/* Mark the start of download */
 		this->last_frame = _frame_counter;
 		this->last_frame_server = _frame_counter;
 
-		sent_packets = 4; // We start with trying 4 packets
-
 		/* Make a dump of the current game */
-		if (SaveWithFilter(this->savegame, true) != SL_OK) usererror("network savedump failed");
+		if (make_snapshot) {
+			if (SaveWithFilter(new PacketWriter(this->savegame), true) != SL_OK) usererror("network savedump failed");
+		}
 	}
 
 	if (this->status == STATUS_MAP) {
 		bool last_packet = false;
 		bool has_packets = false;
 
-		for (uint i = 0; (has_packets = this->savegame->HasPackets()) && i < sent_packets; i++) {
-			Packet *p = this->savegame->PopPacket();
+		for (uint i = 0; i < this->savegame_window; i++) {
+			Packet *p = this->savegame->SharePacket(this->savegame_packets);
+			if (!(has_packets = p != NULL)) break;
+
 			last_packet = p->buffer[2] == PACKET_SERVER_MAP_DONE;
 
+			/* Send the size as soon as it is known, but always before the end. */
+			size_t total_size;
+			if (!this->savegame_size_sent && this->savegame->GetTotalSize(&total_size)) {
+				Packet *size = new Packet(PACKET_SERVER_MAP_SIZE);
+				size->Send_uint32((uint32)total_size);
+				this->SendPacket(size);
+				this->savegame_size_sent = true;
+			}
+
+			this->savegame_packets++;
+			this->map_bytes_sent += p->size;
 			this->SendPacket(p);
 
 			if (last_packet) {
@@ -617,36 +691,14 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendMap()
 		}
 
 		if (last_packet) {
-			/* Done reading, make sure saving is done as well */
-			this->savegame->Destroy();
-			this->savegame = NULL;
+			DEBUG(net, 1, "Client %d downloaded the map (%d KiB) in %d ms", this->client_id, (int)(this->map_bytes_sent / 1024), _realtime_tick - this->map_start_tick);
+
+			/* Done reading; the others downloading the snapshot continue on their own. */
+			ReleaseMapSnapshot(this);
 
 			/* Set the status to DONE_MAP, no we will wait for the client
 			 *  to send it is ready (maybe that happens like never ;)) */
 			this->status = STATUS_DONE_MAP;
-
-			/* Find the best candidate for joining, i.e. the first joiner. */
-			NetworkClientSocket *new_cs;
-			NetworkClientSocket *best = NULL;
-			FOR_ALL_CLIENT_SOCKETS(new_cs) {
-				if (new_cs->status == STATUS_MAP_WAIT) {
-					if (best == NULL || best->GetInfo()->join_date > new_cs->GetInfo()->join_date || (best->GetInfo()->join_date == new_cs->GetInfo()->join_date && best->client_id > new_cs->client_id)) {
-						best = new_cs;
-					}
-				}
-			}
-
-			/* Is there someone else to join? */
-			if (best != NULL) {
-				/* Let the first start joining. */
-				best->status = STATUS_AUTHORIZED;
-				best->SendMap();
-
-				/* And update the rest. */
-				FOR_ALL_CLIENT_SOCKETS(new_cs) {
-					if (new_cs->status == STATUS_MAP_WAIT) new_cs->SendWait();
-				}
-			}
 		}
 
 		switch (this->SendPackets()) {
@@ -655,7 +707,7 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendMap()
 
 			case SPS_ALL_SENT:
 				/* All are sent, increase the sent_packets */
-				if (has_packets) sent_packets *= 2;
+				if (has_packets) this->savegame_window *= 2;
 				break;
 
 			case SPS_PARTLY_SENT:
@@ -664,7 +716,7 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendMap()
 
 			case SPS_NONE_SENT:
 				/* Not everything is sent, decrease the sent_packets */
-				if (sent_packets > 1) sent_packets /= 2;
+				if (this->savegame_window > 1) this->savegame_window /= 2;
 				break;
 		}
 	}
@@ -685,8 +737,88 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendJoin(ClientID client_id)
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
-/** Tell the client that they may run to a particular frame. */
-NetworkRecvStatus ServerNetworkGameSocketHandler::SendFrame()
+/** A command packet that is sent to multiple clients. */
+struct BroadcastCommand {
+	CommandPacket cp; ///< The command the packet has been made for.
+	Packet *packet;   ///< The packet; clients are sent packets sharing its buffer.
+};
+
+/**
+ * Packets that are the same for many clients during a frame. They are made
+ * once and the clients are sent packets sharing their buffer, instead of
+ * making the same packet for every client.
+ */
+struct BroadcastPackets {
+	uint32 frame;                               ///< The _frame_counter the packets have been made for.
+	uint32 frame_max;                           ///< The _frame_counter_max the packets have been made for.
+	Packet *frame_packet;                       ///< The frame packet for clients that do not need a new token, or \c NULL.
+	Packet *sync_packet;                        ///< The sync packet, or \c NULL.
+	SmallVector<BroadcastCommand, 16> commands; ///< Commands sent to clients that did not send them.
+
+	BroadcastPackets() : frame(0), frame_max(0), frame_packet(NULL), sync_packet(NULL) {}
+
+	/** Release all packets. */
+	void Clear()
+	{
+		delete this->frame_packet;
+		delete this->sync_packet;
+		this->frame_packet = NULL;
+		this->sync_packet = NULL;
+		for (BroadcastCommand *bc = this->commands.Begin(); bc != this->commands.End(); bc++) delete bc->packet;
+		this->commands.Clear();
+	}
+
+	/** Release the packets when they have been made for another frame. */
+	void Validate()
+	{
+		if (this->frame == _frame_counter && this->frame_max == _frame_counter_max) return;
+
+		this->Clear();
+		this->frame = _frame_counter;
+		this->frame_max = _frame_counter_max;
+	}
+
+	/**
+	 * Find the packet made for a command.
+	 * @param cp The command.
+	 * @return The packet, or \c NULL when none has been made yet.
+	 */
+	Packet *FindCommand(const CommandPacket *cp)
+	{
+		this->Validate();
+		for (const BroadcastCommand *bc = this->commands.Begin(); bc != this->commands.End(); bc++) {
+			const CommandPacket &c = bc->cp;
+			if (c.frame == cp->frame && c.cmd == cp->cmd && c.p1 == cp->p1 && c.p2 == cp->p2 && c.tile == cp->tile &&
+					c.company == cp->company && c.callback == cp->callback && c.my_cmd == cp->my_cmd && strcmp(c.text, cp->text) == 0) {
+				return bc->packet;
+			}
+		}
+		return NULL;
+	}
+
+	/**
+	 * Remember the packet made for a command.
+	 * @param cp The command.
+	 * @param p  The packet; it is freed by the cache.
+	 */
+	void AddCommand(const CommandPacket *cp, Packet *p)
+	{
+		this->Validate();
+		BroadcastCommand *bc = this->commands.Append();
+		bc->cp = *cp;
+		bc->cp.next = NULL;
+		bc->packet = p;
+	}
+};
+
+/** The packets that are sent to many clients during the current frame. */
+static BroadcastPackets _broadcast_packets;
+
+/**
+ * Make a frame packet, without a token.
+ * @return The packet.
+ */
+static Packet *CreateFramePacket()
 {
 	Packet *p = new Packet(PACKET_SERVER_FRAME);
 	p->Send_uint32(_frame_counter);
@@ -697,28 +829,45 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendFrame()
 	p->Send_uint32(_sync_seed_2);
 #endif
 #endif
+	return p;
+}
 
+/** Tell the client that they may run to a particular frame. */
+NetworkRecvStatus ServerNetworkGameSocketHandler::SendFrame()
+{
 	/* If token equals 0, we need to make a new token and send that. */
 	if (this->last_token == 0) {
+		Packet *p = CreateFramePacket();
 		this->last_token = InteractiveRandomRange(UINT8_MAX - 1) + 1;
 		p->Send_uint8(this->last_token);
+
+		this->SendPacket(p);
+		return NETWORK_RECV_STATUS_OKAY;
 	}
 
-	this->SendPacket(p);
+	_broadcast_packets.Validate();
+	if (_broadcast_packets.frame_packet == NULL) _broadcast_packets.frame_packet = CreateFramePacket();
+
+	this->SendPacket(_broadcast_packets.frame_packet->Share());
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
 /** Request the client to sync. */
 NetworkRecvStatus ServerNetworkGameSocketHandler::SendSync()
 {
-	Packet *p = new Packet(PACKET_SERVER_SYNC);
-	p->Send_uint32(_frame_counter);
-	p->Send_uint32(_sync_seed_1);
+	_broadcast_packets.Validate();
+	if (_broadcast_packets.sync_packet == NULL) {
+		Packet *p = new Packet(PACKET_SERVER_SYNC);
+		p->Send_uint32(_frame_counter);
+		p->Send_uint32(_sync_seed_1);
 
 #ifdef NETWORK_SEND_DOUBLE_SEED
-	p->Send_uint32(_sync_seed_2);
+		p->Send_uint32(_sync_seed_2);
 #endif
-	this->SendPacket(p);
+		_broadcast_packets.sync_packet = p;
+	}
+
+	this->SendPacket(_broadcast_packets.sync_packet->Share());
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
@@ -728,28 +877,39 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendSync()
  */
 NetworkRecvStatus ServerNetworkGameSocketHandler::SendCommand(const CommandPacket *cp)
 {
-	Packet *p = new Packet(PACKET_SERVER_COMMAND);
+	/* All clients besides the one that sent the command get the same packet. */
+	Packet *shared = cp->my_cmd ? NULL : _broadcast_packets.FindCommand(cp);
+	if (shared == NULL) {
+		Packet *p = new Packet(PACKET_SERVER_COMMAND);
 
-	this->NetworkGameSocketHandler::SendCommand(p, cp);
-	p->Send_uint32(cp->frame);
-	p->Send_bool  (cp->my_cmd);
+		this->NetworkGameSocketHandler::SendCommand(p, cp);
+		p->Send_uint32(cp->frame);
+		p->Send_bool  (cp->my_cmd);
 
-	this->SendPacket(p);
+		if (cp->my_cmd) {
+			this->SendPacket(p);
+			return NETWORK_RECV_STATUS_OKAY;
+		}
+
+		_broadcast_packets.AddCommand(cp, p);
+		shared = p;
+	}
+
+	this->SendPacket(shared->Share());
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
 /**
- * Send a chat message.
+ * Make a chat packet.
  * @param action The action associated with the message.
  * @param client_id The origin of the chat message.
  * @param self_send Whether we did send the message.
  * @param msg The actual message.
  * @param data Arbitrary extra data.
+ * @return The packet.
  */
-NetworkRecvStatus ServerNetworkGameSocketHandler::SendChat(NetworkAction action, ClientID client_id, bool self_send, const char *msg, int64 data)
+static Packet *CreateChatPacket(NetworkAction action, ClientID client_id, bool self_send, const char *msg, int64 data)
 {
-	if (this->status < STATUS_PRE_ACTIVE) return NETWORK_RECV_STATUS_OKAY;
-
 	Packet *p = new Packet(PACKET_SERVER_CHAT);
 
 	p->Send_uint8 (action);
@@ -757,8 +917,34 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendChat(NetworkAction action,
 	p->Send_bool  (self_send);
 	p->Send_string(msg);
 	p->Send_uint64(data);
+	return p;
+}
 
-	this->SendPacket(p);
+/**
+ * Send a chat message.
+ * @param action The action associated with the message.
+ * @param client_id The origin of the chat message.
+ * @param self_send Whether we did send the message.
+ * @param msg The actual message.
+ * @param data Arbitrary extra data.
+ */
+NetworkRecvStatus ServerNetworkGameSocketHandler::SendChat(NetworkAction action, ClientID client_id, bool self_send, const char *msg, int64 data)
+{
+	if (this->status < STATUS_PRE_ACTIVE) return NETWORK_RECV_STATUS_OKAY;
+
+	this->SendPacket(CreateChatPacket(action, client_id, self_send, msg, data));
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
+/**
+ * Send a chat message that is sent to multiple clients.
+ * @param p The chat packet, made by #CreateChatPacket; it is shared, not consumed.
+ */
+NetworkRecvStatus ServerNetworkGameSocketHandler::SendChat(Packet *p)
+{
+	if (this->status < STATUS_PRE_ACTIVE) return NETWORK_RECV_STATUS_OKAY;
+
+	this->SendPacket(p->Share());
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
@@ -1015,23 +1201,14 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_COMPANY_PASSWOR
 
 NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_GETMAP(Packet *p)
 {
-	NetworkClientSocket *new_cs;
 	/* The client was never joined.. so this is impossible, right?
 	 *  Ignore the packet, give the client a warning, and close his connection */
 	if (this->status < STATUS_AUTHORIZED || this->HasClientQuit()) {
 		return this->SendError(NETWORK_ERROR_NOT_AUTHORIZED);
 	}
 
-	/* Check if someone else is receiving the map */
-	FOR_ALL_CLIENT_SOCKETS(new_cs) {
-		if (new_cs->status == STATUS_MAP) {
-			/* Tell the new client to wait */
-			this->status = STATUS_MAP_WAIT;
-			return this->SendWait();
-		}
-	}
-
-	/* We receive a request to upload the map.. give it to the client! */
+	/* We receive a request to upload the map.. give it to the client!
+	 * Others downloading the map at the same time share the savegame. */
 	return this->SendMap();
 }
 
@@ -1314,14 +1491,16 @@ void NetworkServerSendChat(NetworkAction action, DestType desttype, int dest, co
 			bool show_local = true;
 			/* Find all clients that belong to this company */
 			ci_to = NULL;
+			Packet *p = CreateChatPacket(action, from_id, false, msg, data);
 			FOR_ALL_CLIENT_SOCKETS(cs) {
 				ci = cs->GetInfo();
 				if (ci != NULL && ci->client_playas == (CompanyID)dest) {
-					cs->SendChat(action, from_id, false, msg, data);
+					cs->SendChat(p);
 					if (cs->client_id == from_id) show_local = false;
 					ci_to = ci; // Remember a client that is in the company for company-name
 				}
 			}
+			delete p;
 
 			/* if the server can read it, let the admin network read it, too. */
 			if (_local_company == (CompanyID)dest && _settings_client.network.server_admin_chat) {
@@ -1360,10 +1539,12 @@ void NetworkServerSendChat(NetworkAction action, DestType desttype, int dest, co
 		default:
 			DEBUG(net, 0, "[server] received unknown chat destination type %d. Doing broadcast instead", desttype);
 			/* FALL THROUGH */
-		case DESTTYPE_BROADCAST:
+		case DESTTYPE_BROADCAST: {
+			Packet *p = CreateChatPacket(action, from_id, false, msg, data);
 			FOR_ALL_CLIENT_SOCKETS(cs) {
-				cs->SendChat(action, from_id, false, msg, data);
+				cs->SendChat(p);
 			}
+			delete p;
 
 			NetworkAdminChat(action, desttype, from_id, msg, data, from_admin);
 
@@ -1372,6 +1553,7 @@ void NetworkServerSendChat(NetworkAction action, DestType desttype, int dest, co
 				NetworkTextMessage(action, GetDrawStringCompanyColour(ci->client_playas), false, ci->client_name, msg, data);
 			}
 			break;
+		}
 	}
 }
 
@@ -1897,8 +2079,9 @@ void NetworkServer_Tick(bool send_frame)
 				break;
 
 			case NetworkClientSocket::STATUS_MAP_WAIT:
-				/* This is an internal state where we do not wait
-				 * on the client to move to a different state. */
+				/* This is an internal state where we do not wait on the client,
+				 * but on another savegame to be written. Retry making its snapshot. */
+				cs->SendMap();
 				break;
 
 			case NetworkClientSocket::STATUS_END:
@@ -1920,6 +2103,9 @@ void NetworkServer_Tick(bool send_frame)
 		}
 	}
 
+	/* Every client has been sent the packets of this frame, so they need not be kept. */
+	_broadcast_packets.Clear();
+
 	/* See if we need to advertise */
 	NetworkUDPAdvertise();
 }
@@ -1984,6 +2170,19 @@ void NetworkServerShowStatusToConsole()
 			cs->client_id, ci->client_name, status, lag,
 			ci->client_playas + (Company::IsValidID(ci->client_playas) ? 1 : 0),
 			cs->GetClientIP());
+
+		if (cs->status == NetworkClientSocket::STATUS_MAP) {
+			/* Show how the download progresses, so slow joiners stand out. */
+			uint kib = (uint)(cs->map_bytes_sent / 1024);
+			uint speed = kib * 1000 / max<uint>(_realtime_tick - cs->map_start_tick, 1);
+			uint behind = _frame_counter - cs->savegame->frame;
+			size_t total_size;
+			if (cs->savegame->GetTotalSize(&total_size)) {
+				IConsolePrintF(CC_INFO, "            map: %u of %u KiB sent at %u KiB/s, %u frames to catch up", kib, (uint)(total_size / 1024), speed, behind);
+			} else {
+				IConsolePrintF(CC_INFO, "            map: %u KiB sent at %u KiB/s, still saving, %u frames to catch up", kib, speed, behind);
+			}
+		}
 	}
 }
 
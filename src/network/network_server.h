@@ -48,7 +48,6 @@ protected:
 	NetworkRecvStatus SendCompanyInfo();
 	NetworkRecvStatus SendNewGRFCheck();
 	NetworkRecvStatus SendWelcome();
-	NetworkRecvStatus SendWait();
 	NetworkRecvStatus SendNeedGamePassword();
 	NetworkRecvStatus SendNeedCompanyPassword();
 
@@ -60,7 +59,7 @@ public:
 		STATUS_AUTH_GAME,     ///< The client is authorizing with game (server) password.
 		STATUS_AUTH_COMPANY,  ///< The client is authorizing with company password.
 		STATUS_AUTHORIZED,    ///< The client is authorized.
-		STATUS_MAP_WAIT,      ///< The client is waiting as someone else is downloading the map.
+		STATUS_MAP_WAIT,      ///< The client is waiting for another savegame to be written before a snapshot of the map can be made.
 		STATUS_MAP,           ///< The client is downloading the map.
 		STATUS_DONE_MAP,      ///< The client has downloaded the map.
 		STATUS_PRE_ACTIVE,    ///< The client is catching up the delayed frames.
@@ -75,7 +74,12 @@ public:
 	CommandQueue outgoing_queue; ///< The command-queue awaiting delivery
 	int receive_limit;           ///< Amount of bytes that we can receive at this moment
 
-	struct PacketWriter *savegame; ///< Writer used to write the savegame.
+	struct NetworkMapSnapshot *savegame; ///< Snapshot of the map the client is downloading, shared with other clients.
+	uint savegame_packets;               ///< Number of packets of #savegame sent to the client.
+	uint savegame_window;                ///< Number of packets of #savegame to try to send at once.
+	bool savegame_size_sent;             ///< Whether the size of #savegame has been sent to the client.
+	size_t map_bytes_sent;               ///< Number of bytes of the map sent to the client.
+	uint32 map_start_tick;               ///< Value of #_realtime_tick when the client started downloading the map.
 	NetworkAddress client_address; ///< IP-address of the client (so he can be banned)
 
 	ServerNetworkGameSocketHandler(SOCKET s);
@@ -96,6 +100,7 @@ public:
 	NetworkRecvStatus SendClientInfo(NetworkClientInfo *ci);
 	NetworkRecvStatus SendError(NetworkErrorCode error);
 	NetworkRecvStatus SendChat(NetworkAction action, ClientID client_id, bool self_send, const char *msg, int64 data);
+	NetworkRecvStatus SendChat(Packet *p);
 	NetworkRecvStatus SendJoin(ClientID client_id);
 	NetworkRecvStatus SendFrame();
 	NetworkRecvStatus SendSync();
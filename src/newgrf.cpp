@@ -4571,6 +4571,7 @@ static void NewSpriteGroup(ByteReader *buf)
 			}
 
 			group->default_group = GetGroupFromGroupID(setid, type, buf->ReadWord());
+			group->Compile(_cur.grffile, feature);
 			break;
 		}
 
@@ -905,6 +905,74 @@ static uint32 VehicleGetVariable(Vehicle *v, const VehicleScopeResolver *object,
 	return VehicleGetVariable(const_cast<Vehicle*>(this->v), this, variable, parameter, available);
 }
 
+/**
+ * Read one of the most used vehicle variables, without the virtual
+ * ScopeResolver::GetVariable and the switches of VehicleGetVariable.
+ * @tparam variable The variable to read.
+ * @param scope     The scope, a VehicleScopeResolver.
+ * @param parameter The parameter of the variable.
+ * @param available Set to false when the variable is not available.
+ * @return The value of the variable.
+ */
+template <byte variable>
+static uint32 ReadVehicleVariable(const ScopeResolver *scope, uint32 parameter, bool *available)
+{
+	const VehicleScopeResolver *object = static_cast<const VehicleScopeResolver *>(scope);
+	const Vehicle *v = object->v;
+
+	if (v != NULL) {
+		switch (variable) {
+			case 0x40: if (HasBit(v->grf_cache.cache_valid, NCVV_POSITION_CONSIST_LENGTH)) return v->grf_cache.position_consist_length; break;
+			case 0x41: if (HasBit(v->grf_cache.cache_valid, NCVV_POSITION_SAME_ID_LENGTH)) return v->grf_cache.position_same_id_length; break;
+			case 0x43: if (HasBit(v->grf_cache.cache_valid, NCVV_COMPANY_INFORMATION)) return v->grf_cache.company_information; break;
+			case 0x46: return v->motion_counter;
+
+			case 0x47: {
+				const CargoSpec *cs = CargoSpec::Get(v->cargo_type);
+				return (cs->classes << 16) | (cs->weight << 8) | v->GetGRF()->cargo_map[v->cargo_type];
+			}
+
+			case 0x48: return v->GetEngine()->flags;
+			case 0x9F: return object->info_view ? DIR_W : v->direction;
+			case 0xB2: return v->vehstatus;
+			case 0xB4: return v->type == VEH_AIRCRAFT ? (v->cur_speed * 10) / 128 : v->cur_speed;
+			case 0xB9: return v->cargo_type;
+			case 0xBC: return ClampToU16(v->cargo.StoredCount());
+			case 0xC6: return v->GetEngine()->grf_prop.local_id;
+			case 0xF2: return v->cargo_subtype;
+		}
+	}
+
+	/* In the purchase list, or the value is not cached yet. */
+	return object->VehicleScopeResolver::GetVariable(variable, parameter, available);
+}
+
+/**
+ * Get the function reading a vehicle variable directly, for the variables
+ * that vehicle sets read the most.
+ * @param variable The variable.
+ * @return The reader, or \c NULL when the variable has to be read via VehicleScopeResolver::GetVariable.
+ */
+ScopeVariableReader *GetVehicleVariableReader(byte variable)
+{
+	switch (variable) {
+		case 0x40: return &ReadVehicleVariable<0x40>; // Position in consist
+		case 0x41: return &ReadVehicleVariable<0x41>; // Position in same ID chain
+		case 0x43: return &ReadVehicleVariable<0x43>; // Company information
+		case 0x46: return &ReadVehicleVariable<0x46>; // Motion counter
+		case 0x47: return &ReadVehicleVariable<0x47>; // Cargo information
+		case 0x48: return &ReadVehicleVariable<0x48>; // Vehicle type information
+		case 0x9F: return &ReadVehicleVariable<0x9F>; // Direction
+		case 0xB2: return &ReadVehicleVariable<0xB2>; // Vehicle status
+		case 0xB4: return &ReadVehicleVariable<0xB4>; // Current speed
+		case 0xB9: return &ReadVehicleVariable<0xB9>; // Cargo type
+		case 0xBC: return &ReadVehicleVariable<0xBC>; // Cargo amount
+		case 0xC6: return &ReadVehicleVariable<0xC6>; // Local engine ID
+		case 0xF2: return &ReadVehicleVariable<0xF2>; // Cargo subtype
+		default:   return NULL;
+	}
+}
+
 
 /* virtual */ const SpriteGroup *VehicleResolverObject::ResolveReal(const RealSpriteGroup *group) const
 {
@@ -941,6 +1009,7 @@ VehicleScopeResolver::VehicleScopeResolver(ResolverObject &ro, EngineID engine_t
 	this->v = v;
 	this->self_type = engine_type;
 	this->info_view = info_view;
+	this->vehicle = true;
 }
 
 /**
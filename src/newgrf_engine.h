@@ -101,4 +101,6 @@ void CommitVehicleListOrderChanges();
 
 EngineID GetNewEngineID(const GRFFile *file, VehicleType type, uint16 internal_id);
 
+ScopeVariableReader *GetVehicleVariableReader(byte variable);
+
 #endif /* NEWGRF_ENGINE_H */
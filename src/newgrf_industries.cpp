@@ -21,6 +21,7 @@
 #include "error.h"
 #include "strings_func.h"
 #include "core/random_func.hpp"
+#include "spatial_index.h"
 
 #include "table/strings.h"
 
@@ -88,16 +89,27 @@ uint32 GetIndustryIDAtOffset(TileIndex tile, const Industry *i, uint32 cur_grfid
 	return 0xFF << 8 | indtsp->grf_prop.subst_id; // so just give him the substitute
 }
 
-static uint32 GetClosestIndustry(TileIndex tile, IndustryType type, const Industry *current)
-{
-	uint32 best_dist = UINT32_MAX;
-	const Industry *i;
-	FOR_ALL_INDUSTRIES(i) {
-		if (i->type != type || i == current) continue;
+/** Distance to the industries of a type, for finding the closest one. */
+struct ClosestIndustryDistance {
+	TileIndex tile;          ///< The tile to search from.
+	IndustryType type;       ///< The type to look for.
+	const Industry *current; ///< Industry to ignore.
+
+	ClosestIndustryDistance(TileIndex tile, IndustryType type, const Industry *current) : tile(tile), type(type), current(current) {}
 
-		best_dist = min(best_dist, DistanceManhattan(tile, i->location.tile));
+	inline uint operator()(IndustryID id, TileIndex xy) const
+	{
+		const Industry *i = Industry::Get(id);
+		if (i->type != this->type || i == this->current) return UINT_MAX;
+		return DistanceManhattan(this->tile, xy);
 	}
+};
 
+static uint32 GetClosestIndustry(TileIndex tile, IndustryType type, const Industry *current)
+{
+	IndustryID i;
+	uint best_dist;
+	if (!GetIndustrySpatialIndex().FindNearest(tile, UINT_MAX, ClosestIndustryDistance(tile, type, current), 0, &i, &best_dist)) return UINT32_MAX;
 	return best_dist;
 }
 
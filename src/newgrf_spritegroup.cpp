@@ -12,11 +12,17 @@
 #include "stdafx.h"
 #include "debug.h"
 #include "newgrf_spritegroup.h"
+#include "newgrf_engine.h"
 #include "core/pool_func.hpp"
+#include <algorithm>
+#include <vector>
 
 SpriteGroupPool _spritegroup_pool("SpriteGroup");
 INSTANTIATE_POOL_METHODS(SpriteGroup)
 
+bool _newgrf_verify_compiled_groups = false; ///< Whether to check the results of compiled deterministic sprite groups against the interpreter.
+static bool _interpreting_for_verification = false; ///< Whether the interpreter is resolving a group to check its compiled form.
+
 RealSpriteGroup::~RealSpriteGroup()
 {
 	free(this->loaded);
@@ -27,6 +33,8 @@ DeterministicSpriteGroup::~DeterministicSpriteGroup()
 {
 	free(this->adjusts);
 	free(this->ranges);
+	free(this->program);
+	free(this->sorted_ranges);
 }
 
 RandomizedSpriteGroup::~RandomizedSpriteGroup()
@@ -64,7 +72,7 @@ static inline uint32 GetVariable(const ResolverObject &object, ScopeResolver *sc
 }
 
 ScopeResolver::ScopeResolver(ResolverObject &ro)
-		: ro(ro)
+		: ro(ro), vehicle(false)
 {
 }
 
@@ -171,10 +179,10 @@ static uint32 RotateRight(uint32 val, uint32 rot)
 }
 
 
-/* Evaluate an adjustment for a variable of the given size.
+/* Shift, mask and adjust the value of a variable of the given size.
  * U is the unsigned type and S is the signed type to use. */
 template <typename U, typename S>
-static U EvalAdjustT(const DeterministicSpriteGroupAdjust *adjust, ScopeResolver *scope, U last_value, uint32 value)
+static inline uint32 EvalAdjustValueT(const DeterministicSpriteGroupAdjust *adjust, uint32 value)
 {
 	value >>= adjust->shift_num;
 	value  &= adjust->and_mask;
@@ -187,7 +195,15 @@ static U EvalAdjustT(const DeterministicSpriteGroupAdjust *adjust, ScopeResolver
 		case DSGA_TYPE_NONE: break;
 	}
 
-	switch (adjust->operation) {
+	return value;
+}
+
+/* Apply an operation to the last value and an adjusted value of the given size.
+ * U is the unsigned type and S is the signed type to use. */
+template <typename U, typename S>
+static inline U EvalOperationT(DeterministicSpriteGroupAdjustOperation operation, ScopeResolver *scope, U last_value, uint32 value)
+{
+	switch (operation) {
 		case DSGA_OP_ADD:  return last_value + value;
 		case DSGA_OP_SUB:  return last_value - value;
 		case DSGA_OP_SMIN: return min((S)last_value, (S)value);
@@ -215,51 +231,199 @@ static U EvalAdjustT(const DeterministicSpriteGroupAdjust *adjust, ScopeResolver
 	}
 }
 
+/* Evaluate an adjustment for a variable of the given size.
+ * U is the unsigned type and S is the signed type to use. */
+template <typename U, typename S>
+static U EvalAdjustT(const DeterministicSpriteGroupAdjust *adjust, ScopeResolver *scope, U last_value, uint32 value)
+{
+	return EvalOperationT<U, S>(adjust->operation, scope, last_value, EvalAdjustValueT<U, S>(adjust, value));
+}
 
-const SpriteGroup *DeterministicSpriteGroup::Resolve(ResolverObject &object) const
+/**
+ * Get the value of the variable of an adjustment.
+ * @param object The object being resolved.
+ * @param scope The scope of the group.
+ * @param adjust The adjustment.
+ * @param last_value The value of the adjustments before this one.
+ * @param[out] available Set to false, in case the variable does not exist.
+ * @return The value.
+ */
+static uint32 GetAdjustVariable(ResolverObject &object, ScopeResolver *scope, const DeterministicSpriteGroupAdjust *adjust, uint32 last_value, bool *available)
 {
-	uint32 last_value = 0;
-	uint32 value = 0;
-	uint i;
+	if (adjust->variable == 0x7E) {
+		const SpriteGroup *subgroup = SpriteGroup::Resolve(adjust->subroutine, object);
+
+		/* Note: 'last_value' and 'reseed' are shared between the main chain and the procedure */
+		return subgroup == NULL ? CALLBACK_FAILED : subgroup->GetCallbackResult();
+	} else if (adjust->variable == 0x7B) {
+		return GetVariable(object, scope, adjust->parameter, last_value, available);
+	} else {
+		return GetVariable(object, scope, adjust->variable, adjust->parameter, available);
+	}
+}
 
-	ScopeResolver *scope = object.GetScope(this->var_scope);
+/**
+ * Evaluate the adjustments of the group one by one.
+ * @param object The object being resolved.
+ * @param scope The scope of the group.
+ * @param[out] result The value of the adjustments.
+ * @return False if a variable is not available.
+ */
+bool DeterministicSpriteGroup::Interpret(ResolverObject &object, ScopeResolver *scope, uint32 *result) const
+{
+	uint32 last_value = 0;
 
-	for (i = 0; i < this->num_adjusts; i++) {
-		DeterministicSpriteGroupAdjust *adjust = &this->adjusts[i];
+	for (uint i = 0; i < this->num_adjusts; i++) {
+		const DeterministicSpriteGroupAdjust *adjust = &this->adjusts[i];
 
 		/* Try to get the variable. We shall assume it is available, unless told otherwise. */
 		bool available = true;
-		if (adjust->variable == 0x7E) {
-			const SpriteGroup *subgroup = SpriteGroup::Resolve(adjust->subroutine, object);
-			if (subgroup == NULL) {
-				value = CALLBACK_FAILED;
-			} else {
-				value = subgroup->GetCallbackResult();
-			}
+		uint32 value = GetAdjustVariable(object, scope, adjust, last_value, &available);
+		if (!available) return false;
 
-			/* Note: 'last_value' and 'reseed' are shared between the main chain and the procedure */
-		} else if (adjust->variable == 0x7B) {
-			value = GetVariable(object, scope, adjust->parameter, last_value, &available);
-		} else {
-			value = GetVariable(object, scope, adjust->variable, adjust->parameter, &available);
+		switch (this->size) {
+			case DSG_SIZE_BYTE:  last_value = EvalAdjustT<uint8,  int8> (adjust, scope, last_value, value); break;
+			case DSG_SIZE_WORD:  last_value = EvalAdjustT<uint16, int16>(adjust, scope, last_value, value); break;
+			case DSG_SIZE_DWORD: last_value = EvalAdjustT<uint32, int32>(adjust, scope, last_value, value); break;
+			default: NOT_REACHED();
+		}
+	}
+
+	*result = last_value;
+	return true;
+}
+
+/* Run a compiled program for variables of the given size.
+ * U is the unsigned type and S is the signed type to use. */
+template <typename U, typename S>
+static bool ExecuteProgramT(const DeterministicSpriteGroupInstruction *insn, uint count, ResolverObject &object, ScopeResolver *scope, uint32 *result)
+{
+	U last_value = 0;
+
+	for (; count > 0; count--, insn++) {
+		uint32 value;
+		bool available = true;
+
+		switch (insn->operand) {
+			case DSGO_IMMEDIATE:
+				last_value = EvalOperationT<U, S>(insn->adjust.operation, scope, last_value, insn->immediate);
+				continue;
+
+			case DSGO_GLOBAL:          GetGlobalVariable(insn->adjust.variable, &value, object.grffile); break;
+			case DSGO_CALLBACK:        value = object.callback; break;
+			case DSGO_CALLBACK_PARAM1: value = object.callback_param1; break;
+			case DSGO_CALLBACK_PARAM2: value = object.callback_param2; break;
+			case DSGO_LAST_VALUE:      value = object.last_value; break;
+			case DSGO_RANDOM_TRIGGERS: value = (scope->GetRandomBits() << 8) | scope->GetTriggers(); break;
+			case DSGO_TEMP_STORE:      value = _temp_store.GetValue(insn->adjust.parameter); break;
+			case DSGO_GRF_PARAM:       value = object.grffile == NULL ? 0 : object.grffile->GetParam(insn->adjust.parameter); break;
+			case DSGO_SCOPE:           value = scope->GetVariable(insn->adjust.variable, insn->adjust.parameter, &available); break;
+			case DSGO_VEHICLE:
+				/* Groups are not bound to a feature, so the scope might not be a vehicle after all. */
+				value = scope->vehicle ? insn->reader(scope, insn->adjust.parameter, &available) : scope->GetVariable(insn->adjust.variable, insn->adjust.parameter, &available);
+				break;
+			default:                   value = GetAdjustVariable(object, scope, &insn->adjust, last_value, &available); break;
 		}
+		if (!available) return false;
+
+		last_value = EvalAdjustT<U, S>(&insn->adjust, scope, last_value, value);
+	}
+
+	*result = last_value;
+	return true;
+}
 
-		if (!available) {
-			/* Unsupported variable: skip further processing and return either
-			 * the group from the first range or the default group. */
-			return SpriteGroup::Resolve(this->num_ranges > 0 ? this->ranges[0].group : this->default_group, object);
+/**
+ * Run the compiled adjustments of the group.
+ * @param object The object being resolved.
+ * @param scope The scope of the group.
+ * @param[out] result The value of the adjustments.
+ * @return False if a variable is not available.
+ */
+bool DeterministicSpriteGroup::Execute(ResolverObject &object, ScopeResolver *scope, uint32 *result) const
+{
+	switch (this->size) {
+		case DSG_SIZE_BYTE:  return ExecuteProgramT<uint8,  int8> (this->program, this->num_instructions, object, scope, result);
+		case DSG_SIZE_WORD:  return ExecuteProgramT<uint16, int16>(this->program, this->num_instructions, object, scope, result);
+		case DSG_SIZE_DWORD: return ExecuteProgramT<uint32, int32>(this->program, this->num_instructions, object, scope, result);
+		default: NOT_REACHED();
+	}
+}
+
+/**
+ * Find the group the value of the adjustments leads to.
+ * @param value The value.
+ * @return The group of the first range containing the value, or the default group.
+ */
+const SpriteGroup *DeterministicSpriteGroup::FindRange(uint32 value) const
+{
+	if (this->program == NULL) {
+		for (uint i = 0; i < this->num_ranges; i++) {
+			if (this->ranges[i].low <= value && value <= this->ranges[i].high) return this->ranges[i].group;
 		}
+		return this->default_group;
+	}
 
-		switch (this->size) {
-			case DSG_SIZE_BYTE:  value = EvalAdjustT<uint8,  int8> (adjust, scope, last_value, value); break;
-			case DSG_SIZE_WORD:  value = EvalAdjustT<uint16, int16>(adjust, scope, last_value, value); break;
-			case DSG_SIZE_DWORD: value = EvalAdjustT<uint32, int32>(adjust, scope, last_value, value); break;
-			default: NOT_REACHED();
+	/* Binary search for the last range starting at or before the value. */
+	uint lo = 0;
+	uint hi = this->num_sorted_ranges;
+	while (lo < hi) {
+		uint mid = (lo + hi) / 2;
+		if (this->sorted_ranges[mid].low <= value) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	if (lo > 0 && value <= this->sorted_ranges[lo - 1].high) return this->sorted_ranges[lo - 1].group;
+	return this->default_group;
+}
+
+const SpriteGroup *DeterministicSpriteGroup::Resolve(ResolverObject &object) const
+{
+	ScopeResolver *scope = object.GetScope(this->var_scope);
+
+	uint32 value = 0;
+	bool available;
+	if (this->program == NULL) {
+		available = this->Interpret(object, scope, &value);
+	} else {
+		TemporaryStorageArray<int32, 0x110> temp_store;
+		uint32 last_value = object.last_value;
+		/* Running the adjustments twice is harmless as long as both start with the same temporary storage.
+		 * Persistent storage cannot be restored, so groups that might store there are not checked. */
+		bool verify = _newgrf_verify_compiled_groups && !_interpreting_for_verification && !this->may_store_persistent;
+		if (verify) temp_store = _temp_store;
+
+		available = this->Execute(object, scope, &value);
+
+		if (verify) {
+			std::swap(temp_store, _temp_store);
+			object.last_value = last_value;
+
+			/* Procedures are checked when the compiled program calls them, so let the interpreter call their compiled form. */
+			uint32 expected = 0;
+			_interpreting_for_verification = true;
+			bool expected_available = this->Interpret(object, scope, &expected);
+			_interpreting_for_verification = false;
+
+			if (available != expected_available || (available && value != expected)) {
+				DEBUG(grf, 0, "Compiled sprite group %u yields %s%X instead of %s%X", this->index,
+						available ? "" : "unavailable ", value, expected_available ? "" : "unavailable ", expected);
+			}
+			if (memcmp(temp_store.storage, _temp_store.storage, sizeof(_temp_store.storage)) != 0) {
+				DEBUG(grf, 0, "Compiled sprite group %u stores different values in the temporary storage", this->index);
+			}
 		}
-		last_value = value;
 	}
 
-	object.last_value = last_value;
+	if (!available) {
+		/* Unsupported variable: skip further processing and return either
+		 * the group from the first range or the default group. */
+		return SpriteGroup::Resolve(this->num_ranges > 0 ? this->ranges[0].group : this->default_group, object);
+	}
+
+	object.last_value = value;
 
 	if (this->num_ranges == 0) {
 		/* nvar == 0 is a special case -- we turn our value into a callback result */
@@ -269,13 +433,288 @@ const SpriteGroup *DeterministicSpriteGroup::Resolve(ResolverObject &object) con
 		return &nvarzero;
 	}
 
-	for (i = 0; i < this->num_ranges; i++) {
-		if (this->ranges[i].low <= value && value <= this->ranges[i].high) {
-			return SpriteGroup::Resolve(this->ranges[i].group, object);
+	const SpriteGroup *group = this->FindRange(value);
+	if (_newgrf_verify_compiled_groups && this->program != NULL) {
+		const SpriteGroup *expected = this->default_group;
+		for (uint i = 0; i < this->num_ranges; i++) {
+			if (this->ranges[i].low <= value && value <= this->ranges[i].high) {
+				expected = this->ranges[i].group;
+				break;
+			}
+		}
+		if (group != expected) DEBUG(grf, 0, "Compiled sprite group %u selects the wrong range for value %X", this->index, value);
+	}
+
+	return SpriteGroup::Resolve(group, object);
+}
+
+/**
+ * Check whether a variable common with action 7/9/D has the same value during the whole game.
+ * @param variable The variable.
+ * @return True if the variable can be folded into a constant.
+ */
+static bool IsConstantGlobalVariable(byte variable)
+{
+	switch (variable) {
+		case 0x0B: // TTDPatch version
+		case 0x11: // current rail tool type, constant to avoid desyncs
+		case 0x1A: // always -1
+		case 0x1B: // display options, constant to avoid desyncs
+		case 0x1D: // TTD platform
+		case 0x21: // OpenTTD version
+		case 0x22: // difficulty level
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+/**
+ * Remove the operations on constants at the end of a program that do not store
+ * anything, as their result is about to be replaced.
+ * @param program The program.
+ */
+static void DropTrailingConstantOperations(std::vector<DeterministicSpriteGroupInstruction> &program)
+{
+	while (!program.empty() && program.back().operand == DSGO_IMMEDIATE &&
+			program.back().adjust.operation != DSGA_OP_STO && program.back().adjust.operation != DSGA_OP_STOP) {
+		program.pop_back();
+	}
+}
+
+/* Fold the adjustments of a group with variables of the given size into a program.
+ * U is the unsigned type and S is the signed type to use. */
+template <typename U, typename S>
+static void CompileAdjustsT(const DeterministicSpriteGroupAdjust *adjusts, uint num_adjusts, const GRFFile *grffile, bool vehicle, std::vector<DeterministicSpriteGroupInstruction> &program)
+{
+	/* The value of the adjustments so far, when it is known while compiling. */
+	bool known = true;
+	U known_value = 0;
+	/* Whether the known value still has to be loaded by the program. */
+	bool pending = false;
+
+	for (uint i = 0; i < num_adjusts; i++) {
+		DeterministicSpriteGroupInstruction insn;
+		insn.adjust = adjusts[i];
+		insn.immediate = 0;
+		insn.reader = NULL;
+
+		const DeterministicSpriteGroupAdjust &adjust = insn.adjust;
+		uint32 value;
+		bool have_global = GetGlobalVariable(adjust.variable, &value, grffile);
+		if (adjust.variable == 0x7E) {
+			insn.operand = DSGO_PROCEDURE;
+		} else if (adjust.variable == 0x7B) {
+			insn.operand = DSGO_INDIRECT;
+		} else if (have_global) {
+			/* Leave divisions by zero to happen when resolving, as they did before. */
+			bool divides_by_zero = adjust.type != DSGA_TYPE_NONE && adjust.divmod_val == 0;
+			insn.operand = IsConstantGlobalVariable(adjust.variable) && !divides_by_zero ? DSGO_IMMEDIATE : DSGO_GLOBAL;
+			if (insn.operand == DSGO_IMMEDIATE) insn.immediate = EvalAdjustValueT<U, S>(&adjust, value);
+		} else {
+			switch (adjust.variable) {
+				case 0x0C: insn.operand = DSGO_CALLBACK;        break;
+				case 0x10: insn.operand = DSGO_CALLBACK_PARAM1; break;
+				case 0x18: insn.operand = DSGO_CALLBACK_PARAM2; break;
+				case 0x1C: insn.operand = DSGO_LAST_VALUE;      break;
+				case 0x5F: insn.operand = DSGO_RANDOM_TRIGGERS; break;
+				case 0x7D: insn.operand = DSGO_TEMP_STORE;      break;
+				case 0x7F: insn.operand = DSGO_GRF_PARAM;       break;
+
+				default:
+					insn.reader = vehicle ? GetVehicleVariableReader(adjust.variable) : NULL;
+					insn.operand = insn.reader != NULL ? DSGO_VEHICLE : DSGO_SCOPE;
+					break;
+			}
+		}
+
+		bool stores = adjust.operation == DSGA_OP_STO || adjust.operation == DSGA_OP_STOP;
+		if (insn.operand == DSGO_IMMEDIATE && !stores) {
+			/* Signed divisions are left alone, so an overflowing one traps when resolving instead of when loading. */
+			bool foldable = adjust.operation != DSGA_OP_SDIV && adjust.operation != DSGA_OP_SMOD;
+			if (foldable && (known || adjust.operation == DSGA_OP_RST)) {
+				/* Fold the constant into the known value. */
+				known_value = EvalOperationT<U, S>(adjust.operation, NULL, known_value, insn.immediate);
+				known = true;
+				pending = true;
+				continue;
+			}
+
+			/* Skip operations that do not change the value. */
+			uint32 imm = insn.immediate;
+			switch (adjust.operation) {
+				case DSGA_OP_ADD: case DSGA_OP_SUB: case DSGA_OP_OR: case DSGA_OP_XOR:
+					if (imm == 0) continue;
+					break;
+
+				case DSGA_OP_SHL: case DSGA_OP_SHR: case DSGA_OP_SAR:
+					if (((U)imm & 0x1F) == 0) continue;
+					break;
+
+				case DSGA_OP_MUL: case DSGA_OP_UDIV:
+					if (imm == 1) continue;
+					break;
+
+				case DSGA_OP_AND:
+					if ((U)imm == (U)~0U) continue;
+					break;
+
+				default: break;
+			}
+		}
+
+		/* Only indirect variables read the value so far to get their value. */
+		if (adjust.operation == DSGA_OP_RST && insn.operand != DSGO_INDIRECT) {
+			/* The value so far is replaced, so trailing operations on constants are useless. */
+			DropTrailingConstantOperations(program);
+			pending = false;
+		}
+
+		if (pending) {
+			/* Load the known value before operating on it. */
+			DeterministicSpriteGroupInstruction load = insn;
+			load.adjust.operation = DSGA_OP_RST;
+			load.operand = DSGO_IMMEDIATE;
+			load.immediate = known_value;
+			program.push_back(load);
+			pending = false;
+		}
+
+		program.push_back(insn);
+		if (!stores) known = false;
+	}
+
+	if (pending) {
+		/* The known value is loaded last, so trailing operations on constants are useless. */
+		DropTrailingConstantOperations(program);
+		DeterministicSpriteGroupInstruction load;
+		MemSetT(&load, 0);
+		load.adjust.operation = DSGA_OP_RST;
+		load.operand = DSGO_IMMEDIATE;
+		load.immediate = known_value;
+		program.push_back(load);
+	}
+}
+
+/**
+ * Check whether resolving a group might store values in persistent storage.
+ * @param group The group.
+ * @return True iff the group, or a group it leads to, has a #DSGA_OP_STOP adjustment.
+ */
+static bool MayStorePersistent(const SpriteGroup *group)
+{
+	if (group == NULL) return false;
+
+	switch (group->type) {
+		case SGT_DETERMINISTIC:
+			return ((const DeterministicSpriteGroup *)group)->may_store_persistent;
+
+		case SGT_RANDOMIZED: {
+			const RandomizedSpriteGroup *rsg = (const RandomizedSpriteGroup *)group;
+			for (uint i = 0; i < rsg->num_groups; i++) {
+				if (MayStorePersistent(rsg->groups[i])) return true;
+			}
+			return false;
+		}
+
+		default:
+			/* The other groups are results. */
+			return false;
+	}
+}
+
+/** Sorts ranges by their lowest value. */
+static bool RangeLowerThan(const DeterministicSpriteGroupRange &a, const DeterministicSpriteGroupRange &b)
+{
+	return a.low < b.low;
+}
+
+/**
+ * Compile the adjustments and ranges of the group into a form that is quicker
+ * to resolve. Constant operands are folded, variables are read without going
+ * through the general variable lookup, the most used vehicle variables even
+ * without the virtual ScopeResolver::GetVariable, and the ranges are turned
+ * into sorted, non-overlapping ranges without those leading to the default
+ * group, so they can be searched by bisection.
+ * @param grffile The NewGRF the group belongs to.
+ * @param feature The feature the group is defined for.
+ */
+void DeterministicSpriteGroup::Compile(const GRFFile *grffile, byte feature)
+{
+	/* Vehicle variables are read directly when the group is resolved for a vehicle. */
+	bool vehicle = feature <= GSF_AIRCRAFT;
+	std::vector<DeterministicSpriteGroupInstruction> program;
+	switch (this->size) {
+		case DSG_SIZE_BYTE:  CompileAdjustsT<uint8,  int8> (this->adjusts, this->num_adjusts, grffile, vehicle, program); break;
+		case DSG_SIZE_WORD:  CompileAdjustsT<uint16, int16>(this->adjusts, this->num_adjusts, grffile, vehicle, program); break;
+		case DSG_SIZE_DWORD: CompileAdjustsT<uint32, int32>(this->adjusts, this->num_adjusts, grffile, vehicle, program); break;
+		default: NOT_REACHED();
+	}
+
+	/* The groups referred to are complete, as they are defined before this one. */
+	this->may_store_persistent = MayStorePersistent(this->default_group);
+	for (uint i = 0; i < this->num_adjusts; i++) {
+		const DeterministicSpriteGroupAdjust &adjust = this->adjusts[i];
+		if (adjust.operation == DSGA_OP_STOP || (adjust.variable == 0x7E && MayStorePersistent(adjust.subroutine))) this->may_store_persistent = true;
+	}
+	for (uint i = 0; i < this->num_ranges; i++) {
+		if (MayStorePersistent(this->ranges[i].group)) this->may_store_persistent = true;
+	}
+
+	/* Earlier ranges take precedence, so only keep the parts of a range not covered by earlier ones. */
+	std::vector<DeterministicSpriteGroupRange> covered;
+	for (uint i = 0; i < this->num_ranges; i++) {
+		const DeterministicSpriteGroupRange &range = this->ranges[i];
+		if (range.low > range.high) continue;
+
+		std::vector<DeterministicSpriteGroupRange> parts;
+		uint32 low = range.low;
+		bool done = false;
+		for (std::vector<DeterministicSpriteGroupRange>::const_iterator it = covered.begin(); it != covered.end() && !done; ++it) {
+			if (it->high < low) continue;
+			if (it->low > range.high) break;
+			if (it->low > low) {
+				DeterministicSpriteGroupRange part = { range.group, low, it->low - 1 };
+				parts.push_back(part);
+			}
+			if (it->high >= range.high) {
+				done = true;
+			} else {
+				low = it->high + 1;
+			}
+		}
+		if (!done) {
+			DeterministicSpriteGroupRange part = { range.group, low, range.high };
+			parts.push_back(part);
+		}
+
+		covered.insert(covered.end(), parts.begin(), parts.end());
+		std::sort(covered.begin(), covered.end(), RangeLowerThan);
+	}
+
+	/* Drop the ranges leading to the default group and merge adjacent ranges leading to the same group. */
+	std::vector<DeterministicSpriteGroupRange> sorted;
+	for (std::vector<DeterministicSpriteGroupRange>::const_iterator it = covered.begin(); it != covered.end(); ++it) {
+		if (it->group == this->default_group) continue;
+		if (!sorted.empty() && sorted.back().group == it->group && sorted.back().high + 1 == it->low) {
+			sorted.back().high = it->high;
+		} else {
+			sorted.push_back(*it);
 		}
 	}
 
-	return SpriteGroup::Resolve(this->default_group, object);
+	free(this->program);
+	free(this->sorted_ranges);
+	this->num_instructions = (uint)program.size();
+	this->program = MallocT<DeterministicSpriteGroupInstruction>(max<uint>(this->num_instructions, 1));
+	if (this->num_instructions > 0) MemCpyT(this->program, &program[0], this->num_instructions);
+	this->num_sorted_ranges = (uint)sorted.size();
+	this->sorted_ranges = this->num_sorted_ranges > 0 ? MallocT<DeterministicSpriteGroupRange>(this->num_sorted_ranges) : NULL;
+	if (this->num_sorted_ranges > 0) MemCpyT(this->sorted_ranges, &sorted[0], this->num_sorted_ranges);
+
+	DEBUG(grf, 9, "Compiled sprite group %u: %u adjustments into %u instructions, %u ranges into %u", this->index,
+			this->num_adjusts, this->num_instructions, this->num_ranges, this->num_sorted_ranges);
 }
 
 
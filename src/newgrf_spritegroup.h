@@ -58,6 +58,7 @@ enum SpriteGroupType {
 struct SpriteGroup;
 typedef uint32 SpriteGroupID;
 struct ResolverObject;
+struct ScopeResolver;
 
 /* SPRITE_WIDTH is 24. ECS has roughly 30 sprite groups per real sprite.
  * Adding an 'extra' margin would be assuming 64 sprite groups per real
@@ -189,9 +190,43 @@ struct DeterministicSpriteGroupRange {
 	uint32 high;
 };
 
+/** Where the value a compiled adjustment works with comes from. */
+enum DeterministicSpriteGroupOperand {
+	DSGO_IMMEDIATE,       ///< A constant, already shifted, masked and adjusted while compiling.
+	DSGO_GLOBAL,          ///< A variable common with action 7/9/D.
+	DSGO_CALLBACK,        ///< Variable 0C: the callback being resolved.
+	DSGO_CALLBACK_PARAM1, ///< Variable 10: the first callback parameter.
+	DSGO_CALLBACK_PARAM2, ///< Variable 18: the second callback parameter.
+	DSGO_LAST_VALUE,      ///< Variable 1C: the result of the last resolved deterministic group.
+	DSGO_RANDOM_TRIGGERS, ///< Variable 5F: the random bits and triggers of the scope.
+	DSGO_INDIRECT,        ///< Variable 7B: a variable with the last value as its parameter.
+	DSGO_TEMP_STORE,      ///< Variable 7D: the temporary storage.
+	DSGO_PROCEDURE,       ///< Variable 7E: the callback result of a procedure.
+	DSGO_GRF_PARAM,       ///< Variable 7F: a parameter of the NewGRF.
+	DSGO_SCOPE,           ///< A feature specific variable of the scope.
+	DSGO_VEHICLE,         ///< A vehicle variable with a reader, see GetVehicleVariableReader().
+};
+
+/**
+ * Function reading a feature specific variable of a scope directly, instead of
+ * via the virtual ScopeResolver::GetVariable.
+ * @param scope     The scope to read the variable of.
+ * @param parameter The parameter of 60+x variables.
+ * @param available Set to false when the variable is not available.
+ * @return The value of the variable.
+ */
+typedef uint32 ScopeVariableReader(const ScopeResolver *scope, uint32 parameter, bool *available);
+
+/** An adjustment of a compiled deterministic sprite group. */
+struct DeterministicSpriteGroupInstruction {
+	DeterministicSpriteGroupAdjust adjust;   ///< The adjustment; of immediate operands only the operation is used.
+	DeterministicSpriteGroupOperand operand; ///< Where the value of the adjustment comes from.
+	uint32 immediate;                        ///< The value of #DSGO_IMMEDIATE operands.
+	ScopeVariableReader *reader;             ///< The reader of #DSGO_VEHICLE operands.
+};
 
 struct DeterministicSpriteGroup : SpriteGroup {
-	DeterministicSpriteGroup() : SpriteGroup(SGT_DETERMINISTIC) {}
+	DeterministicSpriteGroup() : SpriteGroup(SGT_DETERMINISTIC), program(NULL), num_instructions(0), sorted_ranges(NULL), num_sorted_ranges(0), may_store_persistent(true) {}
 	~DeterministicSpriteGroup();
 
 	VarSpriteGroupScope var_scope;
@@ -204,10 +239,26 @@ struct DeterministicSpriteGroup : SpriteGroup {
 	/* Dynamically allocated, this is the sole owner */
 	const SpriteGroup *default_group;
 
+	/* Compiled form of the adjustments and ranges, see Compile(). */
+	DeterministicSpriteGroupInstruction *program;   ///< The adjustments after folding constants, or \c NULL when not compiled.
+	uint num_instructions;                          ///< Number of instructions in #program.
+	DeterministicSpriteGroupRange *sorted_ranges;   ///< The reachable parts of the ranges not leading to the default group, sorted by value.
+	uint num_sorted_ranges;                         ///< Number of ranges in #sorted_ranges.
+	bool may_store_persistent;                      ///< Whether resolving the group may store values in persistent storage, also via the groups it leads to.
+
+	void Compile(const GRFFile *grffile, byte feature);
+
 protected:
 	const SpriteGroup *Resolve(ResolverObject &object) const;
+
+private:
+	bool Interpret(ResolverObject &object, ScopeResolver *scope, uint32 *result) const;
+	bool Execute(ResolverObject &object, ScopeResolver *scope, uint32 *result) const;
+	const SpriteGroup *FindRange(uint32 value) const;
 };
 
+extern bool _newgrf_verify_compiled_groups;
+
 enum RandomizedSpriteGroupCompareMode {
 	RSG_CMP_ANY,
 	RSG_CMP_ALL,
@@ -310,6 +361,7 @@ struct IndustryProductionSpriteGroup : SpriteGroup {
  */
 struct ScopeResolver {
 	ResolverObject &ro; ///< Surrounding resolver object.
+	bool vehicle;       ///< Whether this is a VehicleScopeResolver, whose variables compiled sprite groups may read directly.
 
 	ScopeResolver(ResolverObject &ro);
 	virtual ~ScopeResolver();
@@ -60,8 +60,10 @@
 #include "game/game.hpp"
 #include "game/game_config.hpp"
 #include "town.h"
+#include "industry.h"
 #include "subsidy_func.h"
 #include "gfx_layout.h"
+#include "tick_profiler.h"
 
 
 #include "linkgraph/linkgraphschedule.h"
@@ -176,6 +178,10 @@ static void ShowHelp()
 		"  -c config_file      = Use 'config_file' instead of 'openttd.cfg'\n"
 		"  -x                  = Do not automatically save to config file on exit\n"
 		"  -q savegame         = Write some information about the savegame and exit\n"
+		"  -B ticks[,seed=N][,hash=H]\n"
+		"                      = Run the game given with -g for a number of ticks as\n"
+		"                        fast as possible, print timings and the state hash,\n"
+		"                        and exit; fail if the state hash is not H\n"
 		"\n",
 		lastof(buf)
 	);
@@ -521,6 +527,7 @@ static const OptionData _options[] = {
 	 GETOPT_SHORT_VALUE('c'),
 	 GETOPT_SHORT_NOVAL('x'),
 	 GETOPT_SHORT_VALUE('q'),
+	 GETOPT_SHORT_VALUE('B'),
 	 GETOPT_SHORT_NOVAL('h'),
 	GETOPT_END()
 };
@@ -667,6 +674,19 @@ int openttd_main(int argc, char *argv[])
 
 			goto exit_noshutdown;
 		}
+		case 'B': {
+			free(musicdriver);
+			free(sounddriver);
+			free(videodriver);
+			musicdriver = strdup("null");
+			sounddriver = strdup("null");
+
+			char driver[64];
+			seprintf(driver, lastof(driver), "null:benchmark,ticks=%s", mgo.opt);
+			videodriver = strdup(driver);
+			scanner->save_config = false;
+			break;
+		}
 		case 'G': scanner->generation_seed = atoi(mgo.opt); break;
 		case 'c': _config_file = strdup(mgo.opt); break;
 		case 'x': scanner->save_config = false; break;
@@ -760,7 +780,7 @@ int openttd_main(int argc, char *argv[])
 	if (blitter == NULL && _ini_blitter != NULL) blitter = strdup(_ini_blitter);
 	_blitter_autodetected = StrEmpty(blitter);
 	/* If we have a 32 bpp base set, try to select the 32 bpp blitter first, but only if we autoprobe the blitter. */
-	if (!_blitter_autodetected || BaseGraphics::GetUsedSet() == NULL || BaseGraphics::GetUsedSet()->blitter == BLT_8BPP || BlitterFactoryBase::SelectBlitter("32bpp-anim") == NULL) {
+	if (!_blitter_autodetected || BaseGraphics::GetUsedSet() == NULL || BaseGraphics::GetUsedSet()->blitter == BLT_8BPP || BlitterFactoryBase::Select32bppAnimBlitter() == NULL) {
 		if (BlitterFactoryBase::SelectBlitter(blitter) == NULL) {
 			StrEmpty(blitter) ?
 				usererror("Failed to autoprobe blitter") :
@@ -868,6 +888,7 @@ int openttd_main(int argc, char *argv[])
 	_video_driver->MainLoop();
 
 	WaitTillSaved();
+	WaitTillSnapshotSaved();
 
 	/* only save config if we have to */
 	if (save_config) {
@@ -1175,6 +1196,79 @@ void SwitchToMode(SwitchMode new_mode)
 	}
 }
 
+/**
+ * Mix a value into a state hash.
+ * @param hash  The hash so far.
+ * @param value The value to add.
+ * @return The new hash.
+ */
+static inline uint32 MixGameStateHash(uint32 hash, uint32 value)
+{
+	/* FNV-1a over the bytes of the value. */
+	for (uint i = 0; i < 4; i++) {
+		hash = (hash ^ GB(value, i * 8, 8)) * 16777619;
+	}
+	return hash;
+}
+
+/**
+ * Calculate a hash over the game state, e.g. to compare the outcome of two
+ * runs of the same game. It covers the random state, the date and the most
+ * important properties of vehicles, companies, stations, towns and
+ * industries, so about every difference in the simulation changes it.
+ * @return The hash of the current game state.
+ */
+uint32 CalculateGameStateHash()
+{
+	uint32 hash = 2166136261U;
+	hash = MixGameStateHash(hash, _random.state[0]);
+	hash = MixGameStateHash(hash, _random.state[1]);
+	hash = MixGameStateHash(hash, _date);
+	hash = MixGameStateHash(hash, _date_fract);
+	hash = MixGameStateHash(hash, _tick_counter);
+
+	const Vehicle *v;
+	FOR_ALL_VEHICLES(v) {
+		hash = MixGameStateHash(hash, v->index);
+		hash = MixGameStateHash(hash, v->tile);
+		hash = MixGameStateHash(hash, v->x_pos);
+		hash = MixGameStateHash(hash, v->y_pos);
+		hash = MixGameStateHash(hash, v->z_pos);
+		hash = MixGameStateHash(hash, v->cur_speed);
+		hash = MixGameStateHash(hash, v->cargo.TotalCount());
+	}
+
+	const Company *c;
+	FOR_ALL_COMPANIES(c) {
+		hash = MixGameStateHash(hash, c->index);
+		hash = MixGameStateHash(hash, GB((int64)c->money, 0, 32));
+		hash = MixGameStateHash(hash, GB((int64)c->money, 32, 32));
+	}
+
+	const Station *st;
+	FOR_ALL_STATIONS(st) {
+		hash = MixGameStateHash(hash, st->index);
+		for (CargoID j = 0; j < NUM_CARGO; j++) {
+			hash = MixGameStateHash(hash, st->goods[j].cargo.TotalCount());
+			hash = MixGameStateHash(hash, st->goods[j].rating);
+		}
+	}
+
+	const Town *t;
+	FOR_ALL_TOWNS(t) {
+		hash = MixGameStateHash(hash, t->index);
+		hash = MixGameStateHash(hash, t->cache.population);
+	}
+
+	const Industry *ind;
+	FOR_ALL_INDUSTRIES(ind) {
+		hash = MixGameStateHash(hash, ind->index);
+		hash = MixGameStateHash(hash, ind->produced_cargo_waiting[0]);
+		hash = MixGameStateHash(hash, ind->produced_cargo_waiting[1]);
+	}
+
+	return hash;
+}
 
 /**
  * Check the validity of some of the caches.
@@ -1343,6 +1437,8 @@ void StateGameLoop()
 	}
 	if (HasModalProgress()) return;
 
+	TickPhaseTimer timer(TPH_GAMELOOP);
+
 	ClearStorageChanges(false);
 
 	Layouter::ReduceLineCache();
@@ -1415,7 +1511,7 @@ static void DoAutosave()
 	}
 
 	DEBUG(sl, 2, "Autosaving to '%s'", buf);
-	if (SaveOrLoad(buf, SL_SAVE, AUTOSAVE_DIR) != SL_OK) {
+	if (SaveOrLoad(buf, SL_SAVE, AUTOSAVE_DIR, true, _settings_client.gui.snapshot_autosaves) != SL_OK) {
 		ShowErrorMessage(STR_ERROR_AUTOSAVE_FAILED, INVALID_STRING_ID, WL_ERROR);
 	}
 }
@@ -79,5 +79,6 @@ int openttd_main(int argc, char *argv[]);
 void HandleExitGameRequest();
 
 void SwitchToMode(SwitchMode new_mode);
+uint32 CalculateGameStateHash();
 
 #endif /* OPENTTD_H */
@@ -13,6 +13,8 @@
 #define YAPF_COSTCACHE_HPP
 
 #include "../../date_func.h"
+#include "../../core/smallvec_type.hpp"
+#include <map>
 
 /**
  * CYapfSegmentCostCacheNoneT - the formal only yapf cost cache provider that implements
@@ -89,23 +91,74 @@ public:
 	inline void PfNodeCacheFlush(Node& n)
 	{
 	}
+
+	/**
+	 * Called by YAPF with the tiles of a freshly calculated segment.
+	 *  Local data is thrown away after the run, so it doesn't need them.
+	 */
+	inline void PfNodeCacheIndexTiles(Node& n, const TileIndex *tiles, uint count)
+	{
+	}
+};
+
+
+/** Statistics of the segment cost caches, since they were last reset. */
+struct CSegmentCostCacheStats
+{
+	uint m_hits;             ///< Number of segments found in a cache.
+	uint m_misses;           ///< Number of segments that had to be calculated.
+	uint m_evictions;        ///< Number of tiles with a changed track layout.
+	uint m_evicted_segments; ///< Number of segments evicted because of those changes.
+	uint m_flushes;          ///< Number of times a whole cache was thrown away.
 };
 
 
 /**
  * Base class for segment cost cache providers. Contains global counter
- *  of track layout changes and static notification function called whenever
- *  the track layout changes. It is implemented as base class because it needs
- *  to be shared between all rail YAPF types (one shared counter, one notification
- *  function.
+ *  of changes invalidating all cached segments and static notification
+ *  function called whenever the track layout changes. It is implemented as
+ *  base class because it needs to be shared between all rail YAPF types (one
+ *  shared counter, one notification function).
  */
 struct CSegmentCostCacheBase
 {
 	static int   s_rail_change_counter;
+	static SmallVector<CSegmentCostCacheBase *, 2> s_caches; ///< All caches, to notify them of changed tiles.
+	static CSegmentCostCacheStats s_stats;
+
+	inline CSegmentCostCacheBase()
+	{
+		*s_caches.Append() = this;
+	}
 
+	virtual ~CSegmentCostCacheBase()
+	{
+		s_caches.Erase(s_caches.Find(this));
+	}
+
+	/**
+	 * Forget the cached segments that might depend on the track layout of a tile.
+	 * @param tile The tile with a changed track layout.
+	 */
+	virtual void EvictTile(TileIndex tile) = 0;
+
+	/**
+	 * Called whenever the track layout of a tile changes.
+	 * @param tile The changed tile, or INVALID_TILE to forget all cached segments.
+	 * @param track The changed track.
+	 */
 	static void NotifyTrackLayoutChange(TileIndex tile, Track track)
 	{
-		s_rail_change_counter++;
+		if (tile == INVALID_TILE) {
+			/* The caches are thrown away when they are used next, as segments may still be in use now. */
+			s_rail_change_counter++;
+			return;
+		}
+
+		s_stats.m_evictions++;
+		for (CSegmentCostCacheBase **it = s_caches.Begin(); it != s_caches.End(); it++) {
+			(*it)->EvictTile(tile);
+		}
 	}
 };
 
@@ -125,21 +178,38 @@ struct CSegmentCostCacheT
 	: public CSegmentCostCacheBase
 {
 	static const int C_HASH_BITS = 14;
+	static const int C_MIN_FLUSH_SEGMENTS = 4096; ///< Minimum number of evicted segments before they are cleaned up.
 
 	typedef CHashTableT<Tsegment, C_HASH_BITS> HashTable;
 	typedef SmallArray<Tsegment> Heap;
 	typedef typename Tsegment::Key Key;    ///< key to hash table
+	typedef std::multimap<TileIndex, Tsegment *> TileIndexMap;
 
 	HashTable    m_map;
 	Heap         m_heap;
+	TileIndexMap m_tiles;       ///< The segments passing each tile; may also refer to evicted segments.
+	int          m_num_evicted; ///< Number of evicted segments still taking space in the heap.
 
-	inline CSegmentCostCacheT() {}
+	inline CSegmentCostCacheT() : m_num_evicted(0) {}
 
 	/** flush (clear) the cache */
 	inline void Flush()
 	{
 		m_map.Clear();
 		m_heap.Clear();
+		m_tiles.clear();
+		m_num_evicted = 0;
+		s_stats.m_flushes++;
+	}
+
+	/**
+	 * Check whether so many segments have been evicted that it is time to
+	 *  flush the cache to get rid of them.
+	 * @return true if the cache should be flushed.
+	 */
+	inline bool HasTooManyEvicted() const
+	{
+		return m_num_evicted >= C_MIN_FLUSH_SEGMENTS && m_num_evicted > m_map.Count();
 	}
 
 	inline Tsegment& Get(Key& key, bool *found)
@@ -149,11 +219,53 @@ struct CSegmentCostCacheT
 			*found = false;
 			item = new (m_heap.Append()) Tsegment(key);
 			m_map.Push(*item);
+			s_stats.m_misses++;
 		} else {
 			*found = true;
+			s_stats.m_hits++;
 		}
 		return *item;
 	}
+
+	/**
+	 * Remember the tiles a segment passes.
+	 * @param segment The segment.
+	 * @param tiles The tiles.
+	 * @param count Number of tiles.
+	 */
+	inline void IndexTiles(Tsegment &segment, const TileIndex *tiles, uint count)
+	{
+		for (uint i = 0; i < count; i++) {
+			m_tiles.insert(std::make_pair(tiles[i], &segment));
+		}
+	}
+
+	/**
+	 * Evict the segments passing a tile. The segments themselves stay in the
+	 *  heap, so nodes of a running pathfinder may still refer to them.
+	 * @param tile The tile.
+	 */
+	inline void EvictSegmentsAt(TileIndex tile)
+	{
+		std::pair<typename TileIndexMap::iterator, typename TileIndexMap::iterator> range = m_tiles.equal_range(tile);
+		for (typename TileIndexMap::iterator it = range.first; it != range.second; ++it) {
+			/* The segment might have been evicted already via another tile. */
+			if (!m_map.TryPop(*it->second)) continue;
+			m_num_evicted++;
+			s_stats.m_evicted_segments++;
+		}
+		m_tiles.erase(range.first, range.second);
+	}
+
+	/* virtual */ void EvictTile(TileIndex tile)
+	{
+		/* Segments ending next to the tile depend on it as well, e.g. because it
+		 * turns a dead end into a junction. */
+		EvictSegmentsAt(tile);
+		for (DiagDirection dir = DIAGDIR_BEGIN; dir < DIAGDIR_END; dir++) {
+			EvictSegmentsAt(TILE_ADD(tile, TileOffsByDiagDir(dir)));
+		}
+	}
 };
 
 /**
@@ -196,10 +308,17 @@ protected:
 			last_date = _date;
 			DEBUG(yapf, 2, "Pf time today: %5d ms", _total_pf_time_us / 1000);
 			_total_pf_time_us = 0;
+
+			CSegmentCostCacheStats &stats = Cache::s_stats;
+			uint lookups = stats.m_hits + stats.m_misses;
+			DEBUG(yapf, 2, "Segment cache today: %u lookups, %u%% hits, %u changed tiles evicting %u segments (%u per tile), %u flushes",
+					lookups, lookups == 0 ? 0 : stats.m_hits * 100 / lookups, stats.m_evictions, stats.m_evicted_segments,
+					stats.m_evictions == 0 ? 0 : stats.m_evicted_segments / stats.m_evictions, stats.m_flushes);
+			MemSetT(&stats, 0);
 		}
 
 		/* delete the cache sometimes... */
-		if (last_rail_change_counter != Cache::s_rail_change_counter) {
+		if (last_rail_change_counter != Cache::s_rail_change_counter || C.HasTooManyEvicted()) {
 			last_rail_change_counter = Cache::s_rail_change_counter;
 			C.Flush();
 		}
@@ -230,6 +349,16 @@ public:
 	inline void PfNodeCacheFlush(Node& n)
 	{
 	}
+
+	/**
+	 * Called by YAPF with the tiles of a freshly calculated segment, so the
+	 *  segment can be evicted once the track layout of one of them changes.
+	 */
+	inline void PfNodeCacheIndexTiles(Node& n, const TileIndex *tiles, uint count)
+	{
+		if (!Yapf().CanUseGlobalCache(n)) return;
+		m_global_cache.IndexTiles(*n.m_segment, tiles, count);
+	}
 };
 
 #endif /* YAPF_COSTCACHE_HPP */
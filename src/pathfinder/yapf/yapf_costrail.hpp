@@ -338,6 +338,9 @@ public:
 
 		EndSegmentReasonBits end_segment_reason = ESRB_NONE;
 
+		/* The tiles of the segment, when it has to be calculated. */
+		SmallVector<TileIndex, 16> segment_tiles;
+
 		TrackFollower tf_local(v, Yapf().GetCompatibleRailTypes(), &Yapf().m_perf_ts_cost);
 
 		if (!has_parent) {
@@ -386,6 +389,14 @@ public:
 
 no_entry_cost: // jump here at the beginning if the node has no parent (it is the first node)
 
+			/* Remember the tile, and the skipped tunnel/bridge/station tiles before it. */
+			*segment_tiles.Append() = cur.tile;
+			if (has_parent) {
+				for (int i = 1; i <= tf->m_tiles_skipped; i++) {
+					*segment_tiles.Append() = TILE_ADD(cur.tile, -i * TileOffsByDiagDir(TrackdirToExitdir(cur.td)));
+				}
+			}
+
 			/* All other tile costs will be calculated here. */
 			segment_cost += Yapf().OneTileCost(cur.tile, cur.td);
 
@@ -574,6 +585,7 @@ no_entry_cost: // jump here at the beginning if the node has no parent (it is th
 			segment.m_end_segment_reason = end_segment_reason & ESRB_CACHED_MASK;
 			/* Save end of segment back to the node. */
 			n.SetLastTileTrackdir(cur.tile, cur.td);
+			Yapf().PfNodeCacheIndexTiles(n, segment_tiles.Begin(), segment_tiles.Length());
 		}
 
 		/* Do we have an excuse why not to continue pathfinding in this direction? */
@@ -126,6 +126,13 @@ private:
 		return (tile != m_res_dest || td != m_res_dest_td) && (tile != m_res_fail_tile || td != m_res_fail_td);
 	}
 
+	/** Tell the segment cost cache a track has been reserved, as reservations are part of the cached costs. */
+	bool NotifyReservedTrack(TileIndex tile, Trackdir td)
+	{
+		YapfNotifyTrackLayoutChange(tile, TrackdirToTrack(td));
+		return tile != m_res_dest || td != m_res_dest_td;
+	}
+
 public:
 	/** Set the target to where the reservation should be extended. */
 	inline void SetReservationTarget(Node *node, TileIndex tile, Trackdir td)
@@ -182,7 +189,9 @@ public:
 		if (target != NULL) target->okay = true;
 
 		if (Yapf().CanUseGlobalCache(*m_res_node)) {
-			YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+			for (Node *node = m_res_node; node->m_parent != NULL; node = node->m_parent) {
+				node->IterateTiles(Yapf().GetVehicle(), Yapf(), *this, &CYapfReserveTrack<Types>::NotifyReservedTrack);
+			}
 		}
 
 		return true;
@@ -646,8 +655,12 @@ bool YapfTrainFindNearestSafeTile(const Train *v, TileIndex tile, Trackdir td, b
 	return pfnFindNearestSafeTile(v, tile, td, override_railtype);
 }
 
-/** if any track changes, this counter is incremented - that will invalidate segment cost cache */
+/** if all cached segments have to be forgotten, this counter is incremented - that will invalidate segment cost cache */
 int CSegmentCostCacheBase::s_rail_change_counter = 0;
+/** all segment cost caches */
+SmallVector<CSegmentCostCacheBase *, 2> CSegmentCostCacheBase::s_caches;
+/** statistics of the segment cost caches */
+CSegmentCostCacheStats CSegmentCostCacheBase::s_stats;
 
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track)
 {
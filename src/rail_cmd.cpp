@@ -2785,6 +2785,16 @@ static void ChangeTileOwner_Track(TileIndex tile, Owner old_owner, Owner new_own
 		}
 
 		SetTileOwner(tile, new_owner);
+
+		/* Segments end where the owner of the track changes. */
+		if (IsRailDepot(tile)) {
+			YapfNotifyTrackLayoutChange(tile, GetRailDepotTrack(tile));
+		} else {
+			TrackBits tracks = GetTrackBits(tile);
+			while (tracks != TRACK_BIT_NONE) {
+				YapfNotifyTrackLayoutChange(tile, RemoveFirstTrack(&tracks));
+			}
+		}
 	} else {
 		DoCommand(tile, 0, 0, DC_EXEC | DC_BANKRUPT, CMD_LANDSCAPE_CLEAR);
 	}
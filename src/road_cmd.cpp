@@ -1792,6 +1792,8 @@ static void ChangeTileOwner_Road(TileIndex tile, Owner old_owner, Owner new_owne
 				Company::Get(new_owner)->infrastructure.rail[GetRailType(tile)] += LEVELCROSSING_TRACKBIT_FACTOR;
 
 				SetTileOwner(tile, new_owner);
+				/* Segments end where the owner of the track changes. */
+				YapfNotifyTrackLayoutChange(tile, GetCrossingRailTrack(tile));
 			}
 		}
 	}
@@ -46,215 +46,163 @@ static void Check_MAPS()
 }
 
 static const uint MAP_SL_BUF_SIZE = 4096;
-
-static void Load_MAPT()
+static const uint MAP_SL_BLOCK_SIZE = 1 << 16; ///< Number of tiles in each element of the map chunks.
+
+/**
+ * Save a plane of the map. As every member of the tiles has its own plane
+ * it is saved directly; in blocks, as the planes of big maps come close to
+ * the 28 bit length limit of a RIFF chunk.
+ * @param plane The plane to save.
+ * @param conv The type of the plane's elements.
+ */
+template <typename T>
+static void SaveMapPlane(T *plane, VarType conv)
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
 	TileIndex size = MapSize();
 
-	for (TileIndex i = 0; i != size;) {
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].type_height = buf[j];
+	for (uint i = 0; i * MAP_SL_BLOCK_SIZE < size; i++) {
+		SlSetArrayIndex(i);
+		SlArray(plane + i * MAP_SL_BLOCK_SIZE, min(MAP_SL_BLOCK_SIZE, size - i * MAP_SL_BLOCK_SIZE), conv);
 	}
 }
 
-static void Save_MAPT()
+/**
+ * Load a plane of the map, as saved by SaveMapPlane or, for older
+ * savegames, as a single RIFF chunk.
+ * @param plane The plane to load.
+ * @param conv The type of the plane's elements.
+ */
+template <typename T>
+static void LoadMapPlane(T *plane, VarType conv)
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
 	TileIndex size = MapSize();
 
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].type_height;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
+	if (IsSavegameVersionBefore(189)) {
+		SlArray(plane, size, conv);
+		return;
+	}
+
+	/* The blocks are saved in order, so each block must be the one after
+	 * the last one seen, and all of them must have been seen in the end. */
+	uint blocks = 0;
+	int index;
+	while ((index = SlIterateArray()) != -1) {
+		TileIndex first = index * MAP_SL_BLOCK_SIZE;
+		if (first >= size) SlErrorCorrupt("Too many map blocks");
+		if ((uint)index != blocks) SlErrorCorrupt("Map blocks out of order");
+		SlArray(plane + first, min(MAP_SL_BLOCK_SIZE, size - first), conv);
+		blocks++;
 	}
+	if (blocks * MAP_SL_BLOCK_SIZE < size) SlErrorCorrupt("Missing map blocks");
 }
 
-static void Load_MAP1()
+static void Load_MAPT()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
+	LoadMapPlane(_m.type_height, SLE_UINT8);
+}
 
-	for (TileIndex i = 0; i != size;) {
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].m1 = buf[j];
-	}
+static void Save_MAPT()
+{
+	SaveMapPlane(_m.type_height, SLE_UINT8);
 }
 
-static void Save_MAP1()
+static void Load_MAP1()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
+	LoadMapPlane(_m.m1, SLE_UINT8);
+}
 
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].m1;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-	}
+static void Save_MAP1()
+{
+	SaveMapPlane(_m.m1, SLE_UINT8);
 }
 
 static void Load_MAP2()
 {
-	SmallStackSafeStackAlloc<uint16, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	for (TileIndex i = 0; i != size;) {
-		SlArray(buf, MAP_SL_BUF_SIZE,
-			/* In those versions the m2 was 8 bits */
-			IsSavegameVersionBefore(5) ? SLE_FILE_U8 | SLE_VAR_U16 : SLE_UINT16
-		);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].m2 = buf[j];
-	}
+	LoadMapPlane(_m.m2,
+		/* In those versions the m2 was 8 bits */
+		IsSavegameVersionBefore(5) ? SLE_FILE_U8 | SLE_VAR_U16 : SLE_UINT16
+	);
 }
 
 static void Save_MAP2()
 {
-	SmallStackSafeStackAlloc<uint16, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size * sizeof(uint16));
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].m2;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT16);
-	}
+	SaveMapPlane(_m.m2, SLE_UINT16);
 }
 
 static void Load_MAP3()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	for (TileIndex i = 0; i != size;) {
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].m3 = buf[j];
-	}
+	LoadMapPlane(_m.m3, SLE_UINT8);
 }
 
 static void Save_MAP3()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].m3;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-	}
+	SaveMapPlane(_m.m3, SLE_UINT8);
 }
 
 static void Load_MAP4()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	for (TileIndex i = 0; i != size;) {
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].m4 = buf[j];
-	}
+	LoadMapPlane(_m.m4, SLE_UINT8);
 }
 
 static void Save_MAP4()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].m4;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-	}
+	SaveMapPlane(_m.m4, SLE_UINT8);
 }
 
 static void Load_MAP5()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	for (TileIndex i = 0; i != size;) {
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].m5 = buf[j];
-	}
+	LoadMapPlane(_m.m5, SLE_UINT8);
 }
 
 static void Save_MAP5()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].m5;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-	}
+	SaveMapPlane(_m.m5, SLE_UINT8);
 }
 
 static void Load_MAP6()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
 	TileIndex size = MapSize();
 
 	if (IsSavegameVersionBefore(42)) {
+		SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
 		for (TileIndex i = 0; i != size;) {
 			/* 1024, otherwise we overflow on 64x64 maps! */
 			SlArray(buf, 1024, SLE_UINT8);
 			for (uint j = 0; j != 1024; j++) {
-				_m[i++].m6 = GB(buf[j], 0, 2);
-				_m[i++].m6 = GB(buf[j], 2, 2);
-				_m[i++].m6 = GB(buf[j], 4, 2);
-				_m[i++].m6 = GB(buf[j], 6, 2);
+				_m.m6[i++] = GB(buf[j], 0, 2);
+				_m.m6[i++] = GB(buf[j], 2, 2);
+				_m.m6[i++] = GB(buf[j], 4, 2);
+				_m.m6[i++] = GB(buf[j], 6, 2);
 			}
 		}
 	} else {
-		for (TileIndex i = 0; i != size;) {
-			SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].m6 = buf[j];
-		}
+		LoadMapPlane(_m.m6, SLE_UINT8);
 	}
 }
 
 static void Save_MAP6()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].m6;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-	}
+	SaveMapPlane(_m.m6, SLE_UINT8);
 }
 
 static void Load_MAP7()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	for (TileIndex i = 0; i != size;) {
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _me[i++].m7 = buf[j];
-	}
+	LoadMapPlane(_me.m7, SLE_UINT8);
 }
 
 static void Save_MAP7()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _me[i++].m7;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-	}
+	SaveMapPlane(_me.m7, SLE_UINT8);
 }
 
 extern const ChunkHandler _map_chunk_handlers[] = {
 	{ 'MAPS', Save_MAPS, Load_MAPS, NULL, Check_MAPS, CH_RIFF },
-	{ 'MAPT', Save_MAPT, Load_MAPT, NULL, NULL,       CH_RIFF },
-	{ 'MAPO', Save_MAP1, Load_MAP1, NULL, NULL,       CH_RIFF },
-	{ 'MAP2', Save_MAP2, Load_MAP2, NULL, NULL,       CH_RIFF },
-	{ 'M3LO', Save_MAP3, Load_MAP3, NULL, NULL,       CH_RIFF },
-	{ 'M3HI', Save_MAP4, Load_MAP4, NULL, NULL,       CH_RIFF },
-	{ 'MAP5', Save_MAP5, Load_MAP5, NULL, NULL,       CH_RIFF },
-	{ 'MAPE', Save_MAP6, Load_MAP6, NULL, NULL,       CH_RIFF },
-	{ 'MAP7', Save_MAP7, Load_MAP7, NULL, NULL,       CH_RIFF | CH_LAST },
+	{ 'MAPT', Save_MAPT, Load_MAPT, NULL, NULL,       CH_ARRAY },
+	{ 'MAPO', Save_MAP1, Load_MAP1, NULL, NULL,       CH_ARRAY },
+	{ 'MAP2', Save_MAP2, Load_MAP2, NULL, NULL,       CH_ARRAY },
+	{ 'M3LO', Save_MAP3, Load_MAP3, NULL, NULL,       CH_ARRAY },
+	{ 'M3HI', Save_MAP4, Load_MAP4, NULL, NULL,       CH_ARRAY },
+	{ 'MAP5', Save_MAP5, Load_MAP5, NULL, NULL,       CH_ARRAY },
+	{ 'MAPE', Save_MAP6, Load_MAP6, NULL, NULL,       CH_ARRAY },
+	{ 'MAP7', Save_MAP7, Load_MAP7, NULL, NULL,       CH_ARRAY | CH_LAST },
 };
@@ -25,6 +25,7 @@
 #include "../debug.h"
 #include "../station_base.h"
 #include "../thread/thread.h"
+#include "../thread/worker_pool.h"
 #include "../town.h"
 #include "../network/network.h"
 #include "../window_func.h"
@@ -253,8 +254,10 @@
  *  185   25620
  *  186   25833
  *  187   25899
+ *  188
+ *  189
  */
-extern const uint16 SAVEGAME_VERSION = 187; ///< Current savegame version of OpenTTD.
+extern const uint16 SAVEGAME_VERSION = 189; ///< Current savegame version of OpenTTD.
 
 SavegameType _savegame_type; ///< type of savegame we are loading
 
@@ -400,6 +403,7 @@ struct SaveLoadParams {
 
 	byte ff_state;                       ///< The state of fast-forward when saving started.
 	bool saveinprogress;                 ///< Whether there is currently a save in progress.
+	bool single_threaded;                ///< Whether to (de)compress without worker threads.
 };
 
 static SaveLoadParams _sl; ///< Parameters used for/at saveload.
@@ -555,6 +559,86 @@ typedef void (*AsyncSaveFinishProc)();                ///< Callback for when the
 static AsyncSaveFinishProc _async_save_finish = NULL; ///< Callback to call when the savegame loading is finished.
 static ThreadObject *_save_thread;                    ///< The thread we're using to compress and write a savegame
 
+#if defined(UNIX) && !defined(__MORPHOS__) && !defined(__APPLE__)
+/* Snapshot saves are written by a forked child process. On OSX the child
+ * of a process using Cocoa must not do anything but exec, so don't. */
+#	define WITH_SNAPSHOT_SAVES
+#	include <unistd.h>
+#	include <sys/select.h>
+#	include <sys/wait.h>
+#	include <sys/stat.h>
+#	include <errno.h>
+
+static pid_t _save_child = -1; ///< The process writing a snapshot of the game, or -1 if there is none.
+static dev_t _save_child_dev;  ///< Device of the file the snapshot is written to.
+static ino_t _save_child_ino;  ///< Inode of the file the snapshot is written to.
+#endif /* UNIX && !__MORPHOS__ && !__APPLE__ */
+
+/**
+ * Check whether the process writing a snapshot of the game has finished,
+ * and report when it failed.
+ * @param wait Whether to wait until it has finished.
+ */
+static void ReapSaveChild(bool wait)
+{
+#ifdef WITH_SNAPSHOT_SAVES
+	if (_save_child == -1) return;
+
+	int status;
+	pid_t pid;
+	do {
+		pid = waitpid(_save_child, &status, wait ? 0 : WNOHANG);
+	} while (pid == -1 && errno == EINTR);
+	if (pid == 0) return;
+
+	_save_child = -1;
+	if (pid == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+		ShowErrorMessage(STR_ERROR_AUTOSAVE_FAILED, INVALID_STRING_ID, WL_ERROR);
+	}
+#endif /* WITH_SNAPSHOT_SAVES */
+}
+
+/**
+ * Check whether a process is still writing a snapshot of the game.
+ * @return True if the snapshot is still being written.
+ */
+static bool IsSnapshotSaveInProgress()
+{
+	ReapSaveChild(false);
+#ifdef WITH_SNAPSHOT_SAVES
+	return _save_child != -1;
+#else
+	return false;
+#endif /* WITH_SNAPSHOT_SAVES */
+}
+
+/**
+ * Check whether a file is the one a snapshot of the game is being written to.
+ * @param fh The file to check.
+ * @return True if the process writing a snapshot is still writing to \a fh.
+ */
+static bool IsSnapshotSaveFile(FILE *fh)
+{
+#ifdef WITH_SNAPSHOT_SAVES
+	if (!IsSnapshotSaveInProgress()) return false;
+
+	struct stat st;
+	return fstat(fileno(fh), &st) == 0 && st.st_dev == _save_child_dev && st.st_ino == _save_child_ino;
+#else
+	return false;
+#endif /* WITH_SNAPSHOT_SAVES */
+}
+
+/**
+ * Wait until the process writing a snapshot of the game has finished, if
+ * there is one. Only needed when the complete savegame file is needed,
+ * e.g. before exiting; the process does not share any state with the game.
+ */
+void WaitTillSnapshotSaved()
+{
+	ReapSaveChild(true);
+}
+
 /**
  * Called by save thread to tell we finished saving.
  * @param proc The callback to call when saving is done.
@@ -572,6 +656,8 @@ static void SetAsyncSaveFinish(AsyncSaveFinishProc proc)
  */
 void ProcessAsyncSaveFinish()
 {
+	ReapSaveChild(false);
+
 	if (_async_save_finish == NULL) return;
 
 	_async_save_finish();
@@ -2139,6 +2225,50 @@ struct ZlibSaveFilter : SaveFilter {
 	}
 };
 
+/** Zlib compression of independent blocks, for the parallel format. */
+struct ZlibBlockCodec {
+	/**
+	 * Get the maximum size of a compressed block.
+	 * @param size The size of the uncompressed block.
+	 * @return The maximum size of the compressed block.
+	 */
+	static size_t Bound(size_t size)
+	{
+		return compressBound((uLong)size);
+	}
+
+	/**
+	 * Compress a block.
+	 * @param out      Buffer for the compressed data, at least Bound(in_size) bytes.
+	 * @param out_size Output for the size of the compressed data.
+	 * @param in       The data to compress.
+	 * @param in_size  The size of the data to compress.
+	 * @param level    The requested level of compression.
+	 * @return Whether the compression succeeded.
+	 */
+	static bool Compress(byte *out, size_t *out_size, const byte *in, size_t in_size, byte level)
+	{
+		uLongf len = (uLongf)Bound(in_size);
+		if (compress2(out, &len, in, (uLong)in_size, level) != Z_OK) return false;
+		*out_size = len;
+		return true;
+	}
+
+	/**
+	 * Decompress a block.
+	 * @param out      Buffer for the decompressed data.
+	 * @param out_size The size of the decompressed data.
+	 * @param in       The data to decompress.
+	 * @param in_size  The size of the data to decompress.
+	 * @return Whether the decompression succeeded and yielded exactly out_size bytes.
+	 */
+	static bool Decompress(byte *out, size_t out_size, const byte *in, size_t in_size)
+	{
+		uLongf len = (uLongf)out_size;
+		return uncompress(out, &len, in, (uLong)in_size) == Z_OK && len == out_size;
+	}
+};
+
 #endif /* WITH_ZLIB */
 
 /********************************************
@@ -2258,8 +2388,308 @@ struct LZMASaveFilter : SaveFilter {
 	}
 };
 
+/** LZMA compression of independent blocks, for the parallel format. */
+struct LZMABlockCodec {
+	/**
+	 * Get the maximum size of a compressed block.
+	 * @param size The size of the uncompressed block.
+	 * @return The maximum size of the compressed block.
+	 */
+	static size_t Bound(size_t size)
+	{
+		return lzma_stream_buffer_bound(size);
+	}
+
+	/**
+	 * Compress a block.
+	 * @param out      Buffer for the compressed data, at least Bound(in_size) bytes.
+	 * @param out_size Output for the size of the compressed data.
+	 * @param in       The data to compress.
+	 * @param in_size  The size of the data to compress.
+	 * @param level    The requested level of compression.
+	 * @return Whether the compression succeeded.
+	 */
+	static bool Compress(byte *out, size_t *out_size, const byte *in, size_t in_size, byte level)
+	{
+		*out_size = 0;
+		return lzma_easy_buffer_encode(level, LZMA_CHECK_CRC32, NULL, in, in_size, out, out_size, Bound(in_size)) == LZMA_OK;
+	}
+
+	/**
+	 * Decompress a block.
+	 * @param out      Buffer for the decompressed data.
+	 * @param out_size The size of the decompressed data.
+	 * @param in       The data to decompress.
+	 * @param in_size  The size of the data to decompress.
+	 * @return Whether the decompression succeeded and yielded exactly out_size bytes.
+	 */
+	static bool Decompress(byte *out, size_t out_size, const byte *in, size_t in_size)
+	{
+		uint64_t memlimit = UINT64_MAX;
+		size_t in_pos = 0;
+		size_t out_pos = 0;
+		return lzma_stream_buffer_decode(&memlimit, 0, NULL, in, &in_pos, in_size, out, &out_pos, out_size) == LZMA_OK &&
+				in_pos == in_size && out_pos == out_size;
+	}
+};
+
 #endif /* WITH_LZMA */
 
+/********************************************
+ ******** START OF PARALLEL BLOCK CODE ******
+ ********************************************/
+
+#if defined(WITH_ZLIB) || defined(WITH_LZMA)
+
+static const size_t COMPRESSION_BLOCK_SIZE = 1 << 20; ///< Maximum uncompressed size of a block of the parallel formats.
+
+/** A block of a savegame in one of the parallel formats. */
+struct CompressionBlock {
+	byte *raw;          ///< The uncompressed data.
+	size_t raw_size;    ///< Number of bytes of uncompressed data.
+	byte *packed;       ///< The compressed data.
+	size_t packed_size; ///< Number of bytes of compressed data.
+	bool ok;            ///< Whether (de)compressing the block succeeded.
+};
+
+/**
+ * Allocate the blocks of a parallel filter; as many as can be
+ * (de)compressed at once, plus some for the workers to be kept busy.
+ * @param blocks  The vector to allocate the blocks in.
+ * @param workers The pool the blocks are going to be (de)compressed by.
+ * @param bound   Maximum size of a compressed block.
+ */
+static void AllocateCompressionBlocks(SmallVector<CompressionBlock, 16> &blocks, WorkerPool &workers, size_t bound)
+{
+	workers.SetWorkerCount(_sl.single_threaded ? 0 : max(GetCPUCoreCount(), 1U) - 1);
+	for (uint i = 0; i < (workers.GetWorkerCount() + 1) * 2; i++) {
+		CompressionBlock *block = blocks.Append();
+		block->raw = MallocT<byte>(COMPRESSION_BLOCK_SIZE);
+		block->raw_size = 0;
+		block->packed = MallocT<byte>(bound);
+		block->packed_size = 0;
+		block->ok = false;
+	}
+}
+
+/**
+ * Free the blocks of a parallel filter.
+ * @param blocks The blocks to free.
+ */
+static void FreeCompressionBlocks(SmallVector<CompressionBlock, 16> &blocks)
+{
+	for (CompressionBlock *block = blocks.Begin(); block != blocks.End(); block++) {
+		free(block->raw);
+		free(block->packed);
+	}
+}
+
+/**
+ * Filter for the parallel formats. The savegame is split into blocks of
+ * COMPRESSION_BLOCK_SIZE bytes which are decompressed independently of each
+ * other, a batch of them at a time on a pool of worker threads. Every block is
+ * preceded by its entry in the block index: its uncompressed and its compressed
+ * size. An entry with an uncompressed size of 0 terminates the savegame.
+ * @tparam Tcodec The compression used for the blocks.
+ */
+template <class Tcodec>
+struct BlockLoadFilter : LoadFilter {
+	WorkerPool workers;                       ///< Threads decompressing the blocks.
+	SmallVector<CompressionBlock, 16> blocks; ///< The blocks of the current batch.
+	uint filled;                              ///< Number of blocks in the current batch.
+	uint current;                             ///< Block that is being read from.
+	size_t pos;                               ///< Position in the current block.
+	bool end;                                 ///< Whether the terminating entry has been read.
+
+	/**
+	 * Initialise this filter.
+	 * @param chain The next filter in this chain.
+	 */
+	BlockLoadFilter(LoadFilter *chain) : LoadFilter(chain), filled(0), current(0), pos(0), end(false)
+	{
+		AllocateCompressionBlocks(this->blocks, this->workers, Tcodec::Bound(COMPRESSION_BLOCK_SIZE));
+	}
+
+	/** Clean everything up. */
+	~BlockLoadFilter()
+	{
+		FreeCompressionBlocks(this->blocks);
+	}
+
+	/**
+	 * Read exactly the given number of bytes from the next filter.
+	 * @param buf  The buffer to read into.
+	 * @param size The number of bytes to read.
+	 */
+	void ReadFully(byte *buf, size_t size)
+	{
+		while (size > 0) {
+			size_t read = this->chain->Read(buf, size);
+			if (read == 0) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_READABLE, "File read failed");
+			buf += read;
+			size -= read;
+		}
+	}
+
+	/**
+	 * Decompress a block; called by the worker pool.
+	 * @param filter The filter the block belongs to.
+	 * @param index  The index of the block.
+	 */
+	static void DecompressBlock(void *filter, uint index)
+	{
+		CompressionBlock *block = &((BlockLoadFilter *)filter)->blocks[index];
+		block->ok = Tcodec::Decompress(block->raw, block->raw_size, block->packed, block->packed_size);
+	}
+
+	/** Read the next batch of blocks and decompress them. */
+	void ReadBatch()
+	{
+		this->filled = 0;
+		this->current = 0;
+		this->pos = 0;
+
+		while (!this->end && this->filled < this->blocks.Length()) {
+			uint32 index[2];
+			this->ReadFully((byte *)index, sizeof(index));
+			size_t raw_size = FROM_BE32(index[0]);
+			size_t packed_size = FROM_BE32(index[1]);
+			if (raw_size == 0) {
+				this->end = true;
+				break;
+			}
+			if (raw_size > COMPRESSION_BLOCK_SIZE || packed_size > Tcodec::Bound(COMPRESSION_BLOCK_SIZE)) SlErrorCorrupt("Inconsistent size");
+
+			CompressionBlock *block = &this->blocks[this->filled++];
+			block->raw_size = raw_size;
+			block->packed_size = packed_size;
+			this->ReadFully(block->packed, packed_size);
+		}
+
+		this->workers.ParallelFor(&DecompressBlock, this, this->filled);
+
+		for (uint i = 0; i < this->filled; i++) {
+			if (!this->blocks[i].ok) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "decompressing block failed");
+		}
+	}
+
+	/* virtual */ size_t Read(byte *buf, size_t size)
+	{
+		size_t read = 0;
+		while (read < size) {
+			if (this->current == this->filled) {
+				if (this->end) break;
+				this->ReadBatch();
+				continue;
+			}
+
+			CompressionBlock *block = &this->blocks[this->current];
+			size_t len = min(size - read, block->raw_size - this->pos);
+			memcpy(buf + read, block->raw + this->pos, len);
+			read += len;
+			this->pos += len;
+			if (this->pos == block->raw_size) {
+				this->current++;
+				this->pos = 0;
+			}
+		}
+		return read;
+	}
+
+	/* virtual */ void Reset()
+	{
+		this->filled = 0;
+		this->current = 0;
+		this->pos = 0;
+		this->end = false;
+		this->chain->Reset();
+	}
+};
+
+/**
+ * Filter for the parallel formats; see BlockLoadFilter for the format.
+ * The blocks of a batch are compressed at once on a pool of worker threads.
+ * @tparam Tcodec The compression used for the blocks.
+ */
+template <class Tcodec>
+struct BlockSaveFilter : SaveFilter {
+	WorkerPool workers;                       ///< Threads compressing the blocks.
+	SmallVector<CompressionBlock, 16> blocks; ///< The blocks of the current batch.
+	uint filled;                              ///< Number of full blocks in the current batch.
+	byte compression_level;                   ///< The requested level of compression.
+
+	/**
+	 * Initialise this filter.
+	 * @param chain             The next filter in this chain.
+	 * @param compression_level The requested level of compression.
+	 */
+	BlockSaveFilter(SaveFilter *chain, byte compression_level) : SaveFilter(chain), filled(0), compression_level(compression_level)
+	{
+		AllocateCompressionBlocks(this->blocks, this->workers, Tcodec::Bound(COMPRESSION_BLOCK_SIZE));
+	}
+
+	/** Clean up what we allocated. */
+	~BlockSaveFilter()
+	{
+		FreeCompressionBlocks(this->blocks);
+	}
+
+	/**
+	 * Compress a block; called by the worker pool.
+	 * @param filter The filter the block belongs to.
+	 * @param index  The index of the block.
+	 */
+	static void CompressBlock(void *filter, uint index)
+	{
+		BlockSaveFilter *self = (BlockSaveFilter *)filter;
+		CompressionBlock *block = &self->blocks[index];
+		block->ok = Tcodec::Compress(block->packed, &block->packed_size, block->raw, block->raw_size, self->compression_level);
+	}
+
+	/** Compress the blocks of the current batch and write them, in order. */
+	void WriteBatch()
+	{
+		this->workers.ParallelFor(&CompressBlock, this, this->filled);
+
+		for (uint i = 0; i < this->filled; i++) {
+			CompressionBlock *block = &this->blocks[i];
+			if (!block->ok) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "compressing block failed");
+
+			uint32 index[2] = { TO_BE32((uint32)block->raw_size), TO_BE32((uint32)block->packed_size) };
+			this->chain->Write((byte *)index, sizeof(index));
+			this->chain->Write(block->packed, block->packed_size);
+			block->raw_size = 0;
+		}
+		this->filled = 0;
+	}
+
+	/* virtual */ void Write(byte *buf, size_t size)
+	{
+		while (size > 0) {
+			CompressionBlock *block = &this->blocks[this->filled];
+			size_t len = min(size, COMPRESSION_BLOCK_SIZE - block->raw_size);
+			memcpy(block->raw + block->raw_size, buf, len);
+			block->raw_size += len;
+			buf += len;
+			size -= len;
+
+			if (block->raw_size == COMPRESSION_BLOCK_SIZE && ++this->filled == this->blocks.Length()) this->WriteBatch();
+		}
+	}
+
+	/* virtual */ void Finish()
+	{
+		if (this->blocks[this->filled].raw_size != 0) this->filled++;
+		this->WriteBatch();
+
+		uint32 index[2] = { 0, 0 };
+		this->chain->Write((byte *)index, sizeof(index));
+		this->chain->Finish();
+	}
+};
+
+#endif /* WITH_ZLIB || WITH_LZMA */
+
 /*******************************************
  ************* END OF CODE *****************
  *******************************************/
@@ -2287,6 +2717,19 @@ static const SaveLoadFormat _saveload_formats[] = {
 #endif
 	/* Roughly 5 times larger at only 1% of the CPU usage over zlib level 6. */
 	{"none",   TO_BE32X('OTTN'), CreateLoadFilter<NoCompLoadFilter>, CreateSaveFilter<NoCompSaveFilter>, 0, 0, 0},
+	/* The parallel formats split the savegame into blocks of 1 MB that are compressed independently, using all cores.
+	 * They are slightly larger than their single stream counterparts, but are written and read several times faster
+	 * on multi-core machines. They aren't the default as older versions can't read them. */
+#if defined(WITH_ZLIB)
+	{"pzlib",  TO_BE32X('OTZP'), CreateLoadFilter<BlockLoadFilter<ZlibBlockCodec> >, CreateSaveFilter<BlockSaveFilter<ZlibBlockCodec> >, 0, 6, 9},
+#else
+	{"pzlib",  TO_BE32X('OTZP'), NULL,                               NULL,                               0, 0, 0},
+#endif
+#if defined(WITH_LZMA)
+	{"plzma",  TO_BE32X('OTXP'), CreateLoadFilter<BlockLoadFilter<LZMABlockCodec> >, CreateSaveFilter<BlockSaveFilter<LZMABlockCodec> >, 0, 2, 9},
+#else
+	{"plzma",  TO_BE32X('OTXP'), NULL,                               NULL,                               0, 0, 0},
+#endif
 #if defined(WITH_ZLIB)
 	/* After level 6 the speed reduction is significant (1.5x to 2.5x slower per level), but the reduction in filesize is
 	 * fairly insignificant (~1% for each step). Lower levels become ~5-10% bigger by each level than level 6 while level
@@ -2434,6 +2877,24 @@ static void SaveFileError()
 	SaveFileDone();
 }
 
+/**
+ * Write the savegame that has been saved to memory to the save filter:
+ * the header, then the compressed data. The save filter is closed afterwards.
+ * @param fmt         The format to save in.
+ * @param compression The compression level of the format.
+ */
+static void WriteSavegame(const SaveLoadFormat *fmt, byte compression)
+{
+	/* We have written our stuff to memory, now write it to file! */
+	uint32 hdr[2] = { fmt->tag, TO_BE32(SAVEGAME_VERSION << 16) };
+	_sl.sf->Write((byte*)hdr, sizeof(hdr));
+
+	_sl.sf = fmt->init_write(_sl.sf, compression);
+	_sl.dumper->Flush(_sl.sf);
+
+	ClearSaveLoadState();
+}
+
 /**
  * We have written the whole game into memory, _memory_savegame, now find
  * and appropriate compressor and start writing to file.
@@ -2444,14 +2905,7 @@ static SaveOrLoadResult SaveFileToDisk(bool threaded)
 		byte compression;
 		const SaveLoadFormat *fmt = GetSavegameFormat(_savegame_format, &compression);
 
-		/* We have written our stuff to memory, now write it to file! */
-		uint32 hdr[2] = { fmt->tag, TO_BE32(SAVEGAME_VERSION << 16) };
-		_sl.sf->Write((byte*)hdr, sizeof(hdr));
-
-		_sl.sf = fmt->init_write(_sl.sf, compression);
-		_sl.dumper->Flush(_sl.sf);
-
-		ClearSaveLoadState();
+		WriteSavegame(fmt, compression);
 
 		if (threaded) SetAsyncSaveFinish(SaveFileDone);
 
@@ -2484,6 +2938,17 @@ static void SaveFileToDiskThread(void *arg)
 	SaveFileToDisk(true);
 }
 
+/**
+ * Check whether a savegame is still being written by the saving thread.
+ * No new savegame can be started until it is done. A process writing a
+ * snapshot of the game does not count, as it shares no state with the game.
+ * @return True if a savegame is still being written.
+ */
+bool IsSaveInProgress()
+{
+	return _sl.saveinprogress;
+}
+
 void WaitTillSaved()
 {
 	if (_save_thread == NULL) return;
@@ -2529,6 +2994,97 @@ static SaveOrLoadResult DoSave(SaveFilter *writer, bool threaded)
 	return SL_OK;
 }
 
+#ifdef WITH_SNAPSHOT_SAVES
+/**
+ * Close all file descriptors of this process, except for the standard ones and one other.
+ * @param keep The file descriptor to keep open.
+ */
+static void CloseFilesExcept(int keep)
+{
+	for (int fd = 3; fd < keep; fd++) close(fd);
+#if defined(__FreeBSD__) || defined(__OpenBSD__) || (defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 34)))
+	closefrom(keep + 1);
+#else
+	long max_fd = sysconf(_SC_OPEN_MAX);
+	if (max_fd < 0) max_fd = FD_SETSIZE;
+	for (long fd = keep + 1; fd < max_fd; fd++) close((int)fd);
+#endif
+}
+
+/**
+ * Write the savegame in the child process of a snapshot save. The other
+ * threads of the game do not exist in the child, but any lock they held
+ * at the moment of the fork stays locked. So only the savegame itself is
+ * serialised, compressed and written here, without worker threads, debug
+ * output or error messages; the parent reports the result.
+ * @param fh          The file to save to.
+ * @param fmt         The format to save in.
+ * @param compression The compression level of the format.
+ * @return True if the savegame has been written.
+ */
+static bool WriteSnapshot(FILE *fh, const SaveLoadFormat *fmt, byte compression)
+{
+	/* Only the savegame is needed; don't keep e.g. the sockets of
+	 * clients the parent disconnects in the meantime open. */
+	CloseFilesExcept(fileno(fh));
+	SilenceDebugOutput();
+	_sl.single_threaded = true;
+
+	try {
+		_sl.dumper = new MemoryDumper();
+		_sl.sf = new FileWriter(fh);
+		_sl_version = SAVEGAME_VERSION;
+
+		SaveViewportBeforeSaveGame();
+		SlSaveChunks();
+		WriteSavegame(fmt, compression);
+		return true;
+	} catch (...) {
+		return false;
+	}
+}
+#endif /* WITH_SNAPSHOT_SAVES */
+
+/**
+ * Save the game in a child process. The child works on a copy-on-write
+ * snapshot of the whole game state, so it can serialise, compress and write
+ * the savegame while the game continues in this process without any pause.
+ * The result is picked up by ProcessAsyncSaveFinish and WaitTillSnapshotSaved.
+ * @param fh The file to save to. This process closes it when the child has started.
+ * @return True if the child has taken over the saving, false if it has to be done by this process.
+ */
+static bool SaveSnapshot(FILE *fh)
+{
+#ifdef WITH_SNAPSHOT_SAVES
+	byte compression;
+	const SaveLoadFormat *fmt = GetSavegameFormat(_savegame_format, &compression);
+
+	/* The game's worker pool is only used by the game loop itself, so it is
+	 * idle now. Link graph jobs keep running; their threads only write to
+	 * the annotations of their job, while the savegame only contains the
+	 * job's copy of the link graph, which they never change. */
+	struct stat st;
+	if (fstat(fileno(fh), &st) != 0) return false;
+
+	pid_t pid = fork();
+	if (pid == -1) {
+		DEBUG(sl, 1, "Cannot fork savegame process, saving without snapshot...");
+		return false;
+	}
+
+	/* Never return into the game loop, nor run any of the parent's cleanup. */
+	if (pid == 0) _exit(WriteSnapshot(fh, fmt, compression) ? 0 : 1);
+
+	fclose(fh);
+	_save_child = pid;
+	_save_child_dev = st.st_dev;
+	_save_child_ino = st.st_ino;
+	return true;
+#else
+	return false;
+#endif /* WITH_SNAPSHOT_SAVES */
+}
+
 /**
  * Save the game using a (writer) filter.
  * @param writer   The filter to write the savegame to.
@@ -2708,12 +3264,13 @@ SaveOrLoadResult LoadWithFilter(LoadFilter *reader)
  * @param mode Save or load mode. Load can also be a TTD(Patch) game. Use #SL_LOAD, #SL_OLD_LOAD, #SL_LOAD_CHECK, or #SL_SAVE.
  * @param sb The sub directory to save the savegame in
  * @param threaded True when threaded saving is allowed
+ * @param snapshot True when saving may be done by a child process working on a snapshot of the game
  * @return Return the result of the action. #SL_OK, #SL_ERROR, or #SL_REINIT ("unload" the game)
  */
-SaveOrLoadResult SaveOrLoad(const char *filename, int mode, Subdirectory sb, bool threaded)
+SaveOrLoadResult SaveOrLoad(const char *filename, int mode, Subdirectory sb, bool threaded, bool snapshot)
 {
 	/* An instance of saving is already active, so don't go saving again */
-	if (_sl.saveinprogress && mode == SL_SAVE && threaded) {
+	if ((_sl.saveinprogress || IsSnapshotSaveInProgress()) && mode == SL_SAVE && threaded) {
 		/* if not an autosave, but a user action, show error message */
 		if (!_do_autosave) ShowErrorMessage(STR_ERROR_SAVE_STILL_IN_PROGRESS, INVALID_STRING_ID, WL_ERROR);
 		return SL_OK;
@@ -2750,6 +3307,15 @@ SaveOrLoadResult SaveOrLoad(const char *filename, int mode, Subdirectory sb, boo
 	}
 
 	try {
+		/* A snapshot that is being written to this file must be complete before it is replaced or read. */
+		if (mode == SL_SAVE && IsSnapshotSaveInProgress()) {
+			FILE *old = FioFOpenFile(filename, "rb", sb);
+			if (old != NULL) {
+				if (IsSnapshotSaveFile(old)) WaitTillSnapshotSaved();
+				fclose(old);
+			}
+		}
+
 		FILE *fh = (mode == SL_SAVE) ? FioFOpenFile(filename, "wb", sb) : FioFOpenFile(filename, "rb", sb);
 
 		/* Make it a little easier to load savegames from the console */
@@ -2763,6 +3329,7 @@ SaveOrLoadResult SaveOrLoad(const char *filename, int mode, Subdirectory sb, boo
 
 		if (mode == SL_SAVE) { // SAVE game
 			DEBUG(desync, 1, "save: %08x; %02x; %s", _date, _date_fract, filename);
+			if (snapshot && SaveSnapshot(fh)) return SL_OK;
 			if (_network_server || !_settings_client.gui.threaded_saves) threaded = false;
 
 			return DoSave(new FileWriter(fh), threaded);
@@ -2770,6 +3337,7 @@ SaveOrLoadResult SaveOrLoad(const char *filename, int mode, Subdirectory sb, boo
 
 		/* LOAD game */
 		assert(mode == SL_LOAD || mode == SL_LOAD_CHECK);
+		if (IsSnapshotSaveFile(fh)) WaitTillSnapshotSaved();
 		DEBUG(desync, 1, "load: %s", filename);
 		return DoLoad(new FileReader(fh), mode == SL_LOAD_CHECK);
 	} catch (...) {
@@ -46,8 +46,10 @@ enum SavegameType {
 void GenerateDefaultSaveName(char *buf, const char *last);
 void SetSaveLoadError(uint16 str);
 const char *GetSaveLoadErrorString();
-SaveOrLoadResult SaveOrLoad(const char *filename, int mode, Subdirectory sb, bool threaded = true);
+SaveOrLoadResult SaveOrLoad(const char *filename, int mode, Subdirectory sb, bool threaded = true, bool snapshot = false);
+bool IsSaveInProgress();
 void WaitTillSaved();
+void WaitTillSnapshotSaved();
 void ProcessAsyncSaveFinish();
 void DoExitSave();
 
@@ -291,7 +291,8 @@ const SaveLoad *GetGoodsDesc()
 	return goods_desc;
 }
 
-typedef std::pair<const StationID, std::list<CargoPacket *> > StationCargoPair;
+/** The packets with the same next hop, as they are stored in the savegame. */
+typedef std::pair<StationID, std::list<CargoPacket *> > StationCargoPair;
 
 static const SaveLoad _cargo_list_desc[] = {
 	SLE_VAR(StationCargoPair, first,  SLE_UINT16),
@@ -309,15 +310,17 @@ static void SwapPackets(GoodsEntry *ge)
 	StationCargoPacketMap &ge_packets = const_cast<StationCargoPacketMap &>(*ge->cargo.Packets());
 
 	if (_packets.empty()) {
-		std::map<StationID, std::list<CargoPacket *> >::iterator it(ge_packets.find(INVALID_STATION));
+		StationCargoPacketMap::MapIterator it(ge_packets.find(INVALID_STATION));
 		if (it == ge_packets.end()) {
 			return;
 		} else {
-			it->second.swap(_packets);
+			_packets.assign(it->second.begin(), it->second.end());
+			it->second.clear();
 		}
 	} else {
 		assert(ge_packets[INVALID_STATION].empty());
-		ge_packets[INVALID_STATION].swap(_packets);
+		ge_packets[INVALID_STATION].assign(_packets.begin(), _packets.end());
+		_packets.clear();
 	}
 }
 
@@ -490,7 +493,10 @@ static void RealSave_STNN(BaseStation *bst)
 				}
 			}
 			for (StationCargoPacketMap::ConstMapIterator it(st->goods[i].cargo.Packets()->begin()); it != st->goods[i].cargo.Packets()->end(); ++it) {
-				SlObject(const_cast<StationCargoPacketMap::value_type *>(&(*it)), _cargo_list_desc);
+				StationCargoPair pair;
+				pair.first = it->first;
+				pair.second.assign(it->second.begin(), it->second.end());
+				SlObject(&pair, _cargo_list_desc);
 			}
 		}
 	}
@@ -551,8 +557,10 @@ static void Load_STNN()
 					StationCargoPair pair;
 					for (uint j = 0; j < _num_dests; ++j) {
 						SlObject(&pair, _cargo_list_desc);
-						const_cast<StationCargoPacketMap &>(*(st->goods[i].cargo.Packets()))[pair.first].swap(pair.second);
-						assert(pair.second.empty());
+						StationCargoPacketMap::List &list = const_cast<StationCargoPacketMap &>(*(st->goods[i].cargo.Packets()))[pair.first];
+						assert(list.empty());
+						list.assign(pair.second.begin(), pair.second.end());
+						pair.second.clear();
 					}
 				}
 			}
@@ -583,8 +591,13 @@ static void Ptrs_STNN()
 				SwapPackets(ge);
 			} else {
 				SlObject(ge, GetGoodsDesc());
-				for (StationCargoPacketMap::ConstMapIterator it = ge->cargo.Packets()->begin(); it != ge->cargo.Packets()->end(); ++it) {
-					SlObject(const_cast<StationCargoPair *>(&(*it)), _cargo_list_desc);
+				StationCargoPacketMap &packets = const_cast<StationCargoPacketMap &>(*ge->cargo.Packets());
+				for (StationCargoPacketMap::MapIterator it = packets.begin(); it != packets.end(); ++it) {
+					StationCargoPair pair;
+					pair.first = it->first;
+					pair.second.assign(it->second.begin(), it->second.end());
+					SlObject(&pair, _cargo_list_desc);
+					it->second.assign(pair.second.begin(), pair.second.end());
 				}
 			}
 		}
@@ -67,6 +67,8 @@
 
 #include "void_map.h"
 #include "station_base.h"
+#include "vehicle_func.h"
+#include "pathfinder/yapf/yapf_cache.h"
 
 #include "table/strings.h"
 #include "table/settings.h"
@@ -1271,7 +1273,19 @@ static bool ChangeDynamicEngines(int32 p1)
 
 static bool StationCatchmentChanged(int32 p1)
 {
-	Station::RecomputeIndustriesNearForAll();
+	Station::RecomputeCatchmentForAll();
+	return true;
+}
+
+/**
+ * A setting used by the costs of cached YAPF rail segments changed.
+ * @param p1 unused.
+ * @return Always true.
+ */
+static bool YapfRailSettingsChanged(int32 p1)
+{
+	/* Forget all cached segments, as their costs depend on the penalties. */
+	YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
 	return true;
 }
 
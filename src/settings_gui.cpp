@@ -1589,6 +1589,7 @@ static SettingsPage _settings_economy_page = {_settings_economy, lengthof(_setti
 static SettingEntry _settings_linkgraph[] = {
 	SettingEntry("linkgraph.recalc_time"),
 	SettingEntry("linkgraph.recalc_interval"),
+	SettingEntry("linkgraph.recalc_jobs"),
 	SettingEntry("linkgraph.distribution_pax"),
 	SettingEntry("linkgraph.distribution_mail"),
 	SettingEntry("linkgraph.distribution_armoured"),
@@ -0,0 +1,104 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file spatial_index.cpp Indices of the locations of towns, stations and industries. */
+
+#include "stdafx.h"
+#include "spatial_index.h"
+#include "town.h"
+#include "station_base.h"
+#include "industry.h"
+
+static TownSpatialIndex _town_spatial_index;         ///< Location of every town.
+static StationSpatialIndex _station_spatial_index;   ///< Location of every station.
+static IndustrySpatialIndex _industry_spatial_index; ///< Location of every industry.
+
+/**
+ * Get the index of the towns, building it when it is out of date.
+ * @return The index.
+ */
+const TownSpatialIndex &GetTownSpatialIndex()
+{
+	if (!_town_spatial_index.IsValid()) {
+		_town_spatial_index.Reset();
+		const Town *t;
+		FOR_ALL_TOWNS(t) _town_spatial_index.Update(t->index, t->xy);
+	}
+	return _town_spatial_index;
+}
+
+/**
+ * Get the index of the stations, building it when it is out of date.
+ * @return The index.
+ */
+const StationSpatialIndex &GetStationSpatialIndex()
+{
+	if (!_station_spatial_index.IsValid()) {
+		_station_spatial_index.Reset();
+		const Station *st;
+		FOR_ALL_STATIONS(st) _station_spatial_index.Update(st->index, st->xy);
+	}
+	return _station_spatial_index;
+}
+
+/**
+ * Get the index of the industries, building it when it is out of date.
+ * @return The index.
+ */
+const IndustrySpatialIndex &GetIndustrySpatialIndex()
+{
+	if (!_industry_spatial_index.IsValid()) {
+		_industry_spatial_index.Reset();
+		const Industry *i;
+		FOR_ALL_INDUSTRIES(i) _industry_spatial_index.Update(i->index, i->location.tile);
+	}
+	return _industry_spatial_index;
+}
+
+/**
+ * Bring the location of a town in the index up to date.
+ * @param t The town.
+ * @param remove Whether the town is being deleted.
+ */
+void UpdateSpatialIndex(const Town *t, bool remove)
+{
+	_town_spatial_index.Update(t->index, remove ? INVALID_TILE : t->xy);
+}
+
+/**
+ * Bring the location of a station in the index up to date.
+ * @param st The station.
+ * @param remove Whether the station is being deleted.
+ */
+void UpdateSpatialIndex(const Station *st, bool remove)
+{
+	_station_spatial_index.Update(st->index, remove ? INVALID_TILE : st->xy);
+}
+
+/**
+ * Bring the location of an industry in the index up to date.
+ * @param i The industry.
+ * @param remove Whether the industry is being deleted.
+ */
+void UpdateSpatialIndex(const Industry *i, bool remove)
+{
+	_industry_spatial_index.Update(i->index, remove ? INVALID_TILE : i->location.tile);
+}
+
+/**
+ * Mark all indices as out of date, e.g. because a game has been loaded
+ * without going through the functions keeping them up to date. They are
+ * rebuilt on their next use.
+ */
+void InvalidateSpatialIndices()
+{
+	_town_spatial_index.Invalidate();
+	_station_spatial_index.Invalidate();
+	_industry_spatial_index.Invalidate();
+}
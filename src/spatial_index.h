@@ -0,0 +1,265 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file spatial_index.h Grid based index of the locations of towns, stations and industries. */
+
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include "map_func.h"
+#include "town_type.h"
+#include "station_type.h"
+#include "industry_type.h"
+#include <vector>
+#include <algorithm>
+
+/**
+ * Index of items of a pool by their location. The map is divided in square
+ * cells; each cell knows the items located in it, so queries only have to
+ * look at the cells near the tile they are about.
+ *
+ * Queries report items in the order of their index, or pick the item with
+ * the lowest index among equally good ones, so their results are the same
+ * as those of a loop over the whole pool.
+ * @tparam Tid Type of the index of the items.
+ */
+template <typename Tid>
+class SpatialIndex {
+public:
+	static const uint CELL_BITS = 6;                ///< Log2 of the width and height of a cell in tiles.
+	static const uint CELL_SIZE = 1 << CELL_BITS;   ///< Width and height of a cell in tiles.
+	static const uint NO_CELL = UINT_MAX;           ///< Cell of items that are not in the index.
+
+	/** An item in a cell. */
+	struct Entry {
+		Tid id;         ///< Index of the item.
+		TileIndex tile; ///< Location of the item.
+	};
+
+private:
+	typedef std::vector<Entry> Cell;
+
+	std::vector<Cell> cells;   ///< All cells, row by row.
+	std::vector<uint> cell_of; ///< Cell of each item, or #NO_CELL.
+	uint size_x;               ///< Number of cells along the X axis.
+	uint size_y;               ///< Number of cells along the Y axis.
+	uint map_size;             ///< Size of the map the index has been built for; 0 when it has to be rebuilt.
+
+	/**
+	 * Get the cell containing a tile.
+	 * @param tile The tile.
+	 * @return Index of the cell.
+	 */
+	inline uint GetCell(TileIndex tile) const
+	{
+		return (TileY(tile) >> CELL_BITS) * this->size_x + (TileX(tile) >> CELL_BITS);
+	}
+
+public:
+	SpatialIndex() : size_x(0), size_y(0), map_size(0) {}
+
+	/**
+	 * Check whether the index is up to date for the current map.
+	 * @return True iff the index can be queried.
+	 */
+	inline bool IsValid() const
+	{
+		return this->map_size == MapSize();
+	}
+
+	/** Mark the index as out of date; updates are ignored until it is reset. */
+	inline void Invalidate()
+	{
+		this->map_size = 0;
+	}
+
+	/** Clear the index and size it for the current map. Items have to be added again afterwards. */
+	void Reset()
+	{
+		this->size_x = MapSizeX() >> CELL_BITS;
+		this->size_y = MapSizeY() >> CELL_BITS;
+		this->cells.clear();
+		this->cells.resize(this->size_x * this->size_y);
+		this->cell_of.clear();
+		this->map_size = MapSize();
+	}
+
+	/**
+	 * Set the location of an item, adding it to the index when needed.
+	 * @param id   The item.
+	 * @param tile The new location, or \c INVALID_TILE to remove the item.
+	 */
+	void Update(Tid id, TileIndex tile)
+	{
+		if (!this->IsValid()) return;
+
+		uint new_cell = tile == INVALID_TILE ? (uint)NO_CELL : this->GetCell(tile);
+		if (id >= this->cell_of.size()) {
+			if (new_cell == NO_CELL) return;
+			this->cell_of.resize(id + 1, (uint)NO_CELL);
+		}
+
+		uint old_cell = this->cell_of[id];
+		if (old_cell != NO_CELL) {
+			Cell &cell = this->cells[old_cell];
+			for (typename Cell::iterator it = cell.begin(); it != cell.end(); ++it) {
+				if (it->id != id) continue;
+				if (old_cell == new_cell) {
+					it->tile = tile;
+					return;
+				}
+				*it = cell.back();
+				cell.pop_back();
+				break;
+			}
+		}
+
+		this->cell_of[id] = new_cell;
+		if (new_cell == NO_CELL) return;
+
+		Entry e = { id, tile };
+		this->cells[new_cell].push_back(e);
+	}
+
+	/**
+	 * Remove an item from the index.
+	 * @param id The item.
+	 */
+	inline void Remove(Tid id)
+	{
+		this->Update(id, INVALID_TILE);
+	}
+
+	/**
+	 * Find the item nearest to a tile.
+	 * The distance functor is called as \c dist(id, tile) with the index and
+	 * location of an item and returns the distance to that item, or \c UINT_MAX
+	 * to ignore the item. That distance may be smaller than the manhattan
+	 * distance between \a tile and the location of the item by at most \a slack.
+	 * @param tile      The tile to search from.
+	 * @param threshold Only items closer than this are accepted.
+	 * @param dist      The distance functor.
+	 * @param slack     How much \a dist may be smaller than the manhattan distance.
+	 * @param[out] found The nearest item; of equally near items the one with the lowest index.
+	 * @param[out] found_dist When not \c NULL, the distance to the found item.
+	 * @return False if nothing is near enough.
+	 * @pre IsValid()
+	 */
+	template <typename Tdist>
+	bool FindNearest(TileIndex tile, uint threshold, const Tdist &dist, uint slack, Tid *found, uint *found_dist = NULL) const
+	{
+		assert(this->IsValid());
+
+		int cx = TileX(tile) >> CELL_BITS;
+		int cy = TileY(tile) >> CELL_BITS;
+		int max_ring = max(max(cx, (int)this->size_x - 1 - cx), max(cy, (int)this->size_y - 1 - cy));
+
+		bool have_best = false;
+		uint best = threshold;
+		Tid best_id = 0;
+
+		for (int r = 0; r <= max_ring; r++) {
+			/* Lower bound of the manhattan distance to anything in this ring. */
+			if (r > 0) {
+				uint bound = (r - 1) * CELL_SIZE + 1;
+				if (bound > slack && bound - slack > best) break;
+				if (!have_best && bound > slack && bound - slack >= threshold) break;
+			}
+
+			for (int y = max(cy - r, 0); y <= min(cy + r, (int)this->size_y - 1); y++) {
+				/* Only the border of the ring; the inside has been done already. */
+				bool edge = y == cy - r || y == cy + r;
+				int step = edge ? 1 : 2 * r;
+				for (int x = cx - r; x <= cx + r; x += max(step, 1)) {
+					if (x < 0 || x >= (int)this->size_x) continue;
+
+					const Cell &cell = this->cells[y * this->size_x + x];
+					for (typename Cell::const_iterator it = cell.begin(); it != cell.end(); ++it) {
+						uint d = dist(it->id, it->tile);
+						if (d >= threshold) continue;
+						if (have_best && (d > best || (d == best && it->id > best_id))) continue;
+						have_best = true;
+						best = d;
+						best_id = it->id;
+					}
+				}
+			}
+		}
+
+		if (have_best) {
+			*found = best_id;
+			if (found_dist != NULL) *found_dist = best;
+		}
+		return have_best;
+	}
+
+	/**
+	 * Find all items within a square around a tile, i.e. all items whose
+	 * location is at most \a radius tiles away along both axes.
+	 * @param tile   The centre of the square.
+	 * @param radius The maximum distance along both axes.
+	 * @param[out] result The found items, sorted by index.
+	 * @pre IsValid()
+	 */
+	void FindInSquare(TileIndex tile, uint radius, std::vector<Tid> *result) const
+	{
+		assert(this->IsValid());
+
+		result->clear();
+		uint x = TileX(tile);
+		uint y = TileY(tile);
+		uint x0 = x > radius ? x - radius : 0;
+		uint y0 = y > radius ? y - radius : 0;
+		uint x1 = MapMaxX() - x > radius ? x + radius : MapMaxX();
+		uint y1 = MapMaxY() - y > radius ? y + radius : MapMaxY();
+
+		for (uint cy = y0 >> CELL_BITS; cy <= y1 >> CELL_BITS; cy++) {
+			for (uint cx = x0 >> CELL_BITS; cx <= x1 >> CELL_BITS; cx++) {
+				const Cell &cell = this->cells[cy * this->size_x + cx];
+				for (typename Cell::const_iterator it = cell.begin(); it != cell.end(); ++it) {
+					uint tx = TileX(it->tile);
+					uint ty = TileY(it->tile);
+					if (tx >= x0 && tx <= x1 && ty >= y0 && ty <= y1) result->push_back(it->id);
+				}
+			}
+		}
+		std::sort(result->begin(), result->end());
+	}
+};
+
+/** Distance functor for SpatialIndex::FindNearest that uses the manhattan distance to every item. */
+struct SpatialManhattanDistance {
+	TileIndex origin; ///< The tile to measure from.
+
+	SpatialManhattanDistance(TileIndex origin) : origin(origin) {}
+
+	inline uint operator()(uint id, TileIndex tile) const
+	{
+		return DistanceManhattan(this->origin, tile);
+	}
+};
+
+typedef SpatialIndex<TownID> TownSpatialIndex;         ///< Index of the centres of the towns.
+typedef SpatialIndex<StationID> StationSpatialIndex;   ///< Index of the signs of the stations; waypoints are not included.
+typedef SpatialIndex<IndustryID> IndustrySpatialIndex; ///< Index of the north tiles of the industries.
+
+struct Town;
+struct Station;
+struct Industry;
+
+const TownSpatialIndex &GetTownSpatialIndex();
+const StationSpatialIndex &GetStationSpatialIndex();
+const IndustrySpatialIndex &GetIndustrySpatialIndex();
+
+void UpdateSpatialIndex(const Town *t, bool remove = false);
+void UpdateSpatialIndex(const Station *st, bool remove = false);
+void UpdateSpatialIndex(const Industry *i, bool remove = false);
+void InvalidateSpatialIndices();
+
+#endif /* SPATIAL_INDEX_H */
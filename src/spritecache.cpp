@@ -19,6 +19,8 @@
 #include "blitter/factory.hpp"
 #include "core/math_func.hpp"
 #include "core/mem_func.hpp"
+#include "thread/worker_pool.h"
+#include "tick_profiler.h"
 
 #include "table/sprites.h"
 #include "table/strings.h"
@@ -26,6 +28,7 @@
 
 /* Default of 4MB spritecache */
 uint _sprite_cache_size = 4;
+bool _sprite_cache_warmup = false; ///< Whether to load all sprites into the sprite cache after loading the graphics.
 
 typedef SimpleTinyEnumT<SpriteType, byte> SpriteTypeByte;
 
@@ -80,6 +83,7 @@ struct MemBlock {
 };
 
 static uint _sprite_lru_counter;
+static uint _sprite_cache_generation; ///< Changes whenever cached sprites are evicted or moved.
 static MemBlock *_spritecache_ptr;
 static uint _allocated_sprite_cache_size = 0;
 static int _compact_cache_counter;
@@ -160,6 +164,17 @@ uint GetMaxSpriteID()
 	return _spritecache_items;
 }
 
+/**
+ * Get the generation of the sprite cache. It changes whenever sprites are
+ * evicted from or moved within the cache, i.e. when pointers to cached
+ * sprites may have become invalid.
+ * @return The current generation.
+ */
+uint GetSpriteCacheGeneration()
+{
+	return _sprite_cache_generation;
+}
+
 static bool ResizeSpriteIn(SpriteLoader::Sprite *sprite, ZoomLevel src, ZoomLevel tgt)
 {
 	uint8 scaled_1 = UnScaleByZoom(1, (ZoomLevel)(tgt - src));
@@ -370,6 +385,28 @@ static void *ReadRecolourSprite(uint16 file_slot, uint num)
 	return dest;
 }
 
+/**
+ * Load the pixel data of a sprite from disk, without encoding it for the blitter.
+ * @param sc            Location of sprite.
+ * @param[out] sprite   The sprites to fill with data, one for each zoom level.
+ * @return Bitmask of the zoom levels that were loaded; 0 when loading failed.
+ */
+static uint8 LoadSpriteData(const SpriteCache *sc, SpriteLoader::Sprite *sprite)
+{
+	uint8 sprite_avail = 0;
+	sprite[ZOOM_LVL_NORMAL].type = sc->type;
+
+	SpriteLoaderGrf sprite_loader(sc->container_ver);
+	if (sc->type != ST_MAPGEN && BlitterFactoryBase::GetCurrentBlitter()->GetScreenDepth() == 32) {
+		/* Try for 32bpp sprites first. */
+		sprite_avail = sprite_loader.LoadSprite(sprite, sc->file_slot, sc->file_pos, sc->type, true);
+	}
+	if (sprite_avail == 0) {
+		sprite_avail = sprite_loader.LoadSprite(sprite, sc->file_slot, sc->file_pos, sc->type, false);
+	}
+	return sprite_avail;
+}
+
 /**
  * Read a sprite from disk.
  * @param sc          Location of sprite.
@@ -381,7 +418,6 @@ static void *ReadRecolourSprite(uint16 file_slot, uint num)
 static void *ReadSprite(const SpriteCache *sc, SpriteID id, SpriteType sprite_type, AllocatorProc *allocator)
 {
 	uint8 file_slot = sc->file_slot;
-	size_t file_pos = sc->file_pos;
 
 	assert(sprite_type != ST_RECOLOUR);
 	assert(IsMapgenSpriteID(id) == (sprite_type == ST_MAPGEN));
@@ -390,17 +426,7 @@ static void *ReadSprite(const SpriteCache *sc, SpriteID id, SpriteType sprite_ty
 	DEBUG(sprite, 9, "Load sprite %d", id);
 
 	SpriteLoader::Sprite sprite[ZOOM_LVL_COUNT];
-	uint8 sprite_avail = 0;
-	sprite[ZOOM_LVL_NORMAL].type = sprite_type;
-
-	SpriteLoaderGrf sprite_loader(sc->container_ver);
-	if (sprite_type != ST_MAPGEN && BlitterFactoryBase::GetCurrentBlitter()->GetScreenDepth() == 32) {
-		/* Try for 32bpp sprites first. */
-		sprite_avail = sprite_loader.LoadSprite(sprite, file_slot, file_pos, sprite_type, true);
-	}
-	if (sprite_avail == 0) {
-		sprite_avail = sprite_loader.LoadSprite(sprite, file_slot, file_pos, sprite_type, false);
-	}
+	uint8 sprite_avail = LoadSpriteData(sc, sprite);
 
 	if (sprite_avail == 0) {
 		if (sprite_type == ST_MAPGEN) return NULL;
@@ -603,6 +629,16 @@ static size_t GetSpriteCacheUsage()
 	return tot_size;
 }
 
+/**
+ * Get the memory a sprite takes in the sprite cache.
+ * @param ptr The sprite, as allocated by AllocSprite.
+ * @return The size of the sprite's block, including its header.
+ */
+static inline size_t GetSpriteCacheBlockSize(const void *ptr)
+{
+	return ((const MemBlock *)ptr - 1)->size;
+}
+
 
 void IncreaseSpriteLRU()
 {
@@ -642,6 +678,8 @@ static void CompactSpriteCache()
 
 	DEBUG(sprite, 3, "Compacting sprite cache, inuse=" PRINTF_SIZE, GetSpriteCacheUsage());
 
+	_sprite_cache_generation++;
+
 	for (s = _spritecache_ptr; s->size != 0;) {
 		if (s->size & S_FREE_MASK) {
 			MemBlock *next = NextBlock(s);
@@ -687,6 +725,7 @@ static void DeleteEntryFromSpriteCache(uint item)
 	assert(!(s->size & S_FREE_MASK));
 	s->size |= S_FREE_MASK;
 	GetSpriteCache(item)->ptr = NULL;
+	_sprite_cache_generation++;
 
 	/* And coalesce adjacent free blocks */
 	for (s = _spritecache_ptr; s->size != 0; s = NextBlock(s)) {
@@ -843,6 +882,203 @@ void *GetRawSprite(SpriteID sprite, SpriteType type, AllocatorProc *allocator)
 	}
 }
 
+/** Number of sprites that are decoded at once by #PrefetchSprites. */
+static const uint PREFETCH_BATCH_SIZE = 64;
+
+/** A sprite that is being decoded by #PrefetchSprites. */
+struct PrefetchedSprite {
+	SpriteID id;                                 ///< The sprite.
+	uint8 sprite_avail;                          ///< Zoom levels that were loaded from disk.
+	SpriteLoader::Sprite sprite[ZOOM_LVL_COUNT]; ///< The loaded, but not yet encoded, sprite.
+	ReusableBuffer<SpriteLoader::CommonPixel> buffer[ZOOM_LVL_COUNT]; ///< Pixel data of #sprite, owned so it can be encoded on any thread.
+	MemBlock *encoded;                           ///< The encoded sprite, or NULL if it could not be encoded.
+
+	PrefetchedSprite()
+	{
+		for (ZoomLevel zoom = ZOOM_LVL_BEGIN; zoom != ZOOM_LVL_END; zoom++) this->sprite[zoom].own_buffer = this->buffer;
+	}
+};
+
+/** Two batches of prefetched sprites; one is loaded from disk while the other is being encoded. */
+static PrefetchedSprite _prefetched_sprites[2][PREFETCH_BATCH_SIZE];
+
+/**
+ * Allocate the memory of a sprite that is encoded outside of the sprite cache.
+ * Safe to be called from any thread.
+ * @param size Size of the sprite.
+ * @return The memory for the sprite; the size is stored in the #MemBlock before it.
+ */
+static void *AllocPrefetchedSprite(size_t size)
+{
+	MemBlock *block = (MemBlock *)MallocT<byte>(sizeof(MemBlock) + size);
+	block->size = size;
+	return block->data;
+}
+
+/**
+ * Resize and encode a loaded sprite for the current blitter. Only touches
+ * the given #PrefetchedSprite, so it may be called from any thread.
+ * @param data  The batch of sprites.
+ * @param index The sprite in the batch to encode.
+ */
+static void EncodePrefetchedSprite(void *data, uint index)
+{
+	PrefetchedSprite *ps = (PrefetchedSprite *)data + index;
+	ps->encoded = NULL;
+	if (!ResizeSprites(ps->sprite, ps->sprite_avail, GetSpriteCache(ps->id)->file_slot, ps->id)) return;
+
+	Sprite *s = BlitterFactoryBase::GetCurrentBlitter()->Encode(ps->sprite, AllocPrefetchedSprite);
+	ps->encoded = (MemBlock *)s - 1;
+}
+
+/**
+ * Move encoded sprites into the sprite cache.
+ * @param batch  The batch of sprites.
+ * @param count  Number of sprites in the batch.
+ * @param budget If not NULL, the number of bytes that may still be added to the sprite cache.
+ *               Once it is used up, the remaining sprites are dropped.
+ */
+static void InstallPrefetchedSprites(PrefetchedSprite *batch, uint count, size_t *budget)
+{
+	for (PrefetchedSprite *ps = batch; ps != batch + count; ps++) {
+		/* Sprites that could not be encoded are left to GetRawSprite, which knows what to fall back to. */
+		if (ps->encoded == NULL) continue;
+
+		SpriteCache *sc = GetSpriteCache(ps->id);
+		if (sc->ptr == NULL && (budget == NULL || *budget != 0)) {
+			sc->ptr = AllocSprite(ps->encoded->size);
+			memcpy(sc->ptr, ps->encoded->data, ps->encoded->size);
+			sc->lru = ++_sprite_lru_counter;
+			if (budget != NULL) *budget -= min(*budget, GetSpriteCacheBlockSize(sc->ptr));
+		}
+		free(ps->encoded);
+	}
+}
+
+/**
+ * Check whether a sprite is part of a batch of prefetched sprites.
+ * @param batch The batch of sprites.
+ * @param count Number of sprites in the batch.
+ * @param id    The sprite to look for.
+ * @return True if the sprite is in the batch.
+ */
+static bool IsInPrefetchBatch(const PrefetchedSprite *batch, uint count, SpriteID id)
+{
+	for (const PrefetchedSprite *ps = batch; ps != batch + count; ps++) {
+		if (ps->id == id) return true;
+	}
+	return false;
+}
+
+/**
+ * Load the given sprites into the sprite cache ahead of their use. The
+ * sprites are read from disk by the calling thread, while the game's worker
+ * threads resize and encode them for the blitter. Sprites that are cached
+ * already, are not normal sprites or fail to load are skipped; GetRawSprite
+ * handles those as usual once they are drawn.
+ * @param sprites The sprites that are going to be drawn; may contain duplicates.
+ * @param count   Number of sprites.
+ * @param budget  If not NULL, the number of bytes that may still be added to the sprite cache;
+ *                it is reduced by the sprites that are installed, and loading stops when it is used up.
+ * @return False if sprites cannot be encoded concurrently, so nothing has been loaded.
+ */
+bool PrefetchSprites(const SpriteID *sprites, uint count, size_t *budget)
+{
+	WorkerPool *pool = GetGameWorkerPool();
+	if (pool->GetWorkerCount() == 0) return false;
+
+	/* The 8bpp optimised blitter encodes via a shared scratch buffer, so it cannot encode concurrently. */
+	if (BlitterFactoryBase::GetCurrentBlitter()->GetScreenDepth() != 32) return false;
+
+	/* Sprites of one batch are loaded while those of the other are encoded. */
+	WorkerBatch batch;
+	uint cur = 0;      // Batch that is being loaded.
+	uint loaded = 0;   // Number of sprites in the batch that is being loaded.
+	uint encoding = 0; // Number of sprites in the batch that is being encoded.
+
+	for (uint i = 0; i <= count; i++) {
+		/* Once the budget is used up, only the batch that is being encoded is finished. */
+		if (budget != NULL && *budget == 0) break;
+
+		if (i < count) {
+			SpriteID id = sprites[i] & SPRITE_MASK;
+			if (!SpriteExists(id)) continue;
+
+			SpriteCache *sc = GetSpriteCache(id);
+			if (sc->ptr != NULL || sc->type != ST_NORMAL) continue;
+			if (IsInPrefetchBatch(_prefetched_sprites[cur], loaded, id)) continue;
+			if (IsInPrefetchBatch(_prefetched_sprites[1 - cur], encoding, id)) continue;
+
+			PrefetchedSprite *ps = &_prefetched_sprites[cur][loaded];
+			ps->id = id;
+			ps->sprite_avail = LoadSpriteData(sc, ps->sprite);
+			if (ps->sprite_avail == 0) continue;
+			if (++loaded < PREFETCH_BATCH_SIZE) continue;
+		}
+
+		/* The batch is full, or there is nothing left to load. */
+		if (batch.IsActive()) {
+			pool->Wait(&batch);
+			InstallPrefetchedSprites(_prefetched_sprites[1 - cur], encoding, budget);
+			encoding = 0;
+		}
+		if (loaded == 0) continue;
+
+		/* Encode the loaded batch, while the next one is read. */
+		pool->Start(&batch, &EncodePrefetchedSprite, _prefetched_sprites[cur], loaded);
+		encoding = loaded;
+		loaded = 0;
+		cur = 1 - cur;
+	}
+
+	if (batch.IsActive()) {
+		pool->Wait(&batch);
+		InstallPrefetchedSprites(_prefetched_sprites[1 - cur], encoding, budget);
+	}
+	return true;
+}
+
+/** Number of sprites that are considered at once while warming up the sprite cache. */
+static const uint WARMUP_CHUNK_SIZE = 256;
+
+/**
+ * Load all normal sprites into the sprite cache, when enabled by the
+ * \c sprite_cache_warmup setting, so they do not have to be decoded while
+ * playing. The sprites are encoded by the worker threads when possible.
+ * Loading stops as soon as the cache is three quarters full, so the sprites
+ * that were loaded first are not evicted again.
+ */
+void WarmUpSpriteCache()
+{
+	if (!_sprite_cache_warmup || BlitterFactoryBase::GetCurrentBlitter()->GetScreenDepth() == 0) return;
+
+	uint64 start = GetProfilerTime();
+	size_t limit = _allocated_sprite_cache_size / 4 * 3;
+	size_t used = GetSpriteCacheUsage();
+	size_t budget = limit > used ? limit - used : 0;
+	SpriteID chunk[WARMUP_CHUNK_SIZE];
+
+	SpriteID id = 0;
+	while (id < _spritecache_items && budget != 0) {
+		uint count = 0;
+		for (; id < _spritecache_items && count < WARMUP_CHUNK_SIZE; id++) {
+			if (!SpriteExists(id)) continue;
+
+			const SpriteCache *sc = GetSpriteCache(id);
+			if (sc->ptr == NULL && sc->type == ST_NORMAL) chunk[count++] = id;
+		}
+
+		if (PrefetchSprites(chunk, count, &budget)) continue;
+
+		/* No concurrent encoding, so decode the sprites one by one. */
+		for (uint i = 0; i < count && budget != 0; i++) {
+			budget -= min(budget, GetSpriteCacheBlockSize(GetRawSprite(chunk[i], ST_NORMAL)));
+		}
+	}
+
+	DEBUG(sprite, 1, "Warmed up the sprite cache up to sprite %u of %u in %u ms; " PRINTF_SIZE " of " PRINTF_SIZE " bytes used",
+			id, _spritecache_items, (uint)((GetProfilerTime() - start) / 1000), GetSpriteCacheUsage(), (size_t)_allocated_sprite_cache_size);
+}
 
 static void GfxInitSpriteCache()
 {
@@ -24,6 +24,7 @@ struct Sprite {
 };
 
 extern uint _sprite_cache_size;
+extern bool _sprite_cache_warmup;
 
 typedef void *AllocatorProc(size_t size);
 
@@ -33,6 +34,7 @@ bool SpriteExists(SpriteID sprite);
 SpriteType GetSpriteType(SpriteID sprite);
 uint GetOriginFileSlot(SpriteID sprite);
 uint GetMaxSpriteID();
+uint GetSpriteCacheGeneration();
 
 
 static inline const Sprite *GetSprite(SpriteID sprite, SpriteType type)
@@ -47,6 +49,9 @@ static inline const byte *GetNonSprite(SpriteID sprite, SpriteType type)
 	return (byte*)GetRawSprite(sprite, type);
 }
 
+bool PrefetchSprites(const SpriteID *sprites, uint count, size_t *budget = NULL);
+void WarmUpSpriteCache();
+
 void GfxInitSpriteMem();
 void GfxClearSpriteCache();
 void IncreaseSpriteLRU();
@@ -52,41 +52,54 @@ static bool WarnCorruptSprite(uint8 file_slot, size_t file_pos, int line)
 	return false;
 }
 
+/** Reader of compressed sprite data from the current file, through the Fio buffer. */
+struct FioSpriteReader {
+	inline bool HasData(size_t size) const { return true; }
+	inline byte ReadByte() { return FioReadByte(); }
+	inline void ReadBlock(byte *dest, size_t size) { FioReadBlock(dest, size); }
+};
+
+/** Reader of compressed sprite data straight from a memory mapped file. */
+struct MappedSpriteReader {
+	const byte *pos; ///< Next byte to read.
+	const byte *end; ///< End of the mapped data.
+
+	MappedSpriteReader(const byte *pos, const byte *end) : pos(pos), end(end) {}
+
+	inline bool HasData(size_t size) const { return (size_t)(this->end - this->pos) >= size; }
+	inline byte ReadByte() { return *this->pos++; }
+	inline void ReadBlock(byte *dest, size_t size) { memcpy(dest, this->pos, size); this->pos += size; }
+};
+
 /**
- * Decode the image data of a single sprite.
- * @param[in,out] sprite Filled with the sprite image data.
- * @param file_slot File slot.
- * @param file_pos File position.
- * @param sprite_type Type of the sprite we're decoding.
+ * Decompress the image data of a sprite.
+ * @param reader The reader of the compressed data.
+ * @param dest_orig Buffer for the decompressed data.
  * @param num Size of the decompressed sprite.
- * @param type Type of the encoded sprite.
- * @param zoom_lvl Requested zoom level.
- * @param colour_fmt Colour format of the sprite.
- * @param container_format Container format of the GRF this sprite is in.
- * @return True if the sprite was successfully loaded.
+ * @param file_slot File slot, for reporting corrupt sprites.
+ * @param file_pos File position, for reporting corrupt sprites.
+ * @return True if the sprite was successfully decompressed.
  */
-bool DecodeSingleSprite(SpriteLoader::Sprite *sprite, uint8 file_slot, size_t file_pos, SpriteType sprite_type, int64 num, byte type, ZoomLevel zoom_lvl, byte colour_fmt, byte container_format)
+template <class Treader>
+static bool DecompressSprite(Treader &reader, byte *dest_orig, int64 num, uint8 file_slot, size_t file_pos)
 {
-	AutoFreePtr<byte> dest_orig(MallocT<byte>(num));
 	byte *dest = dest_orig;
-	const int64 dest_size = num;
 
 	/* Read the file, which has some kind of compression */
 	while (num > 0) {
-		int8 code = FioReadByte();
+		if (!reader.HasData(2)) return WarnCorruptSprite(file_slot, file_pos, __LINE__);
+		int8 code = reader.ReadByte();
 
 		if (code >= 0) {
 			/* Plain bytes to read */
 			int size = (code == 0) ? 0x80 : code;
 			num -= size;
-			if (num < 0) return WarnCorruptSprite(file_slot, file_pos, __LINE__);
-			for (; size > 0; size--) {
-				*dest = FioReadByte();
-				dest++;
-			}
+			if (num < 0 || !reader.HasData(size)) return WarnCorruptSprite(file_slot, file_pos, __LINE__);
+			reader.ReadBlock(dest, size);
+			dest += size;
 		} else {
 			/* Copy bytes from earlier in the sprite */
-			const uint data_offset = ((code & 7) << 8) | FioReadByte();
+			const uint data_offset = ((code & 7) << 8) | reader.ReadByte();
 			if (dest - data_offset < dest_orig) return WarnCorruptSprite(file_slot, file_pos, __LINE__);
 			int size = -(code >> 3);
 			num -= size;
@@ -99,6 +112,40 @@ bool DecodeSingleSprite(SpriteLoader::Sprite *sprite, uint8 file_slot, size_t fi
 	}
 
 	if (num != 0) return WarnCorruptSprite(file_slot, file_pos, __LINE__);
+	return true;
+}
+
+/**
+ * Decode the image data of a single sprite.
+ * @param[in,out] sprite Filled with the sprite image data.
+ * @param file_slot File slot.
+ * @param file_pos File position.
+ * @param sprite_type Type of the sprite we're decoding.
+ * @param num Size of the decompressed sprite.
+ * @param type Type of the encoded sprite.
+ * @param zoom_lvl Requested zoom level.
+ * @param colour_fmt Colour format of the sprite.
+ * @param container_format Container format of the GRF this sprite is in.
+ * @return True if the sprite was successfully loaded.
+ */
+bool DecodeSingleSprite(SpriteLoader::Sprite *sprite, uint8 file_slot, size_t file_pos, SpriteType sprite_type, int64 num, byte type, ZoomLevel zoom_lvl, byte colour_fmt, byte container_format)
+{
+	AutoFreePtr<byte> dest_orig(MallocT<byte>(num));
+	byte *dest;
+	const int64 dest_size = num;
+
+	/* Memory mapped files are decompressed straight from the mapping. */
+	size_t mapped_size;
+	const byte *mapped = FioGetMappedData(&mapped_size);
+	if (mapped != NULL) {
+		MappedSpriteReader reader(mapped, mapped + mapped_size);
+		bool valid = DecompressSprite(reader, dest_orig, num, file_slot, file_pos);
+		FioSkipBytes(reader.pos - mapped);
+		if (!valid) return false;
+	} else {
+		FioSpriteReader reader;
+		if (!DecompressSprite(reader, dest_orig, num, file_slot, file_pos)) return false;
+	}
 
 	sprite->AllocateData(zoom_lvl, sprite->width * sprite->height);
 
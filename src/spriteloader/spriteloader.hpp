@@ -32,6 +32,8 @@ public:
 	 * You can only use this struct once at a time when using AllocateData to
 	 * allocate the memory as that will always return the same memory address.
 	 * This to prevent thousands of malloc + frees just to load a sprite.
+	 * Sprites that need to live next to others, e.g. to be encoded on another
+	 * thread, can be given their own buffers via #own_buffer.
 	 */
 	struct Sprite {
 		uint16 height;                   ///< Height of the sprite
@@ -40,13 +42,20 @@ public:
 		int16 y_offs;                    ///< The y-offset of where the sprite will be drawn
 		SpriteType type;                 ///< The sprite type
 		SpriteLoader::CommonPixel *data; ///< The sprite itself
+		ReusableBuffer<SpriteLoader::CommonPixel> *own_buffer; ///< Buffers (one per zoom level) to allocate the data in, or NULL to use the shared ones.
+
+		Sprite() : data(NULL), own_buffer(NULL) {}
 
 		/**
 		 * Allocate the sprite data of this sprite.
 		 * @param zoom Zoom level to allocate the data for.
 		 * @param size the minimum size of the data field.
 		 */
-		void AllocateData(ZoomLevel zoom, size_t size) { this->data = Sprite::buffer[zoom].ZeroAllocate(size); }
+		void AllocateData(ZoomLevel zoom, size_t size)
+		{
+			ReusableBuffer<SpriteLoader::CommonPixel> *buffers = this->own_buffer != NULL ? this->own_buffer : Sprite::buffer;
+			this->data = buffers[zoom].ZeroAllocate(size);
+		}
 	private:
 		/** Allocated memory to pass sprite data around */
 		static ReusableBuffer<SpriteLoader::CommonPixel> buffer[ZOOM_LVL_COUNT];
@@ -26,6 +26,7 @@
 #include "core/random_func.hpp"
 #include "linkgraph/linkgraph.h"
 #include "linkgraph/linkgraphschedule.h"
+#include "spatial_index.h"
 
 #include "table/strings.h"
 
@@ -63,9 +64,11 @@ Station::Station(TileIndex tile) :
 	indtype(IT_INVALID),
 	time_since_load(255),
 	time_since_unload(255),
-	last_vehicle_type(VEH_INVALID)
+	last_vehicle_type(VEH_INVALID),
+	catchment_index_area(INVALID_TILE, 0, 0)
 {
 	/* this->random_bits is set in Station::AddFacility() */
+	UpdateSpatialIndex(this);
 }
 
 /**
@@ -88,6 +91,8 @@ Station::~Station()
 		this->loading_vehicles.front()->LeaveStation();
 	}
 
+	UpdateStationCatchmentIndex(this, true);
+
 	Aircraft *a;
 	FOR_ALL_AIRCRAFT(a) {
 		if (!a->IsNormalAircraft()) continue;
@@ -146,6 +151,7 @@ Station::~Station()
 	}
 
 	CargoPacket::InvalidateAllFrom(this->index);
+	UpdateSpatialIndex(this, true);
 }
 
 
@@ -190,6 +196,7 @@ void Station::AddFacility(StationFacility new_facility_bit, TileIndex facil_xy)
 	if (this->facilities == FACIL_NONE) {
 		this->xy = facil_xy;
 		this->random_bits = Random();
+		UpdateSpatialIndex(this);
 	}
 	this->facilities |= new_facility_bit;
 	this->owner = _current_company;
@@ -384,6 +391,28 @@ void Station::RecomputeIndustriesNear()
 	FOR_ALL_STATIONS(st) st->RecomputeIndustriesNear();
 }
 
+/**
+ * Recomputes everything that depends on the catchment of the station, i.e.
+ * Station::industries_near and the station's part of the catchment index.
+ * To be called whenever tiles are added to or removed from the station.
+ */
+void Station::RecomputeCatchment()
+{
+	this->RecomputeIndustriesNear();
+	UpdateStationCatchmentIndex(this);
+}
+
+/**
+ * Recomputes the catchment of all stations, and rebuilds the catchment index.
+ */
+/* static */ void Station::RecomputeCatchmentForAll()
+{
+	InitializeStationCatchmentIndex();
+
+	Station *st;
+	FOR_ALL_STATIONS(st) st->RecomputeCatchment();
+}
+
 /************************************************************************/
 /*                     StationRect implementation                       */
 /************************************************************************/
@@ -464,6 +464,7 @@ public:
 	uint32 always_accepted;       ///< Bitmask of always accepted cargo types (by houses, HQs, industry tiles when industry doesn't accept cargo)
 
 	IndustryVector industries_near; ///< Cached list of industries near the station that can accept cargo, @see DeliverGoodsToIndustry()
+	TileArea catchment_index_area;  ///< Area in which the station is registered in the catchment index, @see UpdateStationCatchmentIndex()
 
 	Station(TileIndex tile = INVALID_TILE);
 	~Station();
@@ -478,6 +479,8 @@ public:
 	/* virtual */ uint GetPlatformLength(TileIndex tile) const;
 	void RecomputeIndustriesNear();
 	static void RecomputeIndustriesNearForAll();
+	void RecomputeCatchment();
+	static void RecomputeCatchmentForAll();
 
 	uint GetCatchmentRadius() const;
 	Rect GetCatchmentRect() const;
@@ -0,0 +1,287 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file station_catchment.cpp Index of the stations whose catchment covers each tile. */
+
+#include "stdafx.h"
+#include "station_base.h"
+#include "station_func.h"
+#include "map_func.h"
+#include "core/alloc_func.hpp"
+#include "core/mem_func.hpp"
+#include "debug.h"
+#include <vector>
+#include <map>
+#include <algorithm>
+
+/**
+ * Identifier of a set of stations in the catchment index. Tiles covered by
+ * the same stations share the same set, so a small identifier per tile
+ * suffices to describe which stations a tile is in the catchment of.
+ */
+typedef uint16 CatchmentSetID;
+
+static const CatchmentSetID CATCHMENT_SET_NONE = 0;              ///< The set of tiles not in the catchment of any station.
+static const uint MAX_CATCHMENT_SETS = (1 << (8 * sizeof(CatchmentSetID))); ///< Maximum number of sets, including #CATCHMENT_SET_NONE.
+
+typedef std::vector<StationID> CatchmentStations; ///< Sorted list of the stations of a set.
+
+/** A set of stations whose catchment covers a tile. */
+struct CatchmentSet {
+	CatchmentStations stations; ///< The stations, sorted by index.
+	uint tiles;                 ///< Number of tiles that use this set.
+
+	CatchmentSet() : tiles(0) {}
+
+	/**
+	 * Check whether a station is part of the set.
+	 * @param station The station to look for.
+	 * @return True iff the station is in the set.
+	 */
+	inline bool Contains(StationID station) const
+	{
+		return std::binary_search(this->stations.begin(), this->stations.end(), station);
+	}
+};
+
+static CatchmentSetID *_catchment_index = NULL; ///< The set of every tile of the map.
+static uint _catchment_index_size = 0;          ///< Number of tiles #_catchment_index has been allocated for.
+static bool _catchment_index_valid = false;     ///< Whether the index is complete, i.e. it did not run out of sets.
+
+static std::vector<CatchmentSet> _catchment_sets;                          ///< All sets; unused ones have no tiles.
+static std::vector<CatchmentSetID> _free_catchment_sets;                   ///< Sets that are not used by any tile.
+static std::map<CatchmentStations, CatchmentSetID> _catchment_set_lookup; ///< Set for each combination of stations in use.
+
+/**
+ * Clear the catchment index and size it for the current map. Stations have to
+ * be added again with #UpdateStationCatchmentIndex afterwards.
+ */
+void InitializeStationCatchmentIndex()
+{
+	if (_catchment_index_size != MapSize()) {
+		free(_catchment_index);
+		_catchment_index = MallocT<CatchmentSetID>(MapSize());
+		_catchment_index_size = MapSize();
+	}
+	MemSetT(_catchment_index, CATCHMENT_SET_NONE, _catchment_index_size);
+
+	_catchment_sets.clear();
+	_catchment_sets.resize(1); // CATCHMENT_SET_NONE
+	_free_catchment_sets.clear();
+	_catchment_set_lookup.clear();
+	_catchment_index_valid = true;
+
+	Station *st;
+	FOR_ALL_STATIONS(st) st->catchment_index_area = TileArea(INVALID_TILE, 0, 0);
+}
+
+/**
+ * Check whether the catchment index can be used for the current map.
+ * @return True iff the index is complete.
+ */
+static inline bool IsCatchmentIndexValid()
+{
+	return _catchment_index_valid && _catchment_index_size == MapSize();
+}
+
+/** Changes to the catchment index caused by one station. */
+struct CatchmentIndexUpdate {
+	StationID station;                                 ///< The station being added or removed.
+	std::map<CatchmentSetID, CatchmentSetID> added;   ///< Set including the station for each set seen so far.
+	std::map<CatchmentSetID, CatchmentSetID> removed; ///< Set excluding the station for each set seen so far.
+	std::vector<CatchmentSetID> emptied;              ///< Sets that lost their last tile during the update.
+
+	CatchmentIndexUpdate(StationID station) : station(station) {}
+
+	/**
+	 * Get the set for a combination of stations, creating it when needed.
+	 * @param stations The stations, sorted by index.
+	 * @param[out] set The set of the stations.
+	 * @return False if there are no free sets left.
+	 */
+	bool GetSet(const CatchmentStations &stations, CatchmentSetID *set)
+	{
+		if (stations.empty()) {
+			*set = CATCHMENT_SET_NONE;
+			return true;
+		}
+
+		std::map<CatchmentStations, CatchmentSetID>::const_iterator it = _catchment_set_lookup.find(stations);
+		if (it != _catchment_set_lookup.end()) {
+			*set = it->second;
+			return true;
+		}
+
+		if (!_free_catchment_sets.empty()) {
+			*set = _free_catchment_sets.back();
+			_free_catchment_sets.pop_back();
+		} else {
+			if (_catchment_sets.size() == MAX_CATCHMENT_SETS) return false;
+			*set = (CatchmentSetID)_catchment_sets.size();
+			_catchment_sets.resize(_catchment_sets.size() + 1);
+		}
+
+		_catchment_sets[*set].stations = stations;
+		_catchment_set_lookup[stations] = *set;
+		return true;
+	}
+
+	/**
+	 * Add the station to, or remove it from, the set of a tile.
+	 * @param tile The tile to change.
+	 * @param add  Whether the tile is in the catchment of the station.
+	 * @return False if there are no free sets left.
+	 */
+	bool SetTile(TileIndex tile, bool add)
+	{
+		CatchmentSetID old_set = _catchment_index[tile];
+		if (_catchment_sets[old_set].Contains(this->station) == add) return true;
+
+		/* Sets are not freed before the update is finished, so these stay valid. */
+		std::map<CatchmentSetID, CatchmentSetID> &transitions = add ? this->added : this->removed;
+		CatchmentSetID new_set;
+		std::map<CatchmentSetID, CatchmentSetID>::const_iterator it = transitions.find(old_set);
+		if (it != transitions.end()) {
+			new_set = it->second;
+		} else {
+			CatchmentStations stations = _catchment_sets[old_set].stations;
+			if (add) {
+				stations.insert(std::lower_bound(stations.begin(), stations.end(), this->station), this->station);
+			} else {
+				stations.erase(std::lower_bound(stations.begin(), stations.end(), this->station));
+			}
+			if (!this->GetSet(stations, &new_set)) return false;
+			transitions[old_set] = new_set;
+		}
+
+		if (old_set != CATCHMENT_SET_NONE && --_catchment_sets[old_set].tiles == 0) this->emptied.push_back(old_set);
+		if (new_set != CATCHMENT_SET_NONE) _catchment_sets[new_set].tiles++;
+		_catchment_index[tile] = new_set;
+		return true;
+	}
+
+	/** Release the sets that are no longer used by any tile. */
+	void Finish()
+	{
+		for (std::vector<CatchmentSetID>::const_iterator it = this->emptied.begin(); it != this->emptied.end(); ++it) {
+			CatchmentSet &set = _catchment_sets[*it];
+			if (set.tiles != 0 || set.stations.empty()) continue;
+
+			_catchment_set_lookup.erase(set.stations);
+			set.stations.clear();
+			_free_catchment_sets.push_back(*it);
+		}
+	}
+};
+
+/**
+ * Mark the tiles within a radius of the marked tiles of a line.
+ * @param src    First tile of the line with the marks.
+ * @param dst    First tile of the line to write the result to.
+ * @param length Number of tiles of the line.
+ * @param stride Distance between consecutive tiles of the line.
+ * @param radius The radius.
+ */
+static void DilateLine(const byte *src, byte *dst, uint length, uint stride, uint radius)
+{
+	/* Distance to the nearest mark before, and after, each tile. */
+	uint dist = UINT_MAX;
+	for (uint i = 0; i < length; i++) {
+		dist = src[i * stride] != 0 ? 0 : (dist == UINT_MAX ? UINT_MAX : dist + 1);
+		dst[i * stride] = dist <= radius;
+	}
+	dist = UINT_MAX;
+	for (uint i = length; i-- > 0;) {
+		dist = src[i * stride] != 0 ? 0 : (dist == UINT_MAX ? UINT_MAX : dist + 1);
+		if (dist <= radius) dst[i * stride] = 1;
+	}
+}
+
+/**
+ * Bring the catchment index up to date for a station, after tiles of it
+ * have been built or removed or its catchment radius changed.
+ * @param st The station.
+ * @param remove Whether to remove the station from the index entirely.
+ */
+void UpdateStationCatchmentIndex(Station *st, bool remove)
+{
+	if (!IsCatchmentIndexValid()) return;
+
+	TileArea area(INVALID_TILE, 0, 0);
+	std::vector<byte> covered;
+
+	if (!remove && !st->rect.IsEmpty()) {
+		Rect r = st->GetCatchmentRect();
+		area = TileArea(TileXY(r.left, r.top), TileXY(r.right, r.bottom));
+		uint x0 = TileX(area.tile);
+		uint y0 = TileY(area.tile);
+
+		/* Mark the tiles of the station, then every tile within the catchment radius of those. */
+		std::vector<byte> station_tiles(area.w * area.h, 0);
+		TileArea station_area(TileXY(st->rect.left, st->rect.top), TileXY(st->rect.right, st->rect.bottom));
+		TILE_AREA_LOOP(tile, station_area) {
+			if (IsTileType(tile, MP_STATION) && GetStationIndex(tile) == st->index) {
+				station_tiles[(TileY(tile) - y0) * area.w + TileX(tile) - x0] = 1;
+			}
+		}
+
+		uint radius = st->GetCatchmentRadius();
+		std::vector<byte> rows(area.w * area.h);
+		covered.resize(area.w * area.h);
+		for (uint y = 0; y < area.h; y++) DilateLine(&station_tiles[y * area.w], &rows[y * area.w], area.w, 1, radius);
+		for (uint x = 0; x < area.w; x++) DilateLine(&rows[x], &covered[x], area.h, area.w, radius);
+	}
+
+	CatchmentIndexUpdate update(st->index);
+	bool ok = true;
+
+	/* Remove the station from the tiles it does not cover anymore... */
+	TILE_AREA_LOOP(tile, st->catchment_index_area) {
+		if (area.Contains(tile)) continue;
+		if (!(ok = update.SetTile(tile, false))) break;
+	}
+	/* ... and bring the tiles of the current catchment area up to date. */
+	if (ok && area.tile != INVALID_TILE) {
+		uint i = 0;
+		TILE_AREA_LOOP(tile, area) {
+			if (!(ok = update.SetTile(tile, covered[i++] != 0))) break;
+		}
+	}
+	update.Finish();
+
+	st->catchment_index_area = area;
+	if (!ok) {
+		DEBUG(misc, 1, "Too many distinct station catchments; falling back to scanning for stations");
+		_catchment_index_valid = false;
+	}
+}
+
+/**
+ * Find the stations whose catchment covers any tile of an area, using the catchment index.
+ * @param location The area to look at.
+ * @param[in,out] stations The list to add the found stations to.
+ * @return False if the index is not available, so nothing has been added.
+ */
+bool FindStationsInCatchmentIndex(const TileArea &location, StationList *stations)
+{
+	if (!IsCatchmentIndexValid()) return false;
+
+	CatchmentSetID last = CATCHMENT_SET_NONE;
+	TILE_AREA_LOOP(tile, location) {
+		CatchmentSetID set = _catchment_index[tile];
+		if (set == CATCHMENT_SET_NONE || set == last) continue;
+		last = set;
+
+		const CatchmentStations &list = _catchment_sets[set].stations;
+		for (CatchmentStations::const_iterator it = list.begin(); it != list.end(); ++it) {
+			stations->Include(Station::Get(*it));
+		}
+	}
+	return true;
+}
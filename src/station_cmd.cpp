@@ -53,6 +53,9 @@
 #include "linkgraph/linkgraph_base.h"
 #include "linkgraph/refresh.h"
 #include "widgets/station_widget.h"
+#include "spatial_index.h"
+#include "tick_profiler.h"
+#include "core/sort_func.hpp"
 
 #include "table/strings.h"
 
@@ -334,6 +337,20 @@ static StringID GenerateStationName(Station *st, TileIndex tile, StationNaming n
 }
 #undef M
 
+/** Distance to the deleted stations of the current company, for finding the closest one. */
+struct DeletedStationDistance {
+	TileIndex tile; ///< The tile to search from.
+
+	DeletedStationDistance(TileIndex tile) : tile(tile) {}
+
+	inline uint operator()(StationID id, TileIndex xy) const
+	{
+		const Station *st = Station::Get(id);
+		if (st->IsInUse() || st->owner != _current_company) return UINT_MAX;
+		return DistanceManhattan(this->tile, xy);
+	}
+};
+
 /**
  * Find the closest deleted station of the current company
  * @param tile the tile to search from.
@@ -341,22 +358,9 @@ static StringID GenerateStationName(Station *st, TileIndex tile, StationNaming n
  */
 static Station *GetClosestDeletedStation(TileIndex tile)
 {
-	uint threshold = 8;
-	Station *best_station = NULL;
-	Station *st;
-
-	FOR_ALL_STATIONS(st) {
-		if (!st->IsInUse() && st->owner == _current_company) {
-			uint cur_dist = DistanceManhattan(tile, st->xy);
-
-			if (cur_dist < threshold) {
-				threshold = cur_dist;
-				best_station = st;
-			}
-		}
-	}
-
-	return best_station;
+	StationID st;
+	if (!GetStationSpatialIndex().FindNearest(tile, 8, DeletedStationDistance(tile), 0, &st)) return NULL;
+	return Station::Get(st);
 }
 
 
@@ -632,6 +636,7 @@ static void UpdateStationSignCoord(BaseStation *st)
 
 	/* clamp sign coord to be inside the station rect */
 	st->xy = TileXY(ClampU(TileX(st->xy), r->left, r->right), ClampU(TileY(st->xy), r->top, r->bottom));
+	if (Station::IsExpected(st)) UpdateSpatialIndex(Station::From(st));
 	st->UpdateVirtCoord();
 }
 
@@ -1353,7 +1358,7 @@ CommandCost CmdBuildRailStation(TileIndex tile_org, DoCommandFlag flags, uint32
 		st->MarkTilesDirty(false);
 		st->UpdateVirtCoord();
 		UpdateStationAcceptance(st, false);
-		st->RecomputeIndustriesNear();
+		st->RecomputeCatchment();
 		InvalidateWindowData(WC_SELECT_STATION, 0, 0);
 		InvalidateWindowData(WC_STATION_LIST, st->owner, 0);
 		SetWindowWidgetDirty(WC_STATION_VIEW, st->index, WID_SV_TRAINS);
@@ -1564,7 +1569,7 @@ CommandCost CmdRemoveFromRailStation(TileIndex start, DoCommandFlag flags, uint3
 
 		if (st->train_station.tile == INVALID_TILE) SetWindowWidgetDirty(WC_STATION_VIEW, st->index, WID_SV_TRAINS);
 		st->MarkTilesDirty(false);
-		st->RecomputeIndustriesNear();
+		st->RecomputeCatchment();
 	}
 
 	/* Now apply the rail cost to the number that we deleted */
@@ -1681,7 +1686,7 @@ static CommandCost RemoveRailStation(TileIndex tile, DoCommandFlag flags)
 	Station *st = Station::GetByTile(tile);
 	CommandCost cost = RemoveRailStation(st, flags);
 
-	if (flags & DC_EXEC) st->RecomputeIndustriesNear();
+	if (flags & DC_EXEC) st->RecomputeCatchment();
 
 	return cost;
 }
@@ -1867,7 +1872,7 @@ CommandCost CmdBuildRoadStop(TileIndex tile, DoCommandFlag flags, uint32 p1, uin
 	if (st != NULL) {
 		st->UpdateVirtCoord();
 		UpdateStationAcceptance(st, false);
-		st->RecomputeIndustriesNear();
+		st->RecomputeCatchment();
 		InvalidateWindowData(WC_SELECT_STATION, 0, 0);
 		InvalidateWindowData(WC_STATION_LIST, st->owner, 0);
 		SetWindowWidgetDirty(WC_STATION_VIEW, st->index, WID_SV_ROADVEHS);
@@ -1979,7 +1984,7 @@ static CommandCost RemoveRoadStop(TileIndex tile, DoCommandFlag flags)
 		st->rect.AfterRemoveTile(st, tile);
 
 		st->UpdateVirtCoord();
-		st->RecomputeIndustriesNear();
+		st->RecomputeCatchment();
 		DeleteStationIfEmpty(st);
 
 		/* Update the tile area of the truck/bus stop */
@@ -2108,6 +2113,21 @@ uint8 GetAirportNoiseLevelForTown(const AirportSpec *as, TileIterator &it, TileI
 	return noise_reduction >= as->noise_level ? 1 : as->noise_level - noise_reduction;
 }
 
+/** Distance from the tiles of an airport to a town, for finding the nearest town. */
+struct AirportTownDistance {
+	const TileIterator &it; ///< Iterator over the airport tiles.
+
+	AirportTownDistance(const TileIterator &it) : it(it) {}
+
+	inline uint operator()(TownID id, TileIndex xy) const
+	{
+		TileIterator *copy = this->it.Clone();
+		uint dist = GetMinimalAirportDistanceToTile(*copy, xy);
+		delete copy;
+		return dist;
+	}
+};
+
 /**
  * Finds the town nearest to given airport. Based on minimal manhattan distance to any airport's tile.
  * If two towns have the same distance, town with lower index is returned.
@@ -2117,22 +2137,10 @@ uint8 GetAirportNoiseLevelForTown(const AirportSpec *as, TileIterator &it, TileI
  */
 Town *AirportGetNearestTown(const AirportSpec *as, const TileIterator &it)
 {
-	Town *t, *nearest = NULL;
 	uint add = as->size_x + as->size_y - 2; // GetMinimalAirportDistanceToTile can differ from DistanceManhattan by this much
-	uint mindist = UINT_MAX - add; // prevent overflow
-	FOR_ALL_TOWNS(t) {
-		if (DistanceManhattan(t->xy, it) < mindist + add) { // avoid calling GetMinimalAirportDistanceToTile too often
-			TileIterator *copy = it.Clone();
-			uint dist = GetMinimalAirportDistanceToTile(*copy, t->xy);
-			delete copy;
-			if (dist < mindist) {
-				nearest = t;
-				mindist = dist;
-			}
-		}
-	}
-
-	return nearest;
+	TownID t;
+	if (!GetTownSpatialIndex().FindNearest(it, UINT_MAX, AirportTownDistance(it), add, &t)) return NULL;
+	return Town::Get(t);
 }
 
 
@@ -2283,7 +2291,7 @@ CommandCost CmdBuildAirport(TileIndex tile, DoCommandFlag flags, uint32 p1, uint
 
 		st->UpdateVirtCoord();
 		UpdateStationAcceptance(st, false);
-		st->RecomputeIndustriesNear();
+		st->RecomputeCatchment();
 		InvalidateWindowData(WC_SELECT_STATION, 0, 0);
 		InvalidateWindowData(WC_STATION_LIST, st->owner, 0);
 		InvalidateWindowData(WC_STATION_VIEW, st->index, -1);
@@ -2372,7 +2380,7 @@ static CommandCost RemoveAirport(TileIndex tile, DoCommandFlag flags)
 		DirtyCompanyInfrastructureWindows(st->owner);
 
 		st->UpdateVirtCoord();
-		st->RecomputeIndustriesNear();
+		st->RecomputeCatchment();
 		DeleteStationIfEmpty(st);
 		DeleteNewGRFInspectWindow(GSF_AIRPORTS, st->index);
 	}
@@ -2523,7 +2531,7 @@ CommandCost CmdBuildDock(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 
 		st->UpdateVirtCoord();
 		UpdateStationAcceptance(st, false);
-		st->RecomputeIndustriesNear();
+		st->RecomputeCatchment();
 		InvalidateWindowData(WC_SELECT_STATION, 0, 0);
 		InvalidateWindowData(WC_STATION_LIST, st->owner, 0);
 		SetWindowWidgetDirty(WC_STATION_VIEW, st->index, WID_SV_SHIPS);
@@ -2569,7 +2577,7 @@ static CommandCost RemoveDock(TileIndex tile, DoCommandFlag flags)
 
 		SetWindowWidgetDirty(WC_STATION_VIEW, st->index, WID_SV_SHIPS);
 		st->UpdateVirtCoord();
-		st->RecomputeIndustriesNear();
+		st->RecomputeCatchment();
 		DeleteStationIfEmpty(st);
 
 		/* All ships that were going to our station, can't go to it anymore.
@@ -3216,6 +3224,52 @@ static inline void byte_inc_sat(byte *p)
 	if (b != 0) *p = b;
 }
 
+/** Counters of the work done to update station ratings, for profiling. */
+struct StationRatingStats {
+	uint stations;     ///< Number of stations rated.
+	uint cargos;       ///< Number of cargo ratings computed.
+	uint callbacks;    ///< Number of rating callbacks of NewGRFs run.
+	uint truncations;  ///< Number of times waiting cargo has been truncated.
+	uint max_per_tick; ///< Highest number of stations rated in a single tick.
+	uint64 cycles;     ///< Time spent rating, in CPU cycles.
+};
+
+/** Counters of the current rating cycle of #STATION_RATING_TICKS ticks. */
+static StationRatingStats _station_rating_stats;
+
+/**
+ * Get the rating of a cargo at a station from the speed of the last vehicle
+ * that loaded it, the time since it was picked up and the amount of waiting
+ * cargo, i.e. the rating when no NewGRF computes it.
+ * @param ge The cargo at the station.
+ * @param last_vehicle_type The type of the vehicle that last loaded at the station.
+ * @return The (unclamped) rating.
+ */
+static int GetDefaultCargoRating(const GoodsEntry *ge, VehicleType last_vehicle_type)
+{
+	int rating = 0;
+
+	int b = ge->last_speed - 85;
+	if (b >= 0) rating += b >> 2;
+
+	byte waittime = ge->time_since_pickup;
+	if (last_vehicle_type == VEH_SHIP) waittime >>= 2;
+	(waittime > 21) ||
+	(rating += 25, waittime > 12) ||
+	(rating += 25, waittime > 6) ||
+	(rating += 45, waittime > 3) ||
+	(rating += 35, true);
+
+	(rating -= 90, ge->max_waiting_cargo > 1500) ||
+	(rating += 55, ge->max_waiting_cargo > 1000) ||
+	(rating += 35, ge->max_waiting_cargo > 600) ||
+	(rating += 10, ge->max_waiting_cargo > 300) ||
+	(rating += 20, ge->max_waiting_cargo > 100) ||
+	(rating += 10, true);
+
+	return rating;
+}
+
 static void UpdateStationRating(Station *st)
 {
 	bool waiting_changed = false;
@@ -3223,6 +3277,14 @@ static void UpdateStationRating(Station *st)
 	byte_inc_sat(&st->time_since_load);
 	byte_inc_sat(&st->time_since_unload);
 
+	_station_rating_stats.stations++;
+
+	/* These are the same for all cargoes of the station. */
+	int statue_bonus = (Company::IsValidID(st->owner) && HasBit(st->town->statues, st->owner)) ? 26 : 0;
+	VehicleType last_vehicle_type = (VehicleType)st->last_vehicle_type;
+	/* Convert to the 'old' vehicle types */
+	uint32 var10 = (last_vehicle_type == VEH_INVALID) ? 0x0 : (last_vehicle_type + 0x10);
+
 	const CargoSpec *cs;
 	FOR_ALL_CARGOSPECS(cs) {
 		GoodsEntry *ge = &st->goods[cs->Index()];
@@ -3235,6 +3297,7 @@ static void UpdateStationRating(Station *st)
 
 		/* Only change the rating if we are moving this cargo */
 		if (ge->HasRating()) {
+			_station_rating_stats.cargos++;
 			byte_inc_sat(&ge->time_since_pickup);
 
 			bool skip = false;
@@ -3262,8 +3325,7 @@ static void UpdateStationRating(Station *st)
 				uint last_speed = ge->HasVehicleEverTriedLoading() ? ge->last_speed : 0xFF;
 
 				uint32 var18 = min(ge->time_since_pickup, 0xFF) | (min(ge->max_waiting_cargo, 0xFFFF) << 8) | (min(last_speed, 0xFF) << 24);
-				/* Convert to the 'old' vehicle types */
-				uint32 var10 = (st->last_vehicle_type == VEH_INVALID) ? 0x0 : (st->last_vehicle_type + 0x10);
+				_station_rating_stats.callbacks++;
 				uint16 callback = GetCargoCallback(CBID_CARGO_STATION_RATING_CALC, var10, var18, cs);
 				if (callback != CALLBACK_FAILED) {
 					skip = true;
@@ -3274,27 +3336,9 @@ static void UpdateStationRating(Station *st)
 				}
 			}
 
-			if (!skip) {
-				int b = ge->last_speed - 85;
-				if (b >= 0) rating += b >> 2;
-
-				byte waittime = ge->time_since_pickup;
-				if (st->last_vehicle_type == VEH_SHIP) waittime >>= 2;
-				(waittime > 21) ||
-				(rating += 25, waittime > 12) ||
-				(rating += 25, waittime > 6) ||
-				(rating += 45, waittime > 3) ||
-				(rating += 35, true);
-
-				(rating -= 90, ge->max_waiting_cargo > 1500) ||
-				(rating += 55, ge->max_waiting_cargo > 1000) ||
-				(rating += 35, ge->max_waiting_cargo > 600) ||
-				(rating += 10, ge->max_waiting_cargo > 300) ||
-				(rating += 20, ge->max_waiting_cargo > 100) ||
-				(rating += 10, true);
-			}
+			if (!skip) rating = GetDefaultCargoRating(ge, last_vehicle_type);
 
-			if (Company::IsValidID(st->owner) && HasBit(st->town->statues, st->owner)) rating += 26;
+			rating += statue_bonus;
 
 			byte age = ge->last_age;
 			(age >= 3) ||
@@ -3348,6 +3392,7 @@ static void UpdateStationRating(Station *st)
 					/* Feed back the exact own waiting cargo at this station for the
 					 * next rating calculation. */
 					ge->max_waiting_cargo = 0;
+					_station_rating_stats.truncations++;
 
 					/* If truncating also punish the source stations' ratings to
 					 * decrease the flow of incoming cargo. */
@@ -3556,17 +3601,39 @@ static void StationHandleSmallTick(BaseStation *st)
 {
 	if ((st->facilities & FACIL_WAYPOINT) != 0 || !st->IsInUse()) return;
 
-	byte b = st->delete_ctr + 1;
-	if (b >= STATION_RATING_TICKS) b = 0;
-	st->delete_ctr = b;
+	/* Take turns based on the index, so every tick about the same number of stations is rated. */
+	if ((_tick_counter + st->index) % STATION_RATING_TICKS != 0) return;
+
+	uint64 start = ottd_rdtsc();
+	UpdateStationRating(Station::From(st));
+	_station_rating_stats.cycles += ottd_rdtsc() - start;
+}
+
+/**
+ * Account for the ratings updated during a tick and report the statistics
+ * of a rating cycle once it is complete.
+ * @param stations Number of stations rated before this tick.
+ */
+static void UpdateStationRatingStats(uint stations)
+{
+	StationRatingStats &stats = _station_rating_stats;
+	stats.max_per_tick = max(stats.max_per_tick, stats.stations - stations);
+
+	if (_tick_counter % STATION_RATING_TICKS != 0) return;
 
-	if (b == 0) UpdateStationRating(Station::From(st));
+	DEBUG(misc, 4, "Station ratings: %u stations, %u cargoes, %u callbacks, %u truncations; at most %u stations per tick; " OTTD_PRINTF64 " cycles",
+			stats.stations, stats.cargos, stats.callbacks, stats.truncations, stats.max_per_tick, stats.cycles);
+	MemSetT(&stats, 0);
 }
 
 void OnTick_Station()
 {
+	TickPhaseTimer timer(TPH_STATIONS);
+
 	if (_game_mode == GM_EDITOR) return;
 
+	uint rated = _station_rating_stats.stations;
+
 	BaseStation *st;
 	FOR_ALL_BASE_STATIONS(st) {
 		StationHandleSmallTick(st);
@@ -3586,6 +3653,8 @@ void OnTick_Station()
 			if (Station::IsExpected(st)) AirportAnimationTrigger(Station::From(st), AAT_STATION_250_TICKS);
 		}
 	}
+
+	UpdateStationRatingStats(rated);
 }
 
 /** Monthly loop for stations. */
@@ -3605,9 +3674,10 @@ void StationMonthlyLoop()
 
 void ModifyStationRatingAround(TileIndex tile, Owner owner, int amount, uint radius)
 {
-	Station *st;
-
-	FOR_ALL_STATIONS(st) {
+	std::vector<StationID> stations;
+	GetStationSpatialIndex().FindInSquare(tile, radius, &stations);
+	for (std::vector<StationID>::const_iterator it = stations.begin(); it != stations.end(); ++it) {
+		Station *st = Station::Get(*it);
 		if (st->owner == owner &&
 				DistanceManhattan(tile, st->xy) <= radius) {
 			for (CargoID i = 0; i < NUM_CARGO; i++) {
@@ -3713,12 +3783,11 @@ CommandCost CmdRenameStation(TileIndex tile, DoCommandFlag flags, uint32 p1, uin
 }
 
 /**
- * Find all stations around a rectangular producer (industry, house, headquarter, ...)
- *
+ * Find all stations around a rectangular producer by scanning the tiles around it.
  * @param location The location/area of the producer
  * @param stations The list to store the stations in
  */
-void FindStationsAroundTiles(const TileArea &location, StationList *stations)
+static void ScanForStationsAroundTiles(const TileArea &location, StationList *stations)
 {
 	/* area to search = producer plus station catchment radius */
 	uint max_rad = (_settings_game.station.modified_catchment ? MAX_CATCHMENT : CA_UNMODIFIED);
@@ -3762,6 +3831,27 @@ void FindStationsAroundTiles(const TileArea &location, StationList *stations)
 	}
 }
 
+/** Sort stations by their index. */
+static int CDECL StationIndexSorter(Station * const *a, Station * const *b)
+{
+	return (*a)->index - (*b)->index;
+}
+
+/**
+ * Find all stations around a rectangular producer (industry, house, headquarter, ...)
+ * The stations are sorted by index, so the result does not depend on whether
+ * the catchment index could be used, nor on how it is laid out.
+ *
+ * @param location The location/area of the producer
+ * @param stations The list to store the stations in
+ */
+void FindStationsAroundTiles(const TileArea &location, StationList *stations)
+{
+	if (!FindStationsInCatchmentIndex(location, stations)) ScanForStationsAroundTiles(location, stations);
+
+	QSortT(stations->Begin(), stations->Length(), &StationIndexSorter);
+}
+
 /**
  * Run a tile loop to find stations around a tile, on demand. Cache the result for further requests
  * @return pointer to a StationList containing all stations found
@@ -3868,7 +3958,7 @@ void BuildOilRig(TileIndex tile)
 
 	st->UpdateVirtCoord();
 	UpdateStationAcceptance(st, false);
-	st->RecomputeIndustriesNear();
+	st->RecomputeCatchment();
 }
 
 void DeleteOilRig(TileIndex tile)
@@ -3885,7 +3975,7 @@ void DeleteOilRig(TileIndex tile)
 	st->rect.AfterRemoveTile(st, tile);
 
 	st->UpdateVirtCoord();
-	st->RecomputeIndustriesNear();
+	st->RecomputeCatchment();
 	if (!st->IsInUse()) delete st;
 }
 
@@ -3950,6 +4040,8 @@ static void ChangeTileOwner_Station(TileIndex tile, Owner old_owner, Owner new_o
 
 		/* for buoys, owner of tile is owner of water, st->owner == OWNER_NONE */
 		SetTileOwner(tile, new_owner);
+		/* Segments end where the owner of the track changes. */
+		if (HasStationRail(tile)) YapfNotifyTrackLayoutChange(tile, GetRailStationTrack(tile));
 		InvalidateWindowClassesData(WC_STATION_LIST, 0);
 	} else {
 		if (IsDriveThroughStopTile(tile)) {
@@ -23,6 +23,10 @@ void ModifyStationRatingAround(TileIndex tile, Owner owner, int amount, uint rad
 
 void FindStationsAroundTiles(const TileArea &location, StationList *stations);
 
+void InitializeStationCatchmentIndex();
+void UpdateStationCatchmentIndex(Station *st, bool remove = false);
+bool FindStationsInCatchmentIndex(const TileArea &location, StationList *stations);
+
 void ShowStationViewWindow(StationID station);
 void UpdateAllStationVirtCoords();
 
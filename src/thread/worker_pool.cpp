@@ -0,0 +1,218 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file worker_pool.cpp Implementation of the pool of worker threads. */
+
+#include "../stdafx.h"
+#include "../core/math_func.hpp"
+#include "worker_pool.h"
+
+WorkerPool::WorkerPool() : mutex(ThreadMutex::New()), exit(false)
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+	this->SetWorkerCount(0);
+	delete this->mutex;
+}
+
+/**
+ * Change the number of worker threads. Must not be called while
+ * a batch is active.
+ * @param count The new number of workers.
+ */
+void WorkerPool::SetWorkerCount(uint count)
+{
+	if (count == this->threads.Length()) return;
+
+	/* Stop all current workers; it's simpler to start afresh. */
+	this->mutex->BeginCritical();
+	this->exit = true;
+	this->mutex->SendSignal();
+	this->mutex->EndCritical();
+
+	for (ThreadObject **t = this->threads.Begin(); t != this->threads.End(); t++) {
+		(*t)->Join();
+		delete *t;
+	}
+	this->threads.Clear();
+	this->exit = false;
+
+	for (uint i = 0; i < count; i++) {
+		ThreadObject *t;
+		if (!ThreadObject::New(&WorkerPool::WorkerThread, this, &t)) break;
+		*this->threads.Append() = t;
+	}
+}
+
+/**
+ * Claim a chunk of items of a batch.
+ * @pre The pool's mutex is held.
+ * @param batch The batch to claim from.
+ * @param[out] first First claimed item.
+ * @param[out] last One past the last claimed item.
+ * @return False if there was nothing left to claim.
+ */
+bool WorkerPool::ClaimChunk(WorkerBatch *batch, uint *first, uint *last)
+{
+	*first = batch->next;
+	*last = min(*first + batch->chunk, batch->count);
+	if (*first >= *last) return false;
+
+	batch->next = *last;
+	/* Everything has been claimed; nobody needs to look at it anymore. */
+	if (*last == batch->count) this->queue.Erase(this->queue.Find(batch));
+	return true;
+}
+
+/**
+ * Process a claimed chunk of items and notify the owner of the batch when
+ * it was the last one. The batch must not be touched afterwards, as the
+ * owner may have returned already.
+ * @param batch The batch the chunk belongs to.
+ * @param first First item of the chunk.
+ * @param last One past the last item of the chunk.
+ */
+/* static */ void WorkerPool::RunChunk(WorkerBatch *batch, uint first, uint last)
+{
+	for (uint i = first; i < last; i++) batch->proc(batch->data, i);
+
+	batch->finished->BeginCritical();
+	batch->done += last - first;
+	if (batch->done == batch->count) batch->finished->SendSignal();
+	batch->finished->EndCritical();
+}
+
+/**
+ * Main loop of a worker thread.
+ * @param pool The pool the worker belongs to.
+ */
+/* static */ void WorkerPool::WorkerThread(void *pool)
+{
+	WorkerPool *self = (WorkerPool *)pool;
+
+	self->mutex->BeginCritical();
+	for (;;) {
+		if (self->exit) {
+			/* Pass the signal on to the next worker. */
+			self->mutex->SendSignal();
+			break;
+		}
+		if (self->queue.Length() == 0) {
+			self->mutex->WaitForSignal();
+			continue;
+		}
+
+		WorkerBatch *batch = self->queue[0];
+		uint first, last;
+		self->ClaimChunk(batch, &first, &last);
+		/* Wake another worker, so signals sent for multiple workers are never lost. */
+		self->mutex->SendSignal();
+		self->mutex->EndCritical();
+
+		RunChunk(batch, first, last);
+
+		self->mutex->BeginCritical();
+	}
+	self->mutex->EndCritical();
+}
+
+/**
+ * Hand a batch to the workers. \a proc is called for every index in
+ * [0, \a count), in any order and from any thread, so the calls must not
+ * depend on each other. Wait must be called for the batch afterwards.
+ * @param batch The batch to start.
+ * @param proc  The procedure to call.
+ * @param data  Data to pass to the procedure.
+ * @param count The number of items.
+ */
+void WorkerPool::Start(WorkerBatch *batch, WorkerItemProc proc, void *data, uint count)
+{
+	assert(!batch->IsActive());
+
+	batch->proc = proc;
+	batch->data = data;
+	batch->count = count;
+	batch->chunk = max<uint>(1, count / ((this->threads.Length() + 1) * 4));
+	batch->next = 0;
+	batch->done = 0;
+	batch->finished = ThreadMutex::New();
+
+	if (count == 0) return;
+
+	this->mutex->BeginCritical();
+	*this->queue.Append() = batch;
+	this->mutex->SendSignal();
+	this->mutex->EndCritical();
+}
+
+/**
+ * Wait until all items of a batch have been processed. Items that no
+ * worker has claimed yet are processed by the calling thread.
+ * @param batch The batch to wait for.
+ */
+void WorkerPool::Wait(WorkerBatch *batch)
+{
+	assert(batch->IsActive());
+
+	/* Help with the batch, then wait for the chunks others claimed. */
+	for (;;) {
+		uint first, last;
+		this->mutex->BeginCritical();
+		bool claimed = this->ClaimChunk(batch, &first, &last);
+		this->mutex->EndCritical();
+		if (!claimed) break;
+
+		RunChunk(batch, first, last);
+	}
+
+	batch->finished->BeginCritical();
+	while (batch->done != batch->count) batch->finished->WaitForSignal();
+	batch->finished->EndCritical();
+
+	delete batch->finished;
+	batch->finished = NULL;
+}
+
+/**
+ * Call \a proc for every index in [0, \a count) and wait until all calls
+ * have finished. The calls may be made in any order and from any thread,
+ * so they must not depend on each other.
+ * @param proc  The procedure to call.
+ * @param data  Data to pass to the procedure.
+ * @param count The number of items.
+ */
+void WorkerPool::ParallelFor(WorkerItemProc proc, void *data, uint count)
+{
+	if (this->threads.Length() == 0 || count <= 1) {
+		for (uint i = 0; i < count; i++) proc(data, i);
+		return;
+	}
+
+	WorkerBatch batch;
+	this->Start(&batch, proc, data, count);
+	this->Wait(&batch);
+}
+
+/**
+ * Get the pool that is shared by all short-lived, fork-join style work
+ * done during the game loop. It is created on first use with a worker for
+ * every core besides the one of the calling thread.
+ * @return The shared worker pool.
+ */
+WorkerPool *GetGameWorkerPool()
+{
+	static WorkerPool *pool = NULL;
+	if (pool == NULL) {
+		pool = new WorkerPool();
+		pool->SetWorkerCount(max<uint>(GetCPUCoreCount(), 1) - 1);
+	}
+	return pool;
+}
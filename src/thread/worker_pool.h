@@ -0,0 +1,90 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file worker_pool.h Pool of persistent worker threads for splitting work over multiple cores. */
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include "thread.h"
+#include "../core/smallvec_type.hpp"
+
+/**
+ * Procedure executed for a single item of a parallel batch.
+ * @param data  The data passed to WorkerPool::ParallelFor.
+ * @param index Index of the item to process.
+ */
+typedef void (*WorkerItemProc)(void *data, uint index);
+
+/**
+ * A batch of independent items handed to a WorkerPool. It must stay alive
+ * until WorkerPool::Wait has returned for it.
+ */
+struct WorkerBatch {
+	WorkerItemProc proc;   ///< Procedure to call for each item.
+	void *data;            ///< Data to pass to the procedure.
+	uint count;            ///< Total number of items.
+	uint chunk;            ///< Number of items claimed at once.
+	uint next;             ///< First unclaimed item; guarded by the pool's mutex.
+	uint done;             ///< Number of processed items; guarded by #finished.
+	ThreadMutex *finished; ///< Mutex to signal the owner with once all items are processed, or NULL when the batch is not started.
+
+	WorkerBatch() : finished(NULL) {}
+
+	/**
+	 * Check whether the batch has been started, but not waited for yet.
+	 * @return True if the batch is active.
+	 */
+	inline bool IsActive() const
+	{
+		return this->finished != NULL;
+	}
+};
+
+/**
+ * A pool of persistent worker threads. Work is handed to the pool as a batch
+ * of independent items; whoever waits for a batch helps processing it and
+ * only returns when every item of it has been processed. When no threads are
+ * available (or none were requested) all items are simply processed by the
+ * waiting thread, in order.
+ */
+class WorkerPool {
+private:
+	ThreadMutex *mutex;                  ///< Mutex guarding the queue and signalling the workers.
+	SmallVector<ThreadObject *, 8> threads; ///< The worker threads.
+	SmallVector<WorkerBatch *, 4> queue; ///< Batches that still have unclaimed items.
+	bool exit;                           ///< Whether the workers should terminate.
+
+	static void WorkerThread(void *pool);
+	bool ClaimChunk(WorkerBatch *batch, uint *first, uint *last);
+	static void RunChunk(WorkerBatch *batch, uint first, uint last);
+
+public:
+	WorkerPool();
+	~WorkerPool();
+
+	void SetWorkerCount(uint count);
+
+	/**
+	 * Get the number of worker threads, excluding the calling thread.
+	 * @return The number of workers.
+	 */
+	inline uint GetWorkerCount() const
+	{
+		return this->threads.Length();
+	}
+
+	void Start(WorkerBatch *batch, WorkerItemProc proc, void *data, uint count);
+	void Wait(WorkerBatch *batch);
+	void ParallelFor(WorkerItemProc proc, void *data, uint count);
+};
+
+WorkerPool *GetGameWorkerPool();
+
+#endif /* WORKER_POOL_H */
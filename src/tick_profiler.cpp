@@ -0,0 +1,258 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file tick_profiler.cpp Measuring the time spent in the phases of the game loop. */
+
+#include "stdafx.h"
+#include "tick_profiler.h"
+#include "core/mem_func.hpp"
+#include "string_func.h"
+#include "debug.h"
+
+#if defined(WIN32)
+#	include <windows.h>
+#else
+#	include <time.h>     /* clock_gettime */
+#	include <sys/time.h> /* gettimeofday */
+#endif
+
+/** Names of the phases, as shown in the console and in traces. */
+static const char * const _tick_phase_names[] = {
+	"gameloop",
+	"animation",
+	"date",
+	"tileloop",
+	"vehicles",
+	"landscape",
+	"towns",
+	"trees",
+	"stations",
+	"industries",
+	"companies",
+	"linkgraph",
+	"ai",
+	"gamescript",
+	"windows",
+};
+assert_compile(lengthof(_tick_phase_names) == TPH_END);
+
+/** The phase each phase is part of. */
+static const TickPhase _tick_phase_parents[] = {
+	INVALID_TICK_PHASE, // gameloop
+	TPH_GAMELOOP,       // animation
+	TPH_GAMELOOP,       // date
+	TPH_GAMELOOP,       // tileloop
+	TPH_GAMELOOP,       // vehicles
+	TPH_GAMELOOP,       // landscape
+	TPH_LANDSCAPE,      // towns
+	TPH_LANDSCAPE,      // trees
+	TPH_LANDSCAPE,      // stations
+	TPH_LANDSCAPE,      // industries
+	TPH_LANDSCAPE,      // companies
+	TPH_LANDSCAPE,      // linkgraph
+	TPH_GAMELOOP,       // ai
+	TPH_GAMELOOP,       // gamescript
+	TPH_GAMELOOP,       // windows
+};
+assert_compile(lengthof(_tick_phase_parents) == TPH_END);
+
+static TickProfile _tick_profile;                    ///< The measured timings.
+static uint64 _tick_phase_start[TPH_END];            ///< When each running phase was started.
+static uint64 _tick_company_start[MAX_COMPANIES];    ///< When the AI of each company was started.
+static bool _tick_running = false;                   ///< Whether a game loop is being measured.
+
+static FILE *_tick_trace_file = NULL; ///< File the trace is written to, or \c NULL when not tracing.
+static uint64 _tick_trace_start;      ///< Time the trace was started; trace times are relative to it.
+static uint _tick_trace_ticks;        ///< Number of ticks still to trace.
+static bool _tick_trace_first;        ///< Whether no event has been written to the trace yet.
+
+/**
+ * Get the time of a monotonic clock.
+ * @return The time in microseconds.
+ */
+uint64 GetProfilerTime()
+{
+#if defined(WIN32)
+	static LARGE_INTEGER frequency = { 0 };
+	if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return (uint64)(counter.QuadPart / frequency.QuadPart) * 1000000 + (uint64)(counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+	struct timespec tim;
+	clock_gettime(CLOCK_MONOTONIC, &tim);
+	return (uint64)tim.tv_sec * 1000000 + tim.tv_nsec / 1000;
+#else
+	/* No monotonic clock available; the wall clock might jump. */
+	struct timeval tim;
+	gettimeofday(&tim, NULL);
+	return (uint64)tim.tv_sec * 1000000 + tim.tv_usec;
+#endif
+}
+
+/**
+ * Get the measured timings.
+ * @return The timings.
+ */
+const TickProfile &GetTickProfile()
+{
+	return _tick_profile;
+}
+
+/**
+ * Get the name of a phase.
+ * @param phase The phase.
+ * @return The name.
+ */
+const char *GetTickPhaseName(TickPhase phase)
+{
+	assert(phase < TPH_END);
+	return _tick_phase_names[phase];
+}
+
+/**
+ * Get the phase a phase is part of.
+ * @param phase The phase.
+ * @return The parent phase, or #INVALID_TICK_PHASE for the game loop itself.
+ */
+TickPhase GetTickPhaseParent(TickPhase phase)
+{
+	assert(phase < TPH_END);
+	return _tick_phase_parents[phase];
+}
+
+/** Forget all measured timings. */
+void ResetTickProfile()
+{
+	MemSetT(&_tick_profile, 0);
+}
+
+/**
+ * Write a complete event to the trace.
+ * @param name  Name of the event.
+ * @param start Time the event started.
+ * @param duration Duration of the event.
+ */
+static void WriteTraceEvent(const char *name, uint64 start, uint64 duration)
+{
+	fprintf(_tick_trace_file, "%s{\"name\":\"%s\",\"cat\":\"tick\",\"ph\":\"X\",\"ts\":" OTTD_PRINTF64 ",\"dur\":" OTTD_PRINTF64 ",\"pid\":1,\"tid\":1}",
+			_tick_trace_first ? "[\n" : ",\n", name, start - _tick_trace_start, duration);
+	_tick_trace_first = false;
+}
+
+/**
+ * Add the time spent in the current tick to the totals.
+ * @param stats The statistics to update.
+ */
+static void FoldTickPhaseStats(TickPhaseStats *stats)
+{
+	stats->last = stats->current;
+	stats->total += stats->current;
+	stats->max = max(stats->max, stats->current);
+	stats->current = 0;
+}
+
+/**
+ * Start timing a phase. Phases other than the game loop itself are only timed
+ * while a game loop is being timed, so e.g. the tile loops run while
+ * generating a world do not show up as part of a tick.
+ * @param phase The phase.
+ */
+void TickProfilerBegin(TickPhase phase)
+{
+	if (phase == TPH_GAMELOOP) {
+		_tick_running = true;
+	} else if (!_tick_running) {
+		return;
+	}
+	_tick_phase_start[phase] = GetProfilerTime();
+}
+
+/**
+ * Stop timing a phase. Ending the game loop finishes the tick.
+ * @param phase The phase.
+ */
+void TickProfilerEnd(TickPhase phase)
+{
+	if (!_tick_running) return;
+
+	uint64 now = GetProfilerTime();
+	uint64 duration = now - _tick_phase_start[phase];
+	_tick_profile.phases[phase].current += duration;
+	if (_tick_trace_file != NULL) WriteTraceEvent(_tick_phase_names[phase], _tick_phase_start[phase], duration);
+
+	if (phase != TPH_GAMELOOP) return;
+
+	_tick_running = false;
+	_tick_profile.ticks++;
+	for (uint i = 0; i < TPH_END; i++) FoldTickPhaseStats(&_tick_profile.phases[i]);
+	for (uint i = 0; i < MAX_COMPANIES; i++) FoldTickPhaseStats(&_tick_profile.ai_companies[i]);
+
+	if (_tick_trace_file != NULL && --_tick_trace_ticks == 0) StopTickTrace();
+}
+
+/**
+ * Start timing the AI of a company.
+ * @param company The company.
+ */
+void TickProfilerBeginCompany(CompanyID company)
+{
+	if (!_tick_running) return;
+	_tick_company_start[company] = GetProfilerTime();
+}
+
+/**
+ * Stop timing the AI of a company.
+ * @param company The company.
+ */
+void TickProfilerEndCompany(CompanyID company)
+{
+	if (!_tick_running) return;
+
+	uint64 duration = GetProfilerTime() - _tick_company_start[company];
+	_tick_profile.ai_companies[company].current += duration;
+	if (_tick_trace_file != NULL) {
+		char name[32];
+		seprintf(name, lastof(name), "ai company %d", company + 1);
+		WriteTraceEvent(name, _tick_company_start[company], duration);
+	}
+}
+
+/**
+ * Start writing the timings of the next ticks to a file in the Trace Event
+ * Format, so they can be inspected with e.g. chrome://tracing.
+ * A trace that is still being written is stopped first.
+ * @param filename The file to write to.
+ * @param ticks    Number of ticks to trace.
+ * @return False if the file could not be opened.
+ */
+bool StartTickTrace(const char *filename, uint ticks)
+{
+	StopTickTrace();
+	if (ticks == 0) return true;
+
+	_tick_trace_file = fopen(filename, "w");
+	if (_tick_trace_file == NULL) return false;
+
+	_tick_trace_start = GetProfilerTime();
+	_tick_trace_ticks = ticks;
+	_tick_trace_first = true;
+	return true;
+}
+
+/** Stop writing the trace, if one is being written. */
+void StopTickTrace()
+{
+	if (_tick_trace_file == NULL) return;
+
+	fputs(_tick_trace_first ? "[]\n" : "\n]\n", _tick_trace_file);
+	fclose(_tick_trace_file);
+	_tick_trace_file = NULL;
+	DEBUG(misc, 1, "Finished writing the tick trace");
+}
@@ -0,0 +1,109 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file tick_profiler.h Measuring the time spent in the phases of the game loop. */
+
+#ifndef TICK_PROFILER_H
+#define TICK_PROFILER_H
+
+#include "core/enum_type.hpp"
+#include "company_type.h"
+
+/** Phases of the game loop that are timed. */
+enum TickPhase {
+	TPH_GAMELOOP,   ///< The whole game loop of a tick.
+	TPH_ANIMATION,  ///< Animating tiles.
+	TPH_DATE,       ///< Advancing the date, including the daily, monthly and yearly loops.
+	TPH_TILELOOP,   ///< The tile loop.
+	TPH_VEHICLES,   ///< Vehicle ticks.
+	TPH_LANDSCAPE,  ///< The ticks of the landscape, consisting of the following phases.
+	TPH_TOWNS,      ///< Town ticks.
+	TPH_TREES,      ///< Tree ticks.
+	TPH_STATIONS,   ///< Station ticks.
+	TPH_INDUSTRIES, ///< Industry ticks.
+	TPH_COMPANIES,  ///< Company ticks.
+	TPH_LINKGRAPH,  ///< Link graph ticks.
+	TPH_AI,         ///< Running the AIs; see the per company numbers for the AI of each company.
+	TPH_GAMESCRIPT, ///< Running the game script.
+	TPH_WINDOWS,    ///< Tick events of windows.
+	TPH_END,        ///< End marker.
+	INVALID_TICK_PHASE = 0xFF, ///< No phase.
+};
+DECLARE_POSTFIX_INCREMENT(TickPhase)
+
+/** Time spent in a phase, or by a company. All times are in microseconds. */
+struct TickPhaseStats {
+	uint64 total;   ///< Time spent since the statistics were reset.
+	uint64 max;     ///< Longest time spent in a single tick since the statistics were reset.
+	uint64 last;    ///< Time spent in the last tick.
+	uint64 current; ///< Time spent in the current tick so far.
+};
+
+/** Timings of the game loop. */
+struct TickProfile {
+	uint32 ticks;                                ///< Number of ticks measured since the statistics were reset.
+	TickPhaseStats phases[TPH_END];              ///< Time spent in each phase.
+	TickPhaseStats ai_companies[MAX_COMPANIES];  ///< Time spent running the AI of each company.
+};
+
+uint64 GetProfilerTime();
+const TickProfile &GetTickProfile();
+const char *GetTickPhaseName(TickPhase phase);
+TickPhase GetTickPhaseParent(TickPhase phase);
+void ResetTickProfile();
+
+void TickProfilerBegin(TickPhase phase);
+void TickProfilerEnd(TickPhase phase);
+void TickProfilerBeginCompany(CompanyID company);
+void TickProfilerEndCompany(CompanyID company);
+
+bool StartTickTrace(const char *filename, uint ticks);
+void StopTickTrace();
+
+/** Time a phase of the game loop for as long as the timer is in scope. */
+struct TickPhaseTimer {
+	TickPhase phase; ///< The phase being timed.
+
+	/**
+	 * Start timing a phase.
+	 * @param phase The phase.
+	 */
+	TickPhaseTimer(TickPhase phase) : phase(phase)
+	{
+		TickProfilerBegin(phase);
+	}
+
+	/** Stop timing the phase. */
+	~TickPhaseTimer()
+	{
+		TickProfilerEnd(this->phase);
+	}
+};
+
+/** Time the AI of a company for as long as the timer is in scope. */
+struct TickCompanyTimer {
+	CompanyID company; ///< The company being timed.
+
+	/**
+	 * Start timing a company.
+	 * @param company The company.
+	 */
+	TickCompanyTimer(CompanyID company) : company(company)
+	{
+		TickProfilerBeginCompany(company);
+	}
+
+	/** Stop timing the company. */
+	~TickCompanyTimer()
+	{
+		TickProfilerEndCompany(this->company);
+	}
+};
+
+#endif /* TICK_PROFILER_H */
@@ -46,6 +46,8 @@
 #include "object_base.h"
 #include "ai/ai.hpp"
 #include "game/game.hpp"
+#include "spatial_index.h"
+#include "tick_profiler.h"
 
 #include "table/strings.h"
 #include "table/town_land.h"
@@ -102,6 +104,7 @@ Town::~Town()
 	DeleteSubsidyWith(ST_TOWN, this->index);
 	DeleteNewGRFInspectWindow(GSF_FAKE_TOWNS, this->index);
 	CargoPacket::InvalidateAllFrom(ST_TOWN, this->index);
+	UpdateSpatialIndex(this, true);
 	MarkWholeScreenDirty();
 }
 
@@ -339,12 +342,8 @@ static void AnimateTile_Town(TileIndex tile)
  */
 static bool IsCloseToTown(TileIndex tile, uint dist)
 {
-	const Town *t;
-
-	FOR_ALL_TOWNS(t) {
-		if (DistanceManhattan(tile, t->xy) < dist) return true;
-	}
-	return false;
+	TownID t;
+	return GetTownSpatialIndex().FindNearest(tile, dist, SpatialManhattanDistance(tile), 0, &t);
 }
 
 /**
@@ -773,6 +772,8 @@ static void TownTickHandler(Town *t)
 
 void OnTick_Town()
 {
+	TickPhaseTimer timer(TPH_TOWNS);
+
 	if (_game_mode == GM_EDITOR) return;
 
 	Town *t;
@@ -1489,6 +1490,7 @@ void UpdateTownMaxPass(Town *t)
 static void DoCreateTown(Town *t, TileIndex tile, uint32 townnameparts, TownSize size, bool city, TownLayout layout, bool manual)
 {
 	t->xy = tile;
+	UpdateSpatialIndex(t);
 	t->cache.num_houses = 0;
 	t->time_until_rebuild = 10;
 	UpdateTownRadius(t);
@@ -2999,8 +3001,10 @@ static void UpdateTownRating(Town *t)
 		}
 	}
 
-	const Station *st;
-	FOR_ALL_STATIONS(st) {
+	std::vector<StationID> stations;
+	GetStationSpatialIndex().FindInSquare(t->xy, IntSqrt(t->cache.squared_town_zone_radius[0]), &stations);
+	for (std::vector<StationID>::const_iterator it = stations.begin(); it != stations.end(); ++it) {
+		const Station *st = Station::Get(*it);
 		if (DistanceSquare(st->xy, t->xy) <= t->cache.squared_town_zone_radius[0]) {
 			if (st->time_since_load <= 20 || st->time_since_unload <= 20) {
 				if (Company::IsValidID(st->owner)) {
@@ -3065,8 +3069,10 @@ static void UpdateTownGrowRate(Town *t)
 
 	int n = 0;
 
-	const Station *st;
-	FOR_ALL_STATIONS(st) {
+	std::vector<StationID> stations;
+	GetStationSpatialIndex().FindInSquare(t->xy, IntSqrt(t->cache.squared_town_zone_radius[0]), &stations);
+	for (std::vector<StationID>::const_iterator it = stations.begin(); it != stations.end(); ++it) {
+		const Station *st = Station::Get(*it);
 		if (DistanceSquare(st->xy, t->xy) <= t->cache.squared_town_zone_radius[0]) {
 			if (st->time_since_load <= 20 || st->time_since_unload <= 20) {
 				n++;
@@ -3146,19 +3152,9 @@ CommandCost CheckIfAuthorityAllowsNewStation(TileIndex tile, DoCommandFlag flags
  */
 Town *CalcClosestTownFromTile(TileIndex tile, uint threshold)
 {
-	Town *t;
-	uint best = threshold;
-	Town *best_town = NULL;
-
-	FOR_ALL_TOWNS(t) {
-		uint dist = DistanceManhattan(tile, t->xy);
-		if (dist < best) {
-			best = dist;
-			best_town = t;
-		}
-	}
-
-	return best_town;
+	TownID t;
+	if (!GetTownSpatialIndex().FindNearest(tile, threshold, SpatialManhattanDistance(tile), 0, &t)) return NULL;
+	return Town::Get(t);
 }
 
 /**
@@ -24,6 +24,7 @@
 #include "company_base.h"
 #include "core/random_func.hpp"
 #include "newgrf_generic.h"
+#include "tick_profiler.h"
 
 #include "table/strings.h"
 #include "table/tree_land.h"
@@ -749,6 +750,8 @@ static void TileLoop_Trees(TileIndex tile)
 
 void OnTick_Trees()
 {
+	TickPhaseTimer timer(TPH_TREES);
+
 	/* Don't place trees if that's not allowed */
 	if (_settings_game.construction.extra_tree_placement == ETP_NONE) return;
 
@@ -52,6 +52,8 @@
 #include "gamelog.h"
 #include "linkgraph/linkgraph.h"
 #include "linkgraph/refresh.h"
+#include "thread/worker_pool.h"
+#include "tick_profiler.h"
 
 #include "table/strings.h"
 
@@ -60,6 +62,7 @@
 VehicleID _new_vehicle_id;
 uint16 _returned_refit_capacity;      ///< Stores the capacity after a refit operation.
 uint16 _returned_mail_refit_capacity; ///< Stores the mail capacity after a refit operation (Aircraft only).
+bool _threaded_vehicle_ticks = false; ///< Whether vehicle ticks hand independent work to worker threads.
 
 
 /** The pool with all our precious vehicles. */
@@ -621,9 +624,19 @@ void ResetVehicleColourMap()
 typedef SmallMap<Vehicle *, bool, 4> AutoreplaceMap;
 static AutoreplaceMap _vehicles_to_autoreplace;
 
+/**
+ * List of vehicles whose cargo ages this tick after the serial vehicle tick
+ * loop. IDs are stored as a vehicle can be deleted by another one's tick.
+ */
+static SmallVector<VehicleID, 16> _vehicles_to_age_cargo;
+/** With desync debugging, the cargo of #_vehicles_to_age_cargo as aged by the serial tick loop. */
+static std::vector<VehicleCargoList::AgeState> _vehicles_to_age_cargo_check;
+
 void InitializeVehicles()
 {
 	_vehicles_to_autoreplace.Reset();
+	_vehicles_to_age_cargo.Reset();
+	_vehicles_to_age_cargo_check.clear();
 	ResetVehicleHash();
 }
 
@@ -869,8 +882,125 @@ static void RunVehicleDayProc()
 	}
 }
 
+/** Minimal number of vehicles to age cargo of before handing the work to the worker pool. */
+static const uint MIN_PARALLEL_CARGO_AGING = 64;
+
+/**
+ * Check whether the cargo aging of a vehicle can be moved from its own slot
+ * in the vehicle tick loop to after the loop without anyone noticing.
+ * @param v The vehicle whose cargo ages.
+ * @return True if nothing can observe the cargo age until the end of the loop.
+ */
+static bool CanDeferCargoAging(const Vehicle *v)
+{
+	/* The front might still start loading in its own tick, which pays transfers by cargo age. */
+	const Vehicle *front = v->First();
+	if (front->index > v->index) return false;
+
+	/* NewGRF callbacks of the consist can read the cargo age of any of its parts. */
+	for (const Vehicle *u = front; u != NULL; u = u->Next()) {
+		if (u->GetGRF() != NULL) return false;
+	}
+	return true;
+}
+
+/**
+ * Age the cargo of a vehicle whose aging is deferred like the serial tick
+ * loop does, remember the result and undo the aging again. The deferred
+ * aging has to yield exactly the same result.
+ * @param v The vehicle whose cargo ages.
+ */
+static void AgeCargoForCheck(Vehicle *v)
+{
+	VehicleCargoList::AgeState before;
+	v->cargo.GetAgeState(&before);
+
+	v->cargo.AgeCargo();
+	_vehicles_to_age_cargo_check.push_back(VehicleCargoList::AgeState());
+	v->cargo.GetAgeState(&_vehicles_to_age_cargo_check.back());
+
+	v->cargo.SetAgeState(before);
+}
+
+/**
+ * Age the cargo of one of the vehicles of a deferred batch.
+ * @param data  The vehicles to age the cargo of.
+ * @param index Index of the vehicle in the batch.
+ */
+static void AgeCargoProc(void *data, uint index)
+{
+	((Vehicle **)data)[index]->cargo.AgeCargo();
+}
+
+/**
+ * Age the cargo of the vehicles that were queued during the vehicle tick
+ * loop. Each vehicle only touches its own cargo packets, so this is done
+ * on the worker pool; the outcome does not depend on the order.
+ * When desync debugging is enabled, the result is compared with the cargo
+ * as aged by the serial code in the vehicle's own slot in the loop.
+ */
+static void AgeDeferredCargo()
+{
+	/* The desync debug level may have been changed during the tick loop. */
+	bool check = _vehicles_to_age_cargo_check.size() == _vehicles_to_age_cargo.Length();
+
+	SmallVector<Vehicle *, 16> vehicles;
+	SmallVector<uint, 16> checks;
+	for (uint i = 0; i < _vehicles_to_age_cargo.Length(); i++) {
+		Vehicle *v = Vehicle::GetIfValid(_vehicles_to_age_cargo[i]);
+		if (v == NULL) continue;
+
+		*vehicles.Append() = v;
+		*checks.Append() = i;
+	}
+
+	if (vehicles.Length() < MIN_PARALLEL_CARGO_AGING) {
+		for (uint i = 0; i < vehicles.Length(); i++) AgeCargoProc(vehicles.Begin(), i);
+	} else {
+		GetGameWorkerPool()->ParallelFor(&AgeCargoProc, vehicles.Begin(), vehicles.Length());
+	}
+
+	if (_debug_desync_level > 1 && check) {
+		VehicleCargoList::AgeState threaded;
+		for (uint i = 0; i < vehicles.Length(); i++) {
+			vehicles[i]->cargo.GetAgeState(&threaded);
+			if (threaded == _vehicles_to_age_cargo_check[checks[i]]) continue;
+
+			DEBUG(desync, 2, "deferred cargo aging mismatch: vehicle %i differs from the serial vehicle ticks", (int)vehicles[i]->index);
+			/* Clients ticking their vehicles serially would desync. */
+			assert(threaded == _vehicles_to_age_cargo_check[checks[i]]);
+		}
+	}
+
+	_vehicles_to_age_cargo.Clear();
+	_vehicles_to_age_cargo_check.clear();
+}
+
+/**
+ * Tick all vehicles. When threaded vehicle ticks are enabled, the work is
+ * split in the serial tick loop over all vehicles in index order, which
+ * decides everything that can affect other vehicles, and a parallel phase
+ * afterwards for work that only touches the vehicle itself. Only work that
+ * provably cannot be observed before the end of the loop is moved to the
+ * parallel phase, so the outcome is identical to the serial one.
+ *
+ * That is only cargo aging. The rest of a vehicle's tick stays serial:
+ *  - Movement reserves paths, switches signals and level crossings, shares
+ *    the pathfinder caches and looks for other vehicles on its tiles, so it
+ *    depends on the vehicles that ticked before it.
+ *  - Breakdown checks draw from the game's random generator; the order of
+ *    the draws decides which vehicle breaks down.
+ *  - Sound and visual effect decisions run NewGRF callbacks, which use the
+ *    global temporary storage of the resolver, draw random numbers for
+ *    smoke and sparks and create effect vehicles, whose IDs depend on the
+ *    order they are created in.
+ *  - The cargo of consists with NewGRF parts ages serially too, as their
+ *    callbacks can read the cargo age of any part of the consist.
+ */
 void CallVehicleTicks()
 {
+	TickPhaseTimer timer(TPH_VEHICLES);
+
 	_vehicles_to_autoreplace.Clear();
 
 	RunVehicleDayProc();
@@ -900,7 +1030,12 @@ void CallVehicleTicks()
 				if (v->vcache.cached_cargo_age_period != 0) {
 					v->cargo_age_counter = min(v->cargo_age_counter, v->vcache.cached_cargo_age_period);
 					if (--v->cargo_age_counter == 0) {
-						v->cargo.AgeCargo();
+						if (_threaded_vehicle_ticks && CanDeferCargoAging(v)) {
+							*_vehicles_to_age_cargo.Append() = v->index;
+							if (_debug_desync_level > 1) AgeCargoForCheck(v);
+						} else {
+							v->cargo.AgeCargo();
+						}
 						v->cargo_age_counter = v->vcache.cached_cargo_age_period;
 					}
 				}
@@ -948,6 +1083,8 @@ void CallVehicleTicks()
 		}
 	}
 
+	AgeDeferredCargo();
+
 	Backup<CompanyByte> cur_company(_current_company, FILE_LINE);
 	for (AutoreplaceMap::iterator it = _vehicles_to_autoreplace.Begin(); it != _vehicles_to_autoreplace.End(); it++) {
 		v = it->first;
@@ -12,7 +12,15 @@
 #include "../stdafx.h"
 #include "../gfx_func.h"
 #include "../blitter/factory.hpp"
+#include "../openttd.h"
+#include "../progress.h"
+#include "../tick_profiler.h"
+#include "../core/math_func.hpp"
+#include "../core/random_func.hpp"
 #include "null_v.h"
+#include <vector>
+#include <algorithm>
+#include <math.h>
 
 /** Factory for the null video driver. */
 static FVideoDriver_Null iFVideoDriver_Null;
@@ -25,6 +33,12 @@ const char *VideoDriver_Null::Start(const char * const *parm)
 #endif
 
 	this->ticks = GetDriverParamInt(parm, "ticks", 1000);
+	this->benchmark = GetDriverParamBool(parm, "benchmark");
+	this->fix_seed = GetDriverParam(parm, "seed") != NULL;
+	this->seed = GetDriverParamInt(parm, "seed", 0);
+	const char *hash = GetDriverParam(parm, "hash");
+	this->check_hash = hash != NULL;
+	this->expected_hash = this->check_hash ? strtoul(hash, NULL, 16) : 0;
 	_screen.width  = _screen.pitch = _cur_resolution.width;
 	_screen.height = _cur_resolution.height;
 	_screen.dst_ptr = NULL;
@@ -40,8 +54,85 @@ void VideoDriver_Null::Stop() { }
 
 void VideoDriver_Null::MakeDirty(int left, int top, int width, int height) {}
 
+/**
+ * Start the game given on the command line and run the requested number of
+ * ticks of it as fast as possible. Afterwards print how long the ticks took,
+ * both as a whole and per phase of the game loop, and the hash of the
+ * resulting game state. When an expected hash has been given and the hash
+ * differs from it, the game is terminated with an error.
+ */
+void VideoDriver_Null::RunBenchmark()
+{
+	/* Run the game until the switch to the game given on the command line has been made. */
+	bool switched = false;
+	while (!_exit_game) {
+		if (_switch_mode != SM_NONE) switched = true;
+		GameLoop();
+		UpdateWindows();
+		if (switched && _switch_mode == SM_NONE && !HasModalProgress()) break;
+		if (HasModalProgress()) CSleep(1);
+	}
+	if (_game_mode != GM_NORMAL) usererror("Benchmark failed: no game has been started; pass a savegame with -g");
+
+	if (this->fix_seed) {
+		_random.SetSeed(this->seed);
+		_interactive_random.SetSeed(this->seed);
+	}
+
+	std::vector<uint32> times;
+	times.reserve(this->ticks);
+	ResetTickProfile();
+
+	uint64 start = GetProfilerTime();
+	for (uint i = 0; i < this->ticks && !_exit_game; i++) {
+		uint64 tick_start = GetProfilerTime();
+		GameLoop();
+		UpdateWindows();
+		times.push_back((uint32)(GetProfilerTime() - tick_start));
+	}
+	uint64 duration = GetProfilerTime() - start;
+
+	uint32 hash = CalculateGameStateHash();
+	if (times.empty()) usererror("Benchmark failed: no ticks have been run");
+
+	double mean = 0;
+	for (std::vector<uint32>::const_iterator it = times.begin(); it != times.end(); ++it) mean += *it;
+	mean /= times.size();
+	double variance = 0;
+	for (std::vector<uint32>::const_iterator it = times.begin(); it != times.end(); ++it) variance += (*it - mean) * (*it - mean);
+	variance /= times.size();
+	std::sort(times.begin(), times.end());
+
+	printf("Benchmark: %u ticks in %.3f s, %.1f ticks/s\n", (uint)times.size(), duration / 1e6, times.size() * 1e6 / max<uint64>(duration, 1));
+	printf("Tick time (us): mean %.1f, stddev %.1f, min %u, median %u, 95%% %u, max %u\n", mean, sqrt(variance),
+			times.front(), times[times.size() / 2], times[times.size() * 95 / 100], times.back());
+
+	const TickProfile &profile = GetTickProfile();
+	if (profile.ticks != 0) {
+		printf("Phase              Average       Max\n");
+		for (TickPhase phase = TPH_GAMELOOP; phase < TPH_END; phase++) {
+			uint depth = 0;
+			for (TickPhase parent = GetTickPhaseParent(phase); parent != INVALID_TICK_PHASE; parent = GetTickPhaseParent(parent)) depth++;
+			printf("%*s%-*s %9u %9u\n", depth * 2, "", 16 - depth * 2, GetTickPhaseName(phase),
+					(uint)(profile.phases[phase].total / profile.ticks), (uint)profile.phases[phase].max);
+		}
+	}
+
+	printf("State hash: %08X\n", hash);
+	fflush(stdout);
+
+	if (this->check_hash && hash != this->expected_hash) {
+		usererror("Benchmark failed: state hash %08X differs from the expected %08X", hash, this->expected_hash);
+	}
+}
+
 void VideoDriver_Null::MainLoop()
 {
+	if (this->benchmark) {
+		this->RunBenchmark();
+		return;
+	}
+
 	uint i;
 
 	for (i = 0; i < this->ticks; i++) {
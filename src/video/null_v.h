@@ -17,7 +17,14 @@
 /** The null video driver. */
 class VideoDriver_Null: public VideoDriver {
 private:
-	uint ticks; ///< Amount of ticks to run.
+	uint ticks;           ///< Amount of ticks to run.
+	bool benchmark;       ///< Whether to time the ticks of the game started from the command line.
+	bool fix_seed;        ///< Whether to reseed the random generators before the benchmark.
+	uint32 seed;          ///< Seed for the random generators.
+	bool check_hash;      ///< Whether to compare the game state after the benchmark with #expected_hash.
+	uint32 expected_hash; ///< Expected hash of the game state after the benchmark.
+
+	void RunBenchmark();
 
 public:
 	/* virtual */ const char *Start(const char * const *param);
@@ -46,6 +46,8 @@
 #include "tilehighlight_func.h"
 #include "window_gui.h"
 #include "linkgraph/linkgraph_gui.h"
+#include "newgrf_debug.h"
+#include "thread/worker_pool.h"
 
 #include "table/strings.h"
 #include "table/palettes.h"
@@ -67,6 +69,8 @@ struct TileSpriteToDraw {
 	const SubSprite *sub;           ///< only draw a rectangular part of the sprite
 	int32 x;                        ///< screen X coordinate of sprite
 	int32 y;                        ///< screen Y coordinate of sprite
+	const Sprite *sprite;           ///< the sprite of #image, when resolved for drawing in strips
+	const byte *remap;              ///< the colour remap of #pal, when resolved for drawing in strips
 };
 
 struct ChildScreenSpriteToDraw {
@@ -76,6 +80,8 @@ struct ChildScreenSpriteToDraw {
 	int32 x;
 	int32 y;
 	int next;                       ///< next child to draw (-1 at the end)
+	const Sprite *sprite;           ///< the sprite of #image, when resolved for drawing in strips
+	const byte *remap;              ///< the colour remap of #pal, when resolved for drawing in strips
 };
 
 /** Parent sprite that should be drawn */
@@ -99,6 +105,11 @@ struct ParentSpriteToDraw {
 
 	int first_child;                ///< the first child to draw.
 	bool comparison_done;           ///< Used during sprite sorting: true if sprite has been compared with all other sprites
+
+	const Sprite *sprite;           ///< the sprite of #image, when resolved for drawing in strips
+	const byte *remap;              ///< the colour remap of #pal, when resolved for drawing in strips
+	int32 extent_left;              ///< minimal screen X coordinate of the sprite and its children, when resolved for drawing in strips
+	int32 extent_right;             ///< maximal screen X coordinate (exclusive) of the sprite and its children, when resolved for drawing in strips
 };
 
 /** Enumeration of multi-part foundations */
@@ -134,6 +145,7 @@ struct ViewportDrawer {
 	ParentSpriteToDrawVector parent_sprites_to_draw;
 	ParentSpriteToSortVector parent_sprites_to_sort; ///< Parent sprite pointer array used for sorting
 	ChildScreenSpriteToDrawVector child_screen_sprites_to_draw;
+	SmallVector<SpriteID, 64> sprites_to_prefetch;   ///< Sprites that are not drawn via the sprite cache yet, collected for PrefetchSprites.
 
 	int *last_child;
 
@@ -145,9 +157,20 @@ struct ViewportDrawer {
 	Point foundation_offset[FOUNDATION_PART_END];    ///< Pixel offset for ground sprites on the foundations.
 };
 
+/** A vertical strip of a viewport that is drawn independently of the other strips. */
+struct ViewportStrip {
+	DrawPixelInfo dpi;                                        ///< Part of the screen the strip covers.
+	SmallVector<const TileSpriteToDraw *, 64> tile_sprites;   ///< The tile sprites overlapping the strip.
+	SmallVector<const ParentSpriteToDraw *, 64> parent_sprites; ///< The parent sprites overlapping the strip, in the order of the whole viewport.
+};
+
+static const int VIEWPORT_STRIP_MIN_WIDTH = 64;  ///< Minimal width in pixels of a strip when drawing a viewport in strips.
+static const uint VIEWPORT_STRIP_MAX_COUNT = 16; ///< Maximal number of strips to draw a viewport in.
+
 static void MarkViewportDirty(const ViewPort *vp, int left, int top, int right, int bottom);
 
 static ViewportDrawer _vd;
+static ViewportStrip _vp_strips[VIEWPORT_STRIP_MAX_COUNT];
 
 TileHighlightData _thd;
 static TileInfo *_cur_ti;
@@ -1280,6 +1303,28 @@ void ViewportSign::MarkDirty(ZoomLevel maxzoom) const
 	}
 }
 
+/**
+ * Load the tile and child sprites that are about to be drawn into the sprite
+ * cache in one go, so the cache misses of a frame are decoded concurrently
+ * instead of one by one while drawing. Parent sprites need not be prefetched;
+ * their bounding boxes have been determined from the cached sprite already.
+ */
+static void ViewportPrefetchSprites()
+{
+	_vd.sprites_to_prefetch.Clear();
+
+	const TileSpriteToDraw *tsend = _vd.tile_sprites_to_draw.End();
+	for (const TileSpriteToDraw *ts = _vd.tile_sprites_to_draw.Begin(); ts != tsend; ++ts) {
+		*_vd.sprites_to_prefetch.Append() = ts->image;
+	}
+	const ChildScreenSpriteToDraw *csend = _vd.child_screen_sprites_to_draw.End();
+	for (const ChildScreenSpriteToDraw *cs = _vd.child_screen_sprites_to_draw.Begin(); cs != csend; ++cs) {
+		*_vd.sprites_to_prefetch.Append() = cs->image;
+	}
+
+	PrefetchSprites(_vd.sprites_to_prefetch.Begin(), _vd.sprites_to_prefetch.Length());
+}
+
 static void ViewportDrawTileSprites(const TileSpriteToDrawVector *tstdv)
 {
 	const TileSpriteToDraw *tsend = tstdv->End();
@@ -1362,6 +1407,157 @@ static void ViewportDrawParentSprites(const ParentSpriteToSortVector *psd, const
 	}
 }
 
+/**
+ * Look up all collected sprites in the sprite cache, so they can be drawn
+ * without touching the cache. Also determine the horizontal extent of each
+ * parent sprite including its children.
+ * @return False if sprites were evicted from the cache meanwhile, i.e. if not all sprites fit in it at once.
+ */
+static bool ViewportResolveSprites()
+{
+	uint generation = GetSpriteCacheGeneration();
+
+	const TileSpriteToDraw *tsend = _vd.tile_sprites_to_draw.End();
+	for (TileSpriteToDraw *ts = _vd.tile_sprites_to_draw.Begin(); ts != tsend; ++ts) {
+		ts->sprite = ResolveSpriteViewport(ts->image, ts->pal, &ts->remap);
+	}
+	const ChildScreenSpriteToDraw *csend = _vd.child_screen_sprites_to_draw.End();
+	for (ChildScreenSpriteToDraw *cs = _vd.child_screen_sprites_to_draw.Begin(); cs != csend; ++cs) {
+		cs->sprite = ResolveSpriteViewport(cs->image, cs->pal, &cs->remap);
+	}
+
+	const ParentSpriteToDraw *psd_end = _vd.parent_sprites_to_draw.End();
+	for (ParentSpriteToDraw *ps = _vd.parent_sprites_to_draw.Begin(); ps != psd_end; ps++) {
+		if (ps->image == SPR_EMPTY_BOUNDING_BOX) {
+			ps->sprite = NULL;
+			ps->remap = NULL;
+			ps->extent_left = INT32_MAX;
+			ps->extent_right = INT32_MIN;
+		} else {
+			ps->sprite = ResolveSpriteViewport(ps->image, ps->pal, &ps->remap);
+			ps->extent_left = ps->left;
+			ps->extent_right = ps->left + ps->sprite->width;
+		}
+
+		for (int child_idx = ps->first_child; child_idx >= 0;) {
+			const ChildScreenSpriteToDraw *cs = _vd.child_screen_sprites_to_draw.Get(child_idx);
+			child_idx = cs->next;
+			int32 left = ps->left + cs->x + cs->sprite->x_offs;
+			ps->extent_left = min(ps->extent_left, left);
+			ps->extent_right = max(ps->extent_right, left + cs->sprite->width);
+		}
+	}
+
+	return GetSpriteCacheGeneration() == generation;
+}
+
+/**
+ * Draw the resolved sprites that overlap one strip of the viewport. The
+ * sprites have been handed to the strip by ViewportDrawStrips, so strips
+ * can be drawn concurrently.
+ * @param data  The strips.
+ * @param index The strip to draw.
+ */
+static void ViewportDrawStrip(void *data, uint index)
+{
+	const ViewportStrip *strip = (const ViewportStrip *)data + index;
+	const DrawPixelInfo *dpi = &strip->dpi;
+
+	const TileSpriteToDraw * const *tsend = strip->tile_sprites.End();
+	for (const TileSpriteToDraw * const *it = strip->tile_sprites.Begin(); it != tsend; ++it) {
+		const TileSpriteToDraw *ts = *it;
+		DrawResolvedSpriteViewport(dpi, ts->image, ts->sprite, ts->remap, ts->x, ts->y, ts->sub);
+	}
+
+	const ParentSpriteToDraw * const *psend = strip->parent_sprites.End();
+	for (const ParentSpriteToDraw * const *it = strip->parent_sprites.Begin(); it != psend; ++it) {
+		const ParentSpriteToDraw *ps = *it;
+		if (ps->sprite != NULL) DrawResolvedSpriteViewport(dpi, ps->image, ps->sprite, ps->remap, ps->x, ps->y, ps->sub);
+
+		int child_idx = ps->first_child;
+		while (child_idx >= 0) {
+			const ChildScreenSpriteToDraw *cs = _vd.child_screen_sprites_to_draw.Get(child_idx);
+			child_idx = cs->next;
+			DrawResolvedSpriteViewport(dpi, cs->image, cs->sprite, cs->remap, ps->left + cs->x, ps->top + cs->y, cs->sub);
+		}
+	}
+}
+
+/**
+ * Hand a sprite to the strips it overlaps.
+ * @param vector Member of #ViewportStrip to add the sprite to.
+ * @param sprite The sprite.
+ * @param left   Left edge of the sprite.
+ * @param right  Right edge of the sprite, exclusive.
+ * @param count  The number of strips.
+ */
+template <typename T>
+static void AddToViewportStrips(SmallVector<const T *, 64> ViewportStrip::*vector, const T *sprite, int left, int right, uint count)
+{
+	for (uint i = 0; i < count; i++) {
+		ViewportStrip *strip = &_vp_strips[i];
+		if (strip->dpi.left >= right) break;
+		if (strip->dpi.left + strip->dpi.width <= left) continue;
+		*(strip->*vector).Append() = sprite;
+	}
+}
+
+/**
+ * Draw the collected tile, parent and child sprites by splitting the viewport
+ * into vertical strips, which are drawn concurrently by the game's worker threads.
+ * The parent sprites are sorted for the whole viewport at once, so sprites
+ * overlapping several strips are drawn in the same order in all of them.
+ * @return False if the sprites could not be drawn in strips, and have to be drawn as a whole instead.
+ */
+static bool ViewportDrawStrips()
+{
+	/* These debugging aids need to see all sprites of the viewport at once. */
+	if (_draw_bounding_boxes || _newgrf_debug_sprite_picker.mode == SPM_REDRAW) return false;
+
+	WorkerPool *pool = GetGameWorkerPool();
+	int width = UnScaleByZoom(_vd.dpi.width, _vd.dpi.zoom);
+	uint count = min<uint>(min(pool->GetWorkerCount() + 1, VIEWPORT_STRIP_MAX_COUNT), width / VIEWPORT_STRIP_MIN_WIDTH);
+	if (count < 2) return false;
+
+	if (!ViewportResolveSprites()) return false;
+
+	Blitter *blitter = BlitterFactoryBase::GetCurrentBlitter();
+	for (uint i = 0; i < count; i++) {
+		int strip_left  = width * i / count;
+		int strip_right = width * (i + 1) / count;
+
+		DrawPixelInfo *dpi = &_vp_strips[i].dpi;
+		*dpi = _vd.dpi;
+		dpi->left += ScaleByZoom(strip_left, _vd.dpi.zoom);
+		dpi->width = ScaleByZoom(strip_right - strip_left, _vd.dpi.zoom);
+		dpi->dst_ptr = blitter->MoveTo(_vd.dpi.dst_ptr, strip_left, 0);
+
+		_vp_strips[i].tile_sprites.Clear();
+		_vp_strips[i].parent_sprites.Clear();
+	}
+
+	const TileSpriteToDraw *tsend = _vd.tile_sprites_to_draw.End();
+	for (const TileSpriteToDraw *ts = _vd.tile_sprites_to_draw.Begin(); ts != tsend; ++ts) {
+		int left = ts->x + ts->sprite->x_offs;
+		AddToViewportStrips(&ViewportStrip::tile_sprites, ts, left, left + ts->sprite->width, count);
+	}
+
+	ParentSpriteToDraw *psd_end = _vd.parent_sprites_to_draw.End();
+	for (ParentSpriteToDraw *it = _vd.parent_sprites_to_draw.Begin(); it != psd_end; it++) {
+		*_vd.parent_sprites_to_sort.Append() = it;
+	}
+	ViewportSortParentSprites(&_vd.parent_sprites_to_sort);
+
+	const ParentSpriteToDraw * const *pss_end = _vd.parent_sprites_to_sort.End();
+	for (const ParentSpriteToDraw * const *it = _vd.parent_sprites_to_sort.Begin(); it != pss_end; it++) {
+		const ParentSpriteToDraw *ps = *it;
+		AddToViewportStrips(&ViewportStrip::parent_sprites, ps, ps->extent_left, ps->extent_right, count);
+	}
+
+	pool->ParallelFor(&ViewportDrawStrip, _vp_strips, count);
+	return true;
+}
+
 /**
  * Draws the bounding boxes of all ParentSprites
  * @param psd Array of ParentSprites
@@ -1473,15 +1669,19 @@ void ViewportDoDraw(const ViewPort *vp, int left, int top, int right, int bottom
 
 	DrawTextEffects(&_vd.dpi);
 
-	if (_vd.tile_sprites_to_draw.Length() != 0) ViewportDrawTileSprites(&_vd.tile_sprites_to_draw);
+	ViewportPrefetchSprites();
 
-	ParentSpriteToDraw *psd_end = _vd.parent_sprites_to_draw.End();
-	for (ParentSpriteToDraw *it = _vd.parent_sprites_to_draw.Begin(); it != psd_end; it++) {
-		*_vd.parent_sprites_to_sort.Append() = it;
-	}
+	if (!ViewportDrawStrips()) {
+		if (_vd.tile_sprites_to_draw.Length() != 0) ViewportDrawTileSprites(&_vd.tile_sprites_to_draw);
 
-	ViewportSortParentSprites(&_vd.parent_sprites_to_sort);
-	ViewportDrawParentSprites(&_vd.parent_sprites_to_sort, &_vd.child_screen_sprites_to_draw);
+		ParentSpriteToDraw *psd_end = _vd.parent_sprites_to_draw.End();
+		for (ParentSpriteToDraw *it = _vd.parent_sprites_to_draw.Begin(); it != psd_end; it++) {
+			*_vd.parent_sprites_to_sort.Append() = it;
+		}
+
+		ViewportSortParentSprites(&_vd.parent_sprites_to_sort);
+		ViewportDrawParentSprites(&_vd.parent_sprites_to_sort, &_vd.child_screen_sprites_to_draw);
+	}
 
 	if (_draw_bounding_boxes) ViewportDrawBoundingBoxes(&_vd.parent_sprites_to_sort);
 	if (_draw_dirty_blocks) ViewportDrawDirtyBlocks();
@@ -36,6 +36,7 @@
 #include "error.h"
 #include "game/game.hpp"
 #include "video/video_driver.hpp"
+#include "tick_profiler.h"
 
 /** Values for _settings_client.gui.auto_scrolling */
 enum ViewportAutoscrolling {
@@ -3171,6 +3172,8 @@ void InvalidateWindowClassesData(WindowClass cls, int data, bool gui_scope)
  */
 void CallWindowTickEvent()
 {
+	TickPhaseTimer timer(TPH_WINDOWS);
+
 	Window *w;
 	FOR_ALL_WINDOWS_FROM_FRONT(w) {
 		w->OnTick();